@@ -0,0 +1,170 @@
+#include "BreedKernel.h"
+
+namespace
+{
+    // SplitMix64, seeded from the stream: the low bits of its 32-bit LCG are too regular to be used as masks.
+    struct FMaskGenerator
+    {
+        uint64 State;
+
+        explicit FMaskGenerator(FRandomStream& RandomStream)
+            : State((static_cast<uint64>(RandomStream.GetUnsignedInt()) << 32) | RandomStream.GetUnsignedInt())
+        {
+        }
+
+        uint64 Next()
+        {
+            uint64 Z = (State += 0x9E3779B97F4A7C15ull);
+            Z = (Z ^ (Z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            Z = (Z ^ (Z >> 27)) * 0x94D049BB133111EBull;
+            return Z ^ (Z >> 31);
+        }
+
+        // Every bit set with probability Threshold / 256. Each bit of the threshold, least significant first,
+        // ORs (1) or ANDs (0) a fresh word into the mask, which halves the distance to 1 or to 0.
+        uint64 NextBiased(uint32 Threshold)
+        {
+            if (Threshold == 0 || Threshold >= 256)
+            {
+                return Threshold == 0 ? 0 : ~0ull;
+            }
+            uint64 Mask = 0;
+            for (uint32 Bit = FMath::CountTrailingZeros(Threshold); Bit < 8; Bit++)
+            {
+                const uint64 Word = Next();
+                Mask = (Threshold >> Bit) & 1 ? Mask | Word : Mask & Word;
+            }
+            return Mask;
+        }
+    };
+
+    // Select masks of the 16 combinations of 4 mask bits: bit K takes lane K from the first parent.
+    struct FLaneMasks
+    {
+        VectorRegister4Float Masks[16];
+
+        FLaneMasks()
+        {
+            for (uint32 Bits = 0; Bits < 16; Bits++)
+            {
+                Masks[Bits] = MakeVectorRegister(Bits & 1 ? ~0u : 0u, Bits & 2 ? ~0u : 0u, Bits & 4 ? ~0u : 0u, Bits & 8 ? ~0u : 0u);
+            }
+        }
+    };
+    const FLaneMasks LaneMasks;
+
+    void UniformChunk(const float* A, const float* B, float* Child, int32 Count, uint64 Mask)
+    {
+        int32 i = 0;
+        for (; i + 4 <= Count; i += 4, Mask >>= 4)
+        {
+            VectorStore(VectorSelect(LaneMasks.Masks[Mask & 15], VectorLoad(A + i), VectorLoad(B + i)), Child + i);
+        }
+        for (; i < Count; i++, Mask >>= 1)
+        {
+            Child[i] = Mask & 1 ? A[i] : B[i];
+        }
+    }
+
+    // Child = B + Alpha * (A - B)
+    void BlendChunk(const float* A, const float* B, float* Child, int32 Count, float Alpha)
+    {
+        const VectorRegister4Float AlphaVector = VectorSetFloat1(Alpha);
+        int32 i = 0;
+        for (; i + 4 <= Count; i += 4)
+        {
+            const VectorRegister4Float VectorB = VectorLoad(B + i);
+            VectorStore(VectorMultiplyAdd(VectorSubtract(VectorLoad(A + i), VectorB), AlphaVector, VectorB), Child + i);
+        }
+        for (; i < Count; i++)
+        {
+            Child[i] = B[i] + Alpha * (A[i] - B[i]);
+        }
+    }
+
+    // A run of weights taken from one parent, up to the start of the next segment.
+    struct FSegment
+    {
+        int32 Start;
+        bool bFromA;
+    };
+
+    // Copies Child[Start, End) segment by segment. Segment is the cursor of the segment containing Start.
+    void SegmentsChunk(const float* A, const float* B, float* Child, int32 Start, int32 End, TConstArrayView<FSegment> Segments, int32& Segment)
+    {
+        while (Start < End)
+        {
+            while (Segment + 1 < Segments.Num() && Segments[Segment + 1].Start <= Start)
+            {
+                Segment++;
+            }
+            const int32 SegmentEnd = Segment + 1 < Segments.Num() ? FMath::Min(End, Segments[Segment + 1].Start) : End;
+            FMemory::Memcpy(Child + Start, (Segments[Segment].bFromA ? A : B) + Start, (SegmentEnd - Start) * sizeof(float));
+            Start = SegmentEnd;
+        }
+    }
+}
+
+void FBreedKernel::Breed(TConstArrayView<float> ParentA, TConstArrayView<float> ParentB, TArrayView<float> Child,
+    const FBreedSettings& Settings, float StepSize, FRandomStream& RandomStream)
+{
+    check(ParentA.Num() == Child.Num() && ParentB.Num() == Child.Num());
+    const int32 Num = Child.Num();
+    const float* A = ParentA.GetData();
+    const float* B = ParentB.GetData();
+    float* Out = Child.GetData();
+
+    // Draws that hold for the whole child.
+    TArray<FSegment, TInlineAllocator<16>> Segments;
+    float Alpha = 0.f;
+    switch (Settings.Crossover)
+    {
+    case ECrossoverOperator::SinglePoint:
+        Segments.Add({ 0, true });
+        Segments.Add({ RandomStream.RandRange(0, Num), false });
+        break;
+    case ECrossoverOperator::LayerWise:
+        if (Settings.LayerOffsets.Num() >= 2 && Settings.LayerOffsets.Last() == Num)
+        {
+            for (int32 Layer = 0; Layer + 1 < Settings.LayerOffsets.Num(); Layer++)
+            {
+                Segments.Add({ Settings.LayerOffsets[Layer], RandomStream.FRand() < Settings.ProbabilityA });
+            }
+        }
+        else
+        {
+            // Unknown layout: the whole genome is one layer.
+            Segments.Add({ 0, RandomStream.FRand() < Settings.ProbabilityA });
+        }
+        break;
+    case ECrossoverOperator::Arithmetic:
+        Alpha = RandomStream.GetFraction();
+        break;
+    default:
+        break;
+    }
+
+    const bool bUniform = Settings.Crossover == ECrossoverOperator::Uniform;
+    FMaskGenerator MaskGenerator(RandomStream);
+    const uint32 Threshold = static_cast<uint32>(FMath::Clamp(FMath::RoundToInt32(Settings.ProbabilityA * 256.f), 0, 256));
+
+    FSparseMutator Mutator(Settings.MutationRate, Settings.Mutation, StepSize, RandomStream);
+    int32 Segment = 0;
+    for (int32 Start = 0; Start < Num; Start += ChunkSize)
+    {
+        const int32 Count = FMath::Min(ChunkSize, Num - Start);
+        if (bUniform)
+        {
+            UniformChunk(A + Start, B + Start, Out + Start, Count, MaskGenerator.NextBiased(Threshold));
+        }
+        else if (Settings.Crossover == ECrossoverOperator::Arithmetic)
+        {
+            BlendChunk(A + Start, B + Start, Out + Start, Count, Alpha);
+        }
+        else
+        {
+            SegmentsChunk(A, B, Out, Start, Start + Count, Segments, Segment);
+        }
+        Mutator.Apply(Child.Slice(Start, Count));
+    }
+}
@@ -0,0 +1,92 @@
+#include "ChampionSnapshot.h"
+#include "NeuralNetwork.h"
+
+FChampionSnapshot::FChampionSnapshot(const TArray<int32>& InLayerSizes, bool bInRecurrent)
+    : LayerSizes(InLayerSizes)
+    , bRecurrent(bInRecurrent)
+{
+    int32 NumWeights = 0;
+    for (int32 i = 0; i + 1 < LayerSizes.Num(); i++)
+    {
+        // Same layout as UNeuralNetwork::GetNumWeights: recurrent hidden layers also weigh their previous outputs.
+        const bool bRecurrentLayer = bRecurrent && i + 2 < LayerSizes.Num();
+        NumWeights += (LayerSizes[i] + (bRecurrentLayer ? LayerSizes[i + 1] : 0)) * LayerSizes[i + 1];
+    }
+    for (FBuffer& Buffer : Buffers)
+    {
+        Buffer.Weights.SetNumZeroed(NumWeights);
+    }
+}
+
+bool FChampionSnapshot::Publish(const UNeuralNetwork& Network, float Fitness, int32 Generation)
+{
+    if (!Network.HasTopology(LayerSizes, bRecurrent) || Network.GetNumWeights() != Buffers[0].Weights.Num())
+    {
+        UE_LOG(LogTemp, Error, TEXT("Champion snapshot: the network does not have the snapshot's layout"));
+        return false;
+    }
+
+    // Readers are directed to the current version's buffer; the other one is written.
+    const uint32 Version = PublishedVersion.load(std::memory_order_relaxed) + 1;
+    FBuffer& Buffer = Buffers[Version % 2];
+
+    const uint32 Sequence = Buffer.Sequence.load(std::memory_order_relaxed);
+    Buffer.Sequence.store(Sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Row by row into the preallocated buffer: it must never move while readers may copy it.
+    float* Destination = Buffer.Weights.GetData();
+    for (const TArray<TArray<float>>& Layer : Network.Weights)
+    {
+        for (const TArray<float>& Row : Layer)
+        {
+            FMemory::Memcpy(Destination, Row.GetData(), Row.Num() * sizeof(float));
+            Destination += Row.Num();
+        }
+    }
+    Buffer.Fitness = Fitness;
+    Buffer.Generation = Generation;
+
+    Buffer.Sequence.store(Sequence + 2, std::memory_order_release);
+    PublishedVersion.store(Version, std::memory_order_release);
+    return true;
+}
+
+bool FChampionSnapshot::TryRead(uint32& InOutVersion, TArray<float>& OutWeights, float* OutFitness, int32* OutGeneration) const
+{
+    const uint32 Version = PublishedVersion.load(std::memory_order_acquire);
+    if (Version == 0 || Version == InOutVersion)
+    {
+        return false;
+    }
+
+    const FBuffer& Buffer = Buffers[Version % 2];
+    const uint32 Sequence = Buffer.Sequence.load(std::memory_order_acquire);
+    if (Sequence % 2 == 1)
+    {
+        return false;
+    }
+
+    OutWeights.SetNumUninitialized(Buffer.Weights.Num(), EAllowShrinking::No);
+    FMemory::Memcpy(OutWeights.GetData(), Buffer.Weights.GetData(), Buffer.Weights.Num() * sizeof(float));
+    const float Fitness = Buffer.Fitness;
+    const int32 Generation = Buffer.Generation;
+
+    // The copy is valid only if the writer did not start rewriting this buffer in the meantime.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (Buffer.Sequence.load(std::memory_order_relaxed) != Sequence)
+    {
+        return false;
+    }
+
+    InOutVersion = Version;
+    if (OutFitness)
+    {
+        *OutFitness = Fitness;
+    }
+    if (OutGeneration)
+    {
+        *OutGeneration = Generation;
+    }
+    return true;
+}
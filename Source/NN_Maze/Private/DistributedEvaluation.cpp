@@ -0,0 +1,629 @@
+#include "DistributedEvaluation.h"
+#include "NeuralNetwork.h"
+#include "Common/TcpSocketBuilder.h"
+#include "HAL/RunnableThread.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+namespace
+{
+    // Upper bound for a single frame; anything larger means the stream is corrupted.
+    constexpr uint32 MaxFrameSize = 256 * 1024 * 1024;
+
+    void DestroySocket(FSocket* Socket)
+    {
+        if (Socket)
+        {
+            Socket->Close();
+            ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+        }
+    }
+
+    void AppendFrame(TArray<uint8>& OutBuffer, EEvaluationMessage Type, const TArray<uint8>& Body)
+    {
+        const uint32 FrameSize = Body.Num() + 1;
+        OutBuffer.Reserve(OutBuffer.Num() + sizeof(uint32) + FrameSize);
+        OutBuffer.Append(reinterpret_cast<const uint8*>(&FrameSize), sizeof(uint32));
+        OutBuffer.Add(static_cast<uint8>(Type));
+        OutBuffer.Append(Body);
+    }
+}
+
+// --- FEvaluationConnection ---
+
+FEvaluationConnection::FEvaluationConnection(FSocket* InSocket)
+    : Socket(InSocket)
+    , SendOffset(0)
+    , bConnected(InSocket != nullptr)
+{
+}
+
+FEvaluationConnection::~FEvaluationConnection()
+{
+    DestroySocket(Socket);
+}
+
+bool FEvaluationConnection::Send(EEvaluationMessage Type, const TArray<uint8>& Body)
+{
+    if (!bConnected)
+    {
+        return false;
+    }
+
+    TArray<uint8> Frame;
+    AppendFrame(Frame, Type, Body);
+
+    int32 Offset = 0;
+    while (Offset < Frame.Num())
+    {
+        int32 BytesSent = 0;
+        if (!Socket->Send(Frame.GetData() + Offset, Frame.Num() - Offset, BytesSent))
+        {
+            bConnected = false;
+            return false;
+        }
+        Offset += BytesSent;
+    }
+    return true;
+}
+
+void FEvaluationConnection::QueueSend(EEvaluationMessage Type, const TArray<uint8>& Body)
+{
+    if (bConnected)
+    {
+        AppendFrame(SendBuffer, Type, Body);
+    }
+}
+
+bool FEvaluationConnection::FlushSends()
+{
+    while (bConnected && SendOffset < SendBuffer.Num())
+    {
+        int32 BytesSent = 0;
+        if (!Socket->Send(SendBuffer.GetData() + SendOffset, SendBuffer.Num() - SendOffset, BytesSent))
+        {
+            // A full send buffer is not an error: the rest goes out on a later flush.
+            if (ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() != SE_EWOULDBLOCK)
+            {
+                bConnected = false;
+            }
+            break;
+        }
+        if (BytesSent <= 0)
+        {
+            break;
+        }
+        SendOffset += BytesSent;
+    }
+
+    if (SendOffset == SendBuffer.Num() || !bConnected)
+    {
+        SendBuffer.Reset();
+        SendOffset = 0;
+    }
+    return bConnected;
+}
+
+void FEvaluationConnection::ReadAvailableData()
+{
+    uint32 PendingSize = 0;
+    while (Socket->HasPendingData(PendingSize) && PendingSize > 0)
+    {
+        const int32 Offset = ReceiveBuffer.Num();
+        ReceiveBuffer.AddUninitialized(PendingSize);
+
+        int32 BytesRead = 0;
+        if (!Socket->Recv(ReceiveBuffer.GetData() + Offset, PendingSize, BytesRead))
+        {
+            ReceiveBuffer.SetNum(Offset);
+            bConnected = false;
+            return;
+        }
+        ReceiveBuffer.SetNum(Offset + BytesRead);
+    }
+
+    // No pending data looks the same whether the peer is idle or gone; ask the socket which one it is.
+    if (Socket->GetConnectionState() != SCS_Connected)
+    {
+        bConnected = false;
+    }
+}
+
+bool FEvaluationConnection::Receive(EEvaluationMessage& OutType, TArray<uint8>& OutBody)
+{
+    if (bConnected)
+    {
+        ReadAvailableData();
+    }
+
+    if (ReceiveBuffer.Num() < static_cast<int32>(sizeof(uint32)))
+    {
+        return false;
+    }
+
+    uint32 FrameSize = 0;
+    FMemory::Memcpy(&FrameSize, ReceiveBuffer.GetData(), sizeof(uint32));
+    if (FrameSize == 0 || FrameSize > MaxFrameSize)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Corrupted evaluation stream (frame size %u), dropping the connection."), FrameSize);
+        ReceiveBuffer.Empty();
+        bConnected = false;
+        return false;
+    }
+
+    const int32 TotalSize = sizeof(uint32) + FrameSize;
+    if (ReceiveBuffer.Num() < TotalSize)
+    {
+        return false;
+    }
+
+    OutType = static_cast<EEvaluationMessage>(ReceiveBuffer[sizeof(uint32)]);
+    OutBody.Reset(FrameSize - 1);
+    OutBody.Append(ReceiveBuffer.GetData() + sizeof(uint32) + 1, FrameSize - 1);
+    ReceiveBuffer.RemoveAt(0, TotalSize);
+    return true;
+}
+
+// --- FEvaluationCoordinator ---
+
+FEvaluationCoordinator::FEvaluationCoordinator()
+    : BatchTimeoutSeconds(60.f)
+    , StragglerSeconds(20.f)
+    , MaxBatchRetries(3)
+    , MaxSpeculativeCopies(1)
+    , ListenSocket(nullptr)
+    , Thread(nullptr)
+    , CurrentGenerationId(INDEX_NONE)
+    , NextBatchId(0)
+    , RemainingGenomes(0)
+{
+}
+
+FEvaluationCoordinator::~FEvaluationCoordinator()
+{
+    Shutdown();
+}
+
+bool FEvaluationCoordinator::Start(int32 Port)
+{
+    ListenSocket = FTcpSocketBuilder(TEXT("NNMazeCoordinator"))
+        .AsReusable()
+        .AsNonBlocking()
+        .BoundToPort(Port)
+        .Listening(64)
+        .Build();
+
+    if (!ListenSocket)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Evaluation coordinator failed to listen on port %d"), Port);
+        return false;
+    }
+
+    bStopping = false;
+    Thread = FRunnableThread::Create(this, TEXT("NNMazeEvaluationCoordinator"));
+    UE_LOG(LogTemp, Log, TEXT("Evaluation coordinator listening on port %d"), Port);
+    return Thread != nullptr;
+}
+
+void FEvaluationCoordinator::Shutdown()
+{
+    if (Thread)
+    {
+        Stop();
+        Thread->WaitForCompletion();
+        delete Thread;
+        Thread = nullptr;
+    }
+
+    FScopeLock Lock(&Mutex);
+    for (FWorkerState& Worker : Workers)
+    {
+        // Best effort: a worker that does not get the message exits when its connection closes.
+        Worker.Connection->QueueSend(EEvaluationMessage::Shutdown, TArray<uint8>());
+        Worker.Connection->FlushSends();
+    }
+    Workers.Empty();
+
+    DestroySocket(ListenSocket);
+    ListenSocket = nullptr;
+}
+
+void FEvaluationCoordinator::SubmitGeneration(int32 GenerationId, const TArray<UNeuralNetwork*>& Genomes, int32 BatchSize)
+{
+    BatchSize = FMath::Max(1, BatchSize);
+
+    // Serialize outside the lock; this is the expensive part.
+    TArray<FScheduledBatch> NewBatches;
+    for (int32 First = 0; First < Genomes.Num(); First += BatchSize)
+    {
+        FGenomeBatch Batch;
+        Batch.GenerationId = GenerationId;
+        for (int32 Slot = First; Slot < FMath::Min(First + BatchSize, Genomes.Num()); Slot++)
+        {
+            FGenomePayload& Payload = Batch.Genomes.AddDefaulted_GetRef();
+            Payload.Slot = Slot;
+            Payload.LayerSizes = Genomes[Slot]->LayerSizes;
+            Payload.bRecurrent = Genomes[Slot]->bRecurrent;
+            Genomes[Slot]->FlattenWeights(Payload.Weights);
+        }
+
+        FScheduledBatch& Scheduled = NewBatches.AddDefaulted_GetRef();
+        for (const FGenomePayload& Payload : Batch.Genomes)
+        {
+            Scheduled.Slots.Add(Payload.Slot);
+        }
+
+        // Batch ids are assigned under the lock below and patched into the serialized body.
+        FMemoryWriter Writer(Scheduled.Body);
+        Writer << Batch;
+    }
+
+    FScopeLock Lock(&Mutex);
+    CurrentGenerationId = GenerationId;
+    Batches = MoveTemp(NewBatches);
+    BatchQueue.Reset();
+    for (int32 BatchIndex = 0; BatchIndex < Batches.Num(); BatchIndex++)
+    {
+        FScheduledBatch& Batch = Batches[BatchIndex];
+        Batch.BatchId = NextBatchId++;
+        Batch.bQueued = true;
+        // BatchId is the first serialized field.
+        FMemory::Memcpy(Batch.Body.GetData(), &Batch.BatchId, sizeof(int32));
+        BatchQueue.Add(BatchIndex);
+    }
+
+    GenerationFitness.Init(0.f, Genomes.Num());
+    GenerationHasFitness.Init(false, Genomes.Num());
+    FailedSlots.Reset();
+    RemainingGenomes = Genomes.Num();
+}
+
+bool FEvaluationCoordinator::TryGetResults(int32 GenerationId, TArray<float>& OutFitness)
+{
+    FScopeLock Lock(&Mutex);
+    if (GenerationId != CurrentGenerationId || RemainingGenomes > 0)
+    {
+        return false;
+    }
+
+    // Genomes whose batch kept failing get the worst fitness of the generation.
+    if (FailedSlots.Num() > 0)
+    {
+        float WorstFitness = MAX_flt;
+        for (int32 Slot = 0; Slot < GenerationFitness.Num(); Slot++)
+        {
+            if (GenerationHasFitness[Slot])
+            {
+                WorstFitness = FMath::Min(WorstFitness, GenerationFitness[Slot]);
+            }
+        }
+        WorstFitness = WorstFitness == MAX_flt ? 0.f : WorstFitness;
+        for (const int32 Slot : FailedSlots)
+        {
+            GenerationFitness[Slot] = WorstFitness;
+        }
+        UE_LOG(LogTemp, Warning, TEXT("%d genomes could not be evaluated by any worker"), FailedSlots.Num());
+    }
+
+    OutFitness = GenerationFitness;
+    return true;
+}
+
+int32 FEvaluationCoordinator::GetNumWorkers() const
+{
+    FScopeLock Lock(&Mutex);
+    return Workers.Num();
+}
+
+uint32 FEvaluationCoordinator::Run()
+{
+    TArray<FEvaluationConnection*> PendingSends;
+    while (!bStopping)
+    {
+        PendingSends.Reset();
+        {
+            FScopeLock Lock(&Mutex);
+            const double Now = FPlatformTime::Seconds();
+            AcceptConnections();
+            ReceiveMessages();
+            CheckTimeouts(Now);
+            DispatchWork(Now);
+            for (FWorkerState& Worker : Workers)
+            {
+                if (Worker.Connection->HasPendingSends())
+                {
+                    PendingSends.Add(Worker.Connection.Get());
+                }
+            }
+        }
+
+        // Frames are written outside the lock and never block: a worker that stops reading only keeps its own
+        // queue full until it times out. The connections stay valid, workers are only removed by this thread.
+        for (FEvaluationConnection* Connection : PendingSends)
+        {
+            Connection->FlushSends();
+        }
+        FPlatformProcess::Sleep(0.001f);
+    }
+    return 0;
+}
+
+void FEvaluationCoordinator::Stop()
+{
+    bStopping = true;
+}
+
+void FEvaluationCoordinator::AcceptConnections()
+{
+    bool bHasPendingConnection = false;
+    while (ListenSocket->HasPendingConnection(bHasPendingConnection) && bHasPendingConnection)
+    {
+        FSocket* WorkerSocket = ListenSocket->Accept(TEXT("NNMazeWorkerConnection"));
+        if (!WorkerSocket)
+        {
+            break;
+        }
+
+        // Sends are queued and flushed without blocking; receives are polled with HasPendingData.
+        WorkerSocket->SetNonBlocking(true);
+        FWorkerState& Worker = Workers.AddDefaulted_GetRef();
+        Worker.Connection = MakeUnique<FEvaluationConnection>(WorkerSocket);
+        UE_LOG(LogTemp, Log, TEXT("Evaluation worker connected (%d workers)"), Workers.Num());
+    }
+}
+
+void FEvaluationCoordinator::ReceiveMessages()
+{
+    EEvaluationMessage Type;
+    TArray<uint8> Body;
+    for (int32 WorkerIndex = Workers.Num() - 1; WorkerIndex >= 0; WorkerIndex--)
+    {
+        FWorkerState& Worker = Workers[WorkerIndex];
+        while (Worker.Connection->Receive(Type, Body))
+        {
+            if (Type == EEvaluationMessage::Hello)
+            {
+                Worker.bReady = true;
+            }
+            else if (Type == EEvaluationMessage::Result)
+            {
+                FBatchResult Result;
+                FMemoryReader Reader(Body);
+                Reader << Result;
+                HandleResult(Worker, Result);
+            }
+        }
+
+        if (!Worker.Connection->IsConnected())
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Evaluation worker disconnected after %d batches"), Worker.CompletedBatches);
+            ReleaseAssignment(Worker, true);
+            Workers.RemoveAt(WorkerIndex);
+        }
+    }
+}
+
+void FEvaluationCoordinator::CheckTimeouts(double Now)
+{
+    for (int32 WorkerIndex = Workers.Num() - 1; WorkerIndex >= 0; WorkerIndex--)
+    {
+        FWorkerState& Worker = Workers[WorkerIndex];
+        if (Worker.AssignedBatchId != INDEX_NONE && Now - Worker.AssignedTime > BatchTimeoutSeconds)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Evaluation worker timed out on batch %d, dropping it"), Worker.AssignedBatchId);
+            ReleaseAssignment(Worker, true);
+            Workers.RemoveAt(WorkerIndex);
+        }
+    }
+}
+
+void FEvaluationCoordinator::DispatchWork(double Now)
+{
+    for (FWorkerState& Worker : Workers)
+    {
+        if (!Worker.bReady || Worker.AssignedBatchId != INDEX_NONE)
+        {
+            continue;
+        }
+
+        // Fresh work first.
+        bool bAssigned = false;
+        while (BatchQueue.Num() > 0 && !bAssigned)
+        {
+            FScheduledBatch& Batch = Batches[BatchQueue[0]];
+            BatchQueue.RemoveAt(0);
+            Batch.bQueued = false;
+            if (!Batch.bDone)
+            {
+                bAssigned = AssignBatch(Worker, Batch, Now);
+            }
+        }
+        if (bAssigned)
+        {
+            continue;
+        }
+
+        // Queue is empty: steal the oldest straggling batch.
+        FScheduledBatch* Straggler = nullptr;
+        for (FScheduledBatch& Batch : Batches)
+        {
+            const bool bStraggling = !Batch.bDone && Batch.ActiveAssignments > 0
+                && Batch.ActiveAssignments <= MaxSpeculativeCopies
+                && Now - Batch.FirstDispatchTime > StragglerSeconds;
+            if (bStraggling && (!Straggler || Batch.FirstDispatchTime < Straggler->FirstDispatchTime))
+            {
+                Straggler = &Batch;
+            }
+        }
+        if (Straggler)
+        {
+            AssignBatch(Worker, *Straggler, Now);
+        }
+    }
+}
+
+bool FEvaluationCoordinator::AssignBatch(FWorkerState& Worker, FScheduledBatch& Batch, double Now)
+{
+    // The frame is written by the next flush; a lost connection is noticed here or on the next receive pass.
+    Worker.Connection->QueueSend(EEvaluationMessage::Batch, Batch.Body);
+    if (!Worker.Connection->IsConnected())
+    {
+        // The worker is removed on the next receive pass; put the batch back in front.
+        if (!Batch.bQueued)
+        {
+            Batch.bQueued = true;
+            BatchQueue.Insert(static_cast<int32>(&Batch - Batches.GetData()), 0);
+        }
+        return false;
+    }
+
+    if (Batch.ActiveAssignments == 0)
+    {
+        Batch.FirstDispatchTime = Now;
+    }
+    Batch.ActiveAssignments++;
+    Worker.AssignedBatchId = Batch.BatchId;
+    Worker.AssignedTime = Now;
+    return true;
+}
+
+void FEvaluationCoordinator::HandleResult(FWorkerState& Worker, const FBatchResult& Result)
+{
+    // Results always release the worker, even when they belong to an older generation or a duplicate.
+    if (Worker.AssignedBatchId == Result.BatchId)
+    {
+        ReleaseAssignment(Worker, false);
+    }
+    Worker.CompletedBatches++;
+
+    if (Result.GenerationId != CurrentGenerationId)
+    {
+        return;
+    }
+
+    FScheduledBatch* Batch = FindBatch(Result.BatchId);
+    if (Batch && !Batch->bDone)
+    {
+        CompleteBatch(*Batch, Result.Slots, Result.Fitness);
+    }
+}
+
+void FEvaluationCoordinator::ReleaseAssignment(FWorkerState& Worker, bool bFailed)
+{
+    FScheduledBatch* Batch = FindBatch(Worker.AssignedBatchId);
+    Worker.AssignedBatchId = INDEX_NONE;
+    if (!Batch || Batch->bDone)
+    {
+        return;
+    }
+
+    Batch->ActiveAssignments = FMath::Max(0, Batch->ActiveAssignments - 1);
+    if (!bFailed || Batch->ActiveAssignments > 0 || Batch->bQueued)
+    {
+        return;
+    }
+
+    // Nobody else is working on it: retry, or give up on these genomes.
+    Batch->Attempts++;
+    if (Batch->Attempts <= MaxBatchRetries)
+    {
+        Batch->bQueued = true;
+        BatchQueue.Insert(static_cast<int32>(Batch - Batches.GetData()), 0);
+    }
+    else
+    {
+        UE_LOG(LogTemp, Error, TEXT("Batch %d failed %d times, giving up"), Batch->BatchId, Batch->Attempts);
+        FailedSlots.Append(Batch->Slots);
+        CompleteBatch(*Batch, TArray<int32>(), TArray<float>());
+    }
+}
+
+void FEvaluationCoordinator::CompleteBatch(FScheduledBatch& Batch, const TArray<int32>& Slots, const TArray<float>& Fitness)
+{
+    for (int32 i = 0; i < FMath::Min(Slots.Num(), Fitness.Num()); i++)
+    {
+        if (GenerationFitness.IsValidIndex(Slots[i]))
+        {
+            GenerationFitness[Slots[i]] = Fitness[i];
+            GenerationHasFitness[Slots[i]] = true;
+        }
+    }
+
+    Batch.bDone = true;
+    RemainingGenomes -= Batch.Slots.Num();
+}
+
+FEvaluationCoordinator::FScheduledBatch* FEvaluationCoordinator::FindBatch(int32 BatchId)
+{
+    if (BatchId == INDEX_NONE)
+    {
+        return nullptr;
+    }
+    return Batches.FindByPredicate([BatchId](const FScheduledBatch& Batch) { return Batch.BatchId == BatchId; });
+}
+
+// --- FEvaluationWorkerClient ---
+
+bool FEvaluationWorkerClient::Connect(const FString& CoordinatorAddress)
+{
+    FIPv4Endpoint Endpoint;
+    if (!FIPv4Endpoint::Parse(CoordinatorAddress, Endpoint))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Invalid coordinator address '%s' (expected ip:port)"), *CoordinatorAddress);
+        return false;
+    }
+
+    FSocket* Socket = FTcpSocketBuilder(TEXT("NNMazeWorker")).AsBlocking().Build();
+    if (!Socket || !Socket->Connect(*Endpoint.ToInternetAddr()))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Could not connect to evaluation coordinator at %s"), *CoordinatorAddress);
+        DestroySocket(Socket);
+        return false;
+    }
+
+    Connection = MakeUnique<FEvaluationConnection>(Socket);
+    UE_LOG(LogTemp, Log, TEXT("Connected to evaluation coordinator at %s"), *CoordinatorAddress);
+    return Connection->Send(EEvaluationMessage::Hello, TArray<uint8>());
+}
+
+bool FEvaluationWorkerClient::PollBatch(FGenomeBatch& OutBatch)
+{
+    if (!Connection.IsValid())
+    {
+        return false;
+    }
+
+    EEvaluationMessage Type;
+    TArray<uint8> Body;
+    while (Connection->Receive(Type, Body))
+    {
+        if (Type == EEvaluationMessage::Shutdown)
+        {
+            bShutdownRequested = true;
+            return false;
+        }
+        if (Type == EEvaluationMessage::Batch)
+        {
+            FMemoryReader Reader(Body);
+            Reader << OutBatch;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FEvaluationWorkerClient::SendResult(FBatchResult& Result)
+{
+    if (!Connection.IsValid())
+    {
+        return false;
+    }
+
+    TArray<uint8> Body;
+    FMemoryWriter Writer(Body);
+    Writer << Result;
+    return Connection->Send(EEvaluationMessage::Result, Body);
+}
@@ -0,0 +1,588 @@
+#include "EvolutionBenchmarkCommandlet.h"
+#include "BreedKernel.h"
+#include "EvolutionManager.h"
+#include "EvolutionStrategyManager.h"
+#include "MazeAgent.h"
+#include "MazeFlowField.h"
+#include "MazeGrid.h"
+#include "MazeSimulation.h"
+#include "NeuralNetwork.h"
+#include "ParetoSort.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/Parse.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectArray.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+    // Synthetic objective: the closer the weights are to the target, the higher the fitness.
+    void EvaluateSyntheticFitness(const TArray<UNeuralNetwork*>& Population, const TArray<float>& Target)
+    {
+        ParallelFor(Population.Num(), [&Population, &Target](int32 Index)
+            {
+                TArray<float> FlatWeights;
+                Population[Index]->FlattenWeights(FlatWeights);
+
+                float SquaredError = 0.f;
+                for (int32 i = 0; i < FlatWeights.Num(); i++)
+                {
+                    const float Delta = FlatWeights[i] - Target[i];
+                    SquaredError += Delta * Delta;
+                }
+                Population[Index]->Fitness = -SquaredError / FMath::Max(1, FlatWeights.Num());
+            });
+    }
+
+    TArray<int32> ParseLayers(const FString& Params)
+    {
+        TArray<int32> Layers = { 8, 16, 16, 8, 2 };
+
+        FString LayersString;
+        if (FParse::Value(*Params, TEXT("Layers="), LayersString, false))
+        {
+            TArray<FString> Parts;
+            LayersString.ParseIntoArray(Parts, TEXT(","), true);
+            Layers.Reset();
+            for (const FString& Part : Parts)
+            {
+                Layers.Add(FMath::Max(1, FCString::Atoi(*Part)));
+            }
+        }
+        return Layers;
+    }
+
+    // Cell centre on the maze plane.
+    FVector2D GetCellCenter(int32 CellX, int32 CellY, float BlockSize)
+    {
+        const FIntPoint Block = FMazeGrid::CellToBlock(CellX, CellY);
+        return FVector2D((Block.X + 0.5f) * BlockSize, (Block.Y + 0.5f) * BlockSize);
+    }
+
+    /**
+     * Evolves agents in a headless maze with each algorithm until one of them passes within a block of the exit
+     * (the far corner cell), and reports the generations and wall time it took.
+     */
+    int32 RunTimeToExit(const FString& Params, const TArray<int32>& Layers, int32 PopulationSize, int32 Seed)
+    {
+        int32 MaxGenerations = 200;
+        int32 MazeCells = 4;
+        float TimeLimit = 20.f;
+        FParse::Value(*Params, TEXT("Generations="), MaxGenerations);
+        FParse::Value(*Params, TEXT("MazeCells="), MazeCells);
+        FParse::Value(*Params, TEXT("TimeLimit="), TimeLimit);
+
+        FString AgentClassPath = TEXT("/Game/Blueprints/BP_MazeAgent.BP_MazeAgent_C");
+        FParse::Value(*Params, TEXT("AgentClass="), AgentClassPath);
+        const UClass* AgentClass = LoadClass<AMazeAgent>(nullptr, *AgentClassPath);
+        const AMazeAgent* AgentDefaults = AgentClass ? AgentClass->GetDefaultObject<AMazeAgent>() : GetDefault<AMazeAgent>();
+
+        FMazeGenerationSettings GridSettings;
+        GridSettings.CellsX = FMath::Max(1, MazeCells);
+        GridSettings.CellsY = FMath::Max(1, MazeCells);
+        GridSettings.Seed = Seed;
+        const FMazeGrid Grid = FMazeGrid::Generate(GridSettings);
+
+        FMazeEvaluationInstance Instance;
+        Instance.Grid = &Grid;
+        Instance.Settings.Agent = FMazeAgentParams::FromAgent(AgentDefaults);
+        Instance.Settings.Agent.bUseExitSensor = true;
+        Instance.Settings.Start = GetCellCenter(0, 0, Instance.Settings.BlockSize);
+        Instance.Settings.Exit = GetCellCenter(GridSettings.CellsX - 1, GridSettings.CellsY - 1, Instance.Settings.BlockSize);
+        Instance.Settings.TimeLimit = TimeLimit;
+
+        // Geodesic exit sensor and progress reward, as in a procedural maze level.
+        FMazeFlowField FlowField;
+        FlowField.Build(Grid, FMazeGrid::CellToBlock(GridSettings.CellsX - 1, GridSettings.CellsY - 1));
+        Instance.Settings.FlowField = &FlowField;
+        // The trajectory, to tell whether the exit was reached at any point of the episode.
+        Instance.Settings.BehaviorDescriptorPoints = FMath::CeilToInt32(TimeLimit * 4.f);
+        const float ExitRadiusSquared = FMath::Square(Instance.Settings.BlockSize);
+
+        const TPair<const TCHAR*, UClass*> Algorithms[] = {
+            { TEXT("GA"), UEvolutionManager::StaticClass() },
+            { TEXT("ES"), UEvolutionStrategyManager::StaticClass() },
+        };
+
+        UE_LOG(LogTemp, Display, TEXT("EvolutionBenchmark: time to exit, %dx%d maze, population %d, at most %d generations"),
+            GridSettings.CellsX, GridSettings.CellsY, PopulationSize, MaxGenerations);
+        UE_LOG(LogTemp, Display, TEXT("%10s %12s %12s %14s"), TEXT("Algorithm"), TEXT("Generations"), TEXT("Seconds"), TEXT("Best fitness"));
+
+        for (const TPair<const TCHAR*, UClass*>& Algorithm : Algorithms)
+        {
+            // Same seed for every algorithm so they start from comparable random networks.
+            FMath::RandInit(Seed);
+
+            UEvolutionManager* Evolution = NewObject<UEvolutionManager>(GetTransientPackage(), Algorithm.Value);
+            TArray<UNeuralNetwork*> CurrentGeneration;
+            TArray<UNeuralNetwork*> NextGeneration;
+            for (int32 i = 0; i < PopulationSize; i++)
+            {
+                UNeuralNetwork* Network = NewObject<UNeuralNetwork>(GetTransientPackage());
+                Evolution->InitializeNetwork(Network, Layers, false);
+                CurrentGeneration.Add(Network);
+            }
+
+            TArray<float> Fitness;
+            TArray<float> Trajectories;
+            const int32 TrajectorySize = 2 * Instance.Settings.BehaviorDescriptorPoints;
+            int32 Generation = 0;
+            bool bReachedExit = false;
+            float BestFitness = -MAX_flt;
+            const double StartTime = FPlatformTime::Seconds();
+            for (; Generation < MaxGenerations && !bReachedExit; Generation++)
+            {
+                FMazeHeadlessSimulator::EvaluateAcrossMazes(MakeArrayView(&Instance, 1), CurrentGeneration, Fitness, &Trajectories);
+                BestFitness = -MAX_flt;
+                for (int32 i = 0; i < CurrentGeneration.Num(); i++)
+                {
+                    CurrentGeneration[i]->Fitness = Fitness[i];
+                    BestFitness = FMath::Max(BestFitness, Fitness[i]);
+                }
+                for (int32 Point = 0; Point < Trajectories.Num() / 2 && !bReachedExit; Point++)
+                {
+                    bReachedExit = FVector2D::DistSquared(FVector2D(Trajectories[2 * Point], Trajectories[2 * Point + 1]), Instance.Settings.Exit) <= ExitRadiusSquared;
+                }
+                if (!bReachedExit)
+                {
+                    float FitnessMean = 0.f;
+                    Evolution->ProcessGeneration(CurrentGeneration, NextGeneration, FitnessMean, PopulationSize);
+                    Swap(CurrentGeneration, NextGeneration);
+                }
+            }
+            const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+            if (bReachedExit)
+            {
+                UE_LOG(LogTemp, Display, TEXT("%10s %12d %12.2f %14.2f"), Algorithm.Key, Generation, Seconds, BestFitness);
+            }
+            else
+            {
+                UE_LOG(LogTemp, Display, TEXT("%10s %12s %12.2f %14.2f"), Algorithm.Key, TEXT("not reached"), Seconds, BestFitness);
+            }
+
+            CurrentGeneration.Empty();
+            NextGeneration.Empty();
+            CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+        }
+        return 0;
+    }
+
+    /**
+     * Breeds -Children flat children of -Weights weights from a pool of random parents with each crossover
+     * operator of the breed kernel, and with the former scalar crossover followed by a separate mutation pass.
+     */
+    int32 RunBreedKernel(const FString& Params, int32 Seed)
+    {
+        int32 NumChildren = 100000;
+        int32 NumWeights = 500;
+        float MutationRate = 5.f;
+        FParse::Value(*Params, TEXT("Children="), NumChildren);
+        FParse::Value(*Params, TEXT("Weights="), NumWeights);
+        FParse::Value(*Params, TEXT("MutationRate="), MutationRate);
+        if (NumChildren < 1 || NumWeights < 1)
+        {
+            UE_LOG(LogTemp, Error, TEXT("EvolutionBenchmark: invalid parameters (Children >= 1, Weights >= 1)."));
+            return 1;
+        }
+
+        FMutationSettings Mutation;
+        Mutation.Operator = FParse::Param(*Params, TEXT("Gaussian")) ? EMutationOperator::Gaussian : EMutationOperator::Reset;
+        const float StepSize = Mutation.Operator == EMutationOperator::Gaussian ? 0.1f : 0.f;
+
+        // A pool of random parents and four layers of equal size for the layer-wise operator.
+        constexpr int32 NumParents = 64;
+        FRandomStream ParentStream(Seed);
+        TArray<float> Parents;
+        Parents.SetNumUninitialized(NumParents * NumWeights);
+        for (float& Weight : Parents)
+        {
+            Weight = ParentStream.FRandRange(-1.f, 1.f);
+        }
+        TArray<int32> LayerOffsets;
+        for (int32 Layer = 0; Layer <= 4; Layer++)
+        {
+            LayerOffsets.Add(NumWeights * Layer / 4);
+        }
+
+        TArray<float> Children;
+        Children.SetNumUninitialized(NumChildren * NumWeights);
+        const int32 NumTasks = FMath::Max(1, FPlatformMisc::NumberOfCoresIncludingHyperthreads()) * 4;
+        const int32 ChildrenPerTask = FMath::DivideAndRoundUp(NumChildren, NumTasks);
+
+        // Runs Body(Parent1, Parent2, Child, RandomStream) for every child, one random stream per task.
+        auto TimeBreeding = [&](auto Body)
+        {
+            const double StartTime = FPlatformTime::Seconds();
+            ParallelFor(TEXT("BreedKernelBenchmark"), NumTasks, 1, [&](int32 Task)
+                {
+                    FRandomStream RandomStream(Seed + Task);
+                    const int32 End = FMath::Min(NumChildren, (Task + 1) * ChildrenPerTask);
+                    for (int32 i = Task * ChildrenPerTask; i < End; i++)
+                    {
+                        const int32 Parent1 = RandomStream.RandRange(0, NumParents - 1);
+                        const int32 Parent2 = RandomStream.RandRange(0, NumParents - 1);
+                        Body(TConstArrayView<float>(Parents).Slice(Parent1 * NumWeights, NumWeights),
+                            TConstArrayView<float>(Parents).Slice(Parent2 * NumWeights, NumWeights),
+                            TArrayView<float>(Children).Slice(i * NumWeights, NumWeights), RandomStream);
+                    }
+                });
+            return (FPlatformTime::Seconds() - StartTime) * 1000.0;
+        };
+
+        UE_LOG(LogTemp, Display, TEXT("EvolutionBenchmark: breeding %d children of %d weights, mutation rate %.1f%%, %s mutation, %d cores"),
+            NumChildren, NumWeights, MutationRate, Mutation.Operator == EMutationOperator::Gaussian ? TEXT("Gaussian") : TEXT("reset"),
+            FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+        UE_LOG(LogTemp, Display, TEXT("%14s %12s %14s"), TEXT("Operator"), TEXT("ms"), TEXT("ns/child"));
+
+        const double ScalarMs = TimeBreeding([MutationRate, &Mutation, StepSize](TConstArrayView<float> A, TConstArrayView<float> B, TArrayView<float> Child, FRandomStream& RandomStream)
+            {
+                for (int32 i = 0; i < Child.Num(); i++)
+                {
+                    Child[i] = RandomStream.FRand() < 0.5f ? A[i] : B[i];
+                }
+                UNeuralNetwork::MutateWeights(Child, MutationRate, RandomStream, Mutation, StepSize);
+            });
+        UE_LOG(LogTemp, Display, TEXT("%14s %12.2f %14.1f"), TEXT("Scalar"), ScalarMs, ScalarMs * 1.0e6 / NumChildren);
+
+        const TPair<const TCHAR*, ECrossoverOperator> Operators[] = {
+            { TEXT("Uniform"), ECrossoverOperator::Uniform },
+            { TEXT("SinglePoint"), ECrossoverOperator::SinglePoint },
+            { TEXT("Arithmetic"), ECrossoverOperator::Arithmetic },
+            { TEXT("LayerWise"), ECrossoverOperator::LayerWise },
+        };
+        for (const TPair<const TCHAR*, ECrossoverOperator>& Operator : Operators)
+        {
+            FBreedSettings Settings;
+            Settings.Crossover = Operator.Value;
+            Settings.LayerOffsets = LayerOffsets;
+            Settings.MutationRate = MutationRate;
+            Settings.Mutation = Mutation;
+            const double KernelMs = TimeBreeding([&Settings, StepSize](TConstArrayView<float> A, TConstArrayView<float> B, TArrayView<float> Child, FRandomStream& RandomStream)
+                {
+                    FBreedKernel::Breed(A, B, Child, Settings, StepSize, RandomStream);
+                });
+            UE_LOG(LogTemp, Display, TEXT("%14s %12.2f %14.1f"), Operator.Key, KernelMs, KernelMs * 1.0e6 / NumChildren);
+        }
+        return 0;
+    }
+
+    // Times the non-dominated sort and the crowding distance of -Points random objective vectors.
+    int32 RunPareto(const FString& Params, int32 Seed)
+    {
+        int32 NumPoints = 50000;
+        int32 MaxObjectives = 4;
+        FParse::Value(*Params, TEXT("Points="), NumPoints);
+        FParse::Value(*Params, TEXT("MaxObjectives="), MaxObjectives);
+        if (NumPoints < 1 || MaxObjectives < 2)
+        {
+            UE_LOG(LogTemp, Error, TEXT("EvolutionBenchmark: invalid parameters (Points >= 1, MaxObjectives >= 2)."));
+            return 1;
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("EvolutionBenchmark: NSGA-II selection of %d points"), NumPoints);
+        UE_LOG(LogTemp, Display, TEXT("%12s %10s %12s %14s"), TEXT("Objectives"), TEXT("Fronts"), TEXT("Sort ms"), TEXT("Crowding ms"));
+
+        for (int32 NumObjectives = 2; NumObjectives <= MaxObjectives; NumObjectives++)
+        {
+            // Objectives share a common "quality" term so that points are mostly ordered, with some trade-offs.
+            FRandomStream RandomStream(Seed);
+            TArray<float> Objectives;
+            Objectives.SetNumUninitialized(NumPoints * NumObjectives);
+            for (int32 Point = 0; Point < NumPoints; Point++)
+            {
+                const float Quality = RandomStream.GetFraction();
+                for (int32 Objective = 0; Objective < NumObjectives; Objective++)
+                {
+                    Objectives[Point * NumObjectives + Objective] = Quality + 0.2f * RandomStream.GetFraction();
+                }
+            }
+
+            TArray<int32> Ranks;
+            TArray<float> Crowding;
+            int32 NumFronts = 0;
+            const double SortStart = FPlatformTime::Seconds();
+            FParetoSort::ComputeFronts(Objectives, NumObjectives, Ranks, NumFronts);
+            const double CrowdingStart = FPlatformTime::Seconds();
+            FParetoSort::ComputeCrowding(Objectives, NumObjectives, Ranks, Crowding);
+            const double End = FPlatformTime::Seconds();
+
+            UE_LOG(LogTemp, Display, TEXT("%12d %10d %12.2f %14.2f"),
+                NumObjectives, NumFronts, (CrowdingStart - SortStart) * 1000.0, (End - CrowdingStart) * 1000.0);
+        }
+        return 0;
+    }
+}
+
+UEvolutionBenchmarkCommandlet::UEvolutionBenchmarkCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UEvolutionBenchmarkCommandlet::Main(const FString& Params)
+{
+    int32 PopulationSize = 2000;
+    int32 Generations = 50;
+    int32 MaxIslands = FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+    int32 MigrationInterval = 5;
+    int32 Seed = 1234;
+    FParse::Value(*Params, TEXT("Population="), PopulationSize);
+    FParse::Value(*Params, TEXT("Generations="), Generations);
+    FParse::Value(*Params, TEXT("MaxIslands="), MaxIslands);
+    FParse::Value(*Params, TEXT("MigrationInterval="), MigrationInterval);
+    FParse::Value(*Params, TEXT("Seed="), Seed);
+    const TArray<int32> Layers = ParseLayers(Params);
+
+    if (PopulationSize < 2 || Generations < 1 || Layers.Num() < 2)
+    {
+        UE_LOG(LogTemp, Error, TEXT("EvolutionBenchmark: invalid parameters (Population >= 2, Generations >= 1, at least two layers)."));
+        return 1;
+    }
+
+    if (FParse::Param(*Params, TEXT("TimeToExit")))
+    {
+        return RunTimeToExit(Params, Layers, PopulationSize, Seed);
+    }
+    if (FParse::Param(*Params, TEXT("BreedKernel")))
+    {
+        return RunBreedKernel(Params, Seed);
+    }
+    if (FParse::Param(*Params, TEXT("Pareto")))
+    {
+        return RunPareto(Params, Seed);
+    }
+    if (FParse::Param(*Params, TEXT("Soak")))
+    {
+        return RunSoak(Params, Layers, Seed);
+    }
+
+    // Island counts to compare: powers of two up to MaxIslands, plus MaxIslands itself.
+    TArray<int32> IslandCounts;
+    for (int32 Count = 1; Count < MaxIslands; Count *= 2)
+    {
+        IslandCounts.Add(Count);
+    }
+    IslandCounts.AddUnique(FMath::Max(1, MaxIslands));
+
+    UE_LOG(LogTemp, Display, TEXT("EvolutionBenchmark: population %d, %d generations, %d cores"),
+        PopulationSize, Generations, FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+    UE_LOG(LogTemp, Display, TEXT("%8s %12s %14s %14s"), TEXT("Islands"), TEXT("Gen/sec"), TEXT("Breed ms/gen"), TEXT("Best fitness"));
+
+    for (const int32 IslandCount : IslandCounts)
+    {
+        // Same seed for every run so island counts are compared on identical starting populations.
+        FMath::RandInit(Seed);
+        FRandomStream TargetStream(Seed);
+
+        UEvolutionManager* Evolution = NewObject<UEvolutionManager>(GetTransientPackage());
+        Evolution->NumIslands = IslandCount;
+        Evolution->MigrationInterval = MigrationInterval;
+
+        TArray<UNeuralNetwork*> CurrentGeneration;
+        TArray<UNeuralNetwork*> NextGeneration;
+        for (int32 i = 0; i < PopulationSize; i++)
+        {
+            UNeuralNetwork* Network = NewObject<UNeuralNetwork>(GetTransientPackage());
+            Network->Initialize(Layers);
+            CurrentGeneration.Add(Network);
+        }
+
+        TArray<float> Target;
+        Target.SetNumUninitialized(CurrentGeneration[0]->GetNumWeights());
+        for (float& Value : Target)
+        {
+            Value = TargetStream.FRandRange(-1.f, 1.f);
+        }
+
+        double BreedSeconds = 0.0;
+        const double StartTime = FPlatformTime::Seconds();
+        for (int32 Generation = 0; Generation < Generations; Generation++)
+        {
+            EvaluateSyntheticFitness(CurrentGeneration, Target);
+
+            float FitnessMean = 0.f;
+            const double BreedStart = FPlatformTime::Seconds();
+            Evolution->ProcessGeneration(CurrentGeneration, NextGeneration, FitnessMean, PopulationSize);
+            BreedSeconds += FPlatformTime::Seconds() - BreedStart;
+
+            Swap(CurrentGeneration, NextGeneration);
+        }
+        const double TotalSeconds = FPlatformTime::Seconds() - StartTime;
+
+        EvaluateSyntheticFitness(CurrentGeneration, Target);
+        float BestFitness = -MAX_flt;
+        for (const UNeuralNetwork* Network : CurrentGeneration)
+        {
+            BestFitness = FMath::Max(BestFitness, Network->Fitness);
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("%8d %12.2f %14.3f %14.4f"),
+            IslandCount, Generations / TotalSeconds, BreedSeconds * 1000.0 / Generations, BestFitness);
+
+        // Release this run's networks before the next island count.
+        CurrentGeneration.Empty();
+        NextGeneration.Empty();
+        CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+    }
+
+    return 0;
+}
+
+int32 UEvolutionBenchmarkCommandlet::RunSoak(const FString& Params, const TArray<int32>& Layers, int32 Seed)
+{
+    int32 PopulationSize = 500;
+    int32 Generations = 10000;
+    int32 GCInterval = 100;
+    int32 MemoryToleranceMB = 32;
+    FParse::Value(*Params, TEXT("Population="), PopulationSize);
+    FParse::Value(*Params, TEXT("Generations="), Generations);
+    FParse::Value(*Params, TEXT("GCInterval="), GCInterval);
+    FParse::Value(*Params, TEXT("MemoryToleranceMB="), MemoryToleranceMB);
+    GCInterval = FMath::Max(1, GCInterval);
+
+    // Generation 0 creates the slots of NextGeneration; from generation 1 on, the two sets of networks alternate.
+    const int32 WarmupGenerations = 1;
+    if (Generations < 2 * GCInterval)
+    {
+        UE_LOG(LogTemp, Error, TEXT("EvolutionBenchmark: the soak run needs at least two collections (Generations >= 2 * GCInterval)."));
+        return 1;
+    }
+
+    FMath::RandInit(Seed);
+    FRandomStream TargetStream(Seed);
+
+    UEvolutionManager* Evolution = NewObject<UEvolutionManager>(GetTransientPackage());
+    TArray<UNeuralNetwork*> CurrentGeneration;
+    TArray<UNeuralNetwork*> NextGeneration;
+    for (int32 i = 0; i < PopulationSize; i++)
+    {
+        UNeuralNetwork* Network = NewObject<UNeuralNetwork>(GetTransientPackage());
+        Network->Initialize(Layers);
+        CurrentGeneration.Add(Network);
+    }
+
+    TArray<float> Target;
+    Target.SetNumUninitialized(CurrentGeneration[0]->GetNumWeights());
+    for (float& Value : Target)
+    {
+        Value = TargetStream.FRandRange(-1.f, 1.f);
+    }
+
+    // Returns the collection time in milliseconds and the number of objects it destroyed.
+    auto CollectSoakGarbage = [this, Evolution, &CurrentGeneration, &NextGeneration](int32& OutFreedObjects)
+    {
+        SoakObjects.Reset();
+        SoakObjects.Add(Evolution);
+        SoakObjects.Append(CurrentGeneration);
+        SoakObjects.Append(NextGeneration);
+
+        const int32 ObjectsBefore = GUObjectArray.GetObjectArrayNumMinusAvailable();
+        const double Start = FPlatformTime::Seconds();
+        CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+        const double Milliseconds = (FPlatformTime::Seconds() - Start) * 1000.0;
+        OutFreedObjects = ObjectsBefore - GUObjectArray.GetObjectArrayNumMinusAvailable();
+        return Milliseconds;
+    };
+
+    UE_LOG(LogTemp, Display, TEXT("EvolutionBenchmark: soak, population %d, %d generations, collection every %d"),
+        PopulationSize, Generations, GCInterval);
+    UE_LOG(LogTemp, Display, TEXT("%10s %10s %16s %14s %10s %8s"),
+        TEXT("Generation"), TEXT("UObjects"), TEXT("Population KB"), TEXT("Physical MB"), TEXT("GC ms"), TEXT("Freed"));
+
+    // The first collection is the baseline; every later one is compared against it.
+    bool bHasBaseline = false;
+    int32 BaselineObjects = 0;
+    int64 BaselinePopulationBytes = 0;
+    uint64 BaselineUsedPhysical = 0;
+    int32 MaxObjects = 0;
+    int64 MaxPopulationBytes = 0;
+    uint64 MaxUsedPhysical = 0;
+    int32 NetworksCreated = 0;
+    int32 FreedObjects = 0;
+    int32 NumCollections = 0;
+    double TotalGCMilliseconds = 0.0;
+    double MaxGCMilliseconds = 0.0;
+
+    const double StartTime = FPlatformTime::Seconds();
+    for (int32 Generation = 0; Generation < Generations; Generation++)
+    {
+        EvaluateSyntheticFitness(CurrentGeneration, Target);
+
+        float FitnessMean = 0.f;
+        Evolution->ProcessGeneration(CurrentGeneration, NextGeneration, FitnessMean, PopulationSize);
+        Swap(CurrentGeneration, NextGeneration);
+        if (Generation >= WarmupGenerations)
+        {
+            NetworksCreated += Evolution->GetNetworksCreated();
+        }
+
+        if ((Generation + 1) % GCInterval != 0)
+        {
+            continue;
+        }
+
+        int32 Freed = 0;
+        const double GCMilliseconds = CollectSoakGarbage(Freed);
+        const int32 NumObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+        const int64 PopulationBytes = UEvolutionManager::GetGenerationAllocatedSize(CurrentGeneration) + UEvolutionManager::GetGenerationAllocatedSize(NextGeneration);
+        const uint64 UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+        UE_LOG(LogTemp, Display, TEXT("%10d %10d %16.1f %14.1f %10.2f %8d"),
+            Generation + 1, NumObjects, PopulationBytes / 1024.0, UsedPhysical / (1024.0 * 1024.0), GCMilliseconds, Freed);
+
+        if (!bHasBaseline)
+        {
+            bHasBaseline = true;
+            BaselineObjects = MaxObjects = NumObjects;
+            BaselinePopulationBytes = MaxPopulationBytes = PopulationBytes;
+            BaselineUsedPhysical = MaxUsedPhysical = UsedPhysical;
+            continue;
+        }
+        MaxObjects = FMath::Max(MaxObjects, NumObjects);
+        MaxPopulationBytes = FMath::Max(MaxPopulationBytes, PopulationBytes);
+        MaxUsedPhysical = FMath::Max(MaxUsedPhysical, UsedPhysical);
+        FreedObjects += Freed;
+        TotalGCMilliseconds += GCMilliseconds;
+        MaxGCMilliseconds = FMath::Max(MaxGCMilliseconds, GCMilliseconds);
+        NumCollections++;
+    }
+    const double TotalSeconds = FPlatformTime::Seconds() - StartTime;
+
+    const double PhysicalGrowthMB = (static_cast<double>(MaxUsedPhysical) - static_cast<double>(BaselineUsedPhysical)) / (1024.0 * 1024.0);
+    UE_LOG(LogTemp, Display, TEXT("EvolutionBenchmark: %.1f gen/sec, %d networks created after warmup, UObjects %d -> %d, population %lld -> %lld bytes, physical +%.1f MB"),
+        Generations / TotalSeconds, NetworksCreated, BaselineObjects, MaxObjects, BaselinePopulationBytes, MaxPopulationBytes, PhysicalGrowthMB);
+    UE_LOG(LogTemp, Display, TEXT("EvolutionBenchmark: %d collections after the baseline, %.2f ms mean, %.2f ms max, %d objects freed"),
+        NumCollections, TotalGCMilliseconds / FMath::Max(1, NumCollections), MaxGCMilliseconds, FreedObjects);
+
+    bool bPassed = true;
+    if (NetworksCreated > 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("EvolutionBenchmark: soak failed, %d networks were created after the warmup."), NetworksCreated);
+        bPassed = false;
+    }
+    if (FreedObjects > 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("EvolutionBenchmark: soak failed, the collections freed %d objects left behind by the training."), FreedObjects);
+        bPassed = false;
+    }
+    if (MaxObjects > BaselineObjects || MaxPopulationBytes > BaselinePopulationBytes)
+    {
+        UE_LOG(LogTemp, Error, TEXT("EvolutionBenchmark: soak failed, the UObject count or the population memory grew."));
+        bPassed = false;
+    }
+    if (PhysicalGrowthMB > MemoryToleranceMB)
+    {
+        UE_LOG(LogTemp, Error, TEXT("EvolutionBenchmark: soak failed, physical memory grew by %.1f MB (tolerance %d MB)."), PhysicalGrowthMB, MemoryToleranceMB);
+        bPassed = false;
+    }
+
+    SoakObjects.Empty();
+    CurrentGeneration.Empty();
+    NextGeneration.Empty();
+    CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+    return bPassed ? 0 : 1;
+}
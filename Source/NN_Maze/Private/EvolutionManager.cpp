@@ -1,5 +1,44 @@
 #include "EvolutionManager.h"
+#include "BreedKernel.h"
+#include "ParetoSort.h"
 #include "Math/UnrealMathUtility.h"
+#include "Async/ParallelFor.h"
+#include "Algo/Sort.h"
+#include "Tasks/Task.h"
+#include "NNMazeStats.h"
+
+namespace
+{
+    // A child starts from the geometric mean of its parents' step sizes (unset ones are ignored).
+    float InheritStepSize(float StepSizeA, float StepSizeB)
+    {
+        return StepSizeA > 0.f && StepSizeB > 0.f ? FMath::Sqrt(StepSizeA * StepSizeB) : FMath::Max(StepSizeA, StepSizeB);
+    }
+
+    // Heap ordering of the evaluated pool: the worst genome sits at the top.
+    struct FWorseGenome
+    {
+        bool operator()(const FEvaluatedGenome& A, const FEvaluatedGenome& B) const
+        {
+            return A.Fitness < B.Fitness;
+        }
+    };
+
+    // Tournament selection: the fittest of TournamentSize random genomes. Works on the unsorted heap in O(TournamentSize).
+    const FEvaluatedGenome& TournamentSelect(const TArray<FEvaluatedGenome>& Pool, int32 TournamentSize, FRandomStream& RandomStream)
+    {
+        const FEvaluatedGenome* Best = &Pool[RandomStream.RandRange(0, Pool.Num() - 1)];
+        for (int32 Round = 1; Round < TournamentSize; Round++)
+        {
+            const FEvaluatedGenome& Candidate = Pool[RandomStream.RandRange(0, Pool.Num() - 1)];
+            if (Candidate.Fitness > Best->Fitness)
+            {
+                Best = &Candidate;
+            }
+        }
+        return *Best;
+    }
+}
 
 UEvolutionManager::UEvolutionManager()
 {
@@ -7,7 +46,252 @@ UEvolutionManager::UEvolutionManager()
     ElitismRate = 0.1f;             // 10% of the population is preserved (elitism)
     BaseMutationRate = 0.5f;        // Base mutation rate for offspring
     CrossoverProbability = 0.5f;    // 50% chance to take gene from parent1 in crossover
+    CrossoverOperator = ECrossoverOperator::Uniform;
     TargetFitnessDifference = 10.f; // Target difference for dynamic mutation adaptation
+
+    // Fitness cache is opt-in since it assumes a deterministic simulation
+    bUseFitnessCache = false;
+    FitnessCacheCapacity = 4096;
+    EnvironmentHash = 0;
+
+    // A single island reproduces the classic panmictic GA
+    NumIslands = 1;
+    MigrationInterval = 5;
+    MigrantsPerIsland = 2;
+    MigrationTopology = EMigrationTopology::Ring;
+    GenerationIndex = 0;
+    NetworksCreated = 0;
+    InitializationStream.Initialize(FMath::Rand());
+
+    Pipeline = MakeShared<FBreedingPipeline, ESPMode::ThreadSafe>();
+
+    TournamentSize = 3;
+    SteadyStateStream.Initialize(FMath::Rand());
+    SteadyStateBirths = 0;
+    SteadyStateMutationRate = BaseMutationRate;
+
+    bUseNoveltySearch = false;
+    BehaviorDescriptorPoints = 1;
+    NoveltyNeighbors = 15;
+    NoveltyWeight = 1.f;
+    NoveltyArchiveProbability = 0.02f;
+    NoveltyStream.Initialize(FMath::Rand());
+
+    bUseMultiObjective = false;
+}
+
+void UEvolutionManager::SetEnvironmentHash(uint64 NewEnvironmentHash)
+{
+    if (FitnessCache.GetCapacity() != FitnessCacheCapacity)
+    {
+        FitnessCache.SetCapacity(FitnessCacheCapacity);
+    }
+
+    if (NewEnvironmentHash != EnvironmentHash)
+    {
+        if (FitnessCache.Num() > 0)
+        {
+            UE_LOG(LogTemp, Log, TEXT("Evaluation environment changed, invalidating %d cached fitness values."), FitnessCache.Num());
+        }
+        EnvironmentHash = NewEnvironmentHash;
+        FitnessCache.Invalidate();
+    }
+}
+
+void UEvolutionManager::InvalidateFitnessCache()
+{
+    FitnessCache.Invalidate();
+}
+
+bool UEvolutionManager::ApplyCachedFitness(UNeuralNetwork* Network)
+{
+    if (!bUseFitnessCache || !Network)
+    {
+        return false;
+    }
+
+    float CachedFitness = 0.f;
+    if (!FitnessCache.Find(FFitnessCache::MakeKey(Network, EnvironmentHash), CachedFitness))
+    {
+        return false;
+    }
+
+    Network->Fitness = CachedFitness;
+    return true;
+}
+
+void UEvolutionManager::RecordFitness(const TArray<UNeuralNetwork*>& Generation)
+{
+    if (!bUseFitnessCache)
+    {
+        return;
+    }
+
+    for (const UNeuralNetwork* Network : Generation)
+    {
+        if (Network)
+        {
+            FitnessCache.Add(FFitnessCache::MakeKey(Network, EnvironmentHash), Network->Fitness);
+        }
+    }
+}
+
+void UEvolutionManager::ApplyNovelty(TConstArrayView<UNeuralNetwork*> Population, TConstArrayView<float> Descriptors, int32 DescriptorSize)
+{
+    if (DescriptorSize <= 0 || Descriptors.Num() != Population.Num() * DescriptorSize)
+    {
+        UE_LOG(LogTemp, Error, TEXT("ApplyNovelty: %d descriptor values for %d networks of size %d"), Descriptors.Num(), Population.Num(), DescriptorSize);
+        return;
+    }
+    if (NoveltyArchive.GetDimension() != DescriptorSize)
+    {
+        NoveltyArchive.Reset(DescriptorSize);
+    }
+    bSelectionScoresApplied = true;
+
+    TArray<float> Novelty;
+    NoveltyArchive.ComputeNovelty(Descriptors, NoveltyNeighbors, Novelty);
+
+    float MeanNovelty = 0.f;
+    for (int32 i = 0; i < Population.Num(); i++)
+    {
+        if (UNeuralNetwork* Network = Population[i])
+        {
+            Network->SelectionScore = FMath::Lerp(Network->Fitness, Novelty[i], NoveltyWeight);
+            MeanNovelty += Novelty[i];
+        }
+    }
+
+    // Archived after scoring so a behaviour is not its own neighbour.
+    for (int32 i = 0; i < Population.Num(); i++)
+    {
+        if (NoveltyStream.FRand() < NoveltyArchiveProbability)
+        {
+            NoveltyArchive.Add(Descriptors.Slice(i * DescriptorSize, DescriptorSize));
+        }
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Novelty: mean %.2f, archive %d behaviours"), Population.Num() > 0 ? MeanNovelty / Population.Num() : 0.f, NoveltyArchive.Num());
+}
+
+void UEvolutionManager::ApplyMultiObjective(TConstArrayView<UNeuralNetwork*> Population, TConstArrayView<float> Objectives, int32 NumObjectives)
+{
+    if (NumObjectives <= 0 || Objectives.Num() != Population.Num() * NumObjectives)
+    {
+        UE_LOG(LogTemp, Error, TEXT("ApplyMultiObjective: %d objective values for %d networks of %d objectives"), Objectives.Num(), Population.Num(), NumObjectives);
+        return;
+    }
+
+    const double StartTime = FPlatformTime::Seconds();
+    bSelectionScoresApplied = true;
+    TArray<int32> Ranks;
+    int32 NumFronts = 0;
+    FParetoSort::ComputeFronts(Objectives, NumObjectives, Ranks, NumFronts);
+    TArray<float> Crowding;
+    FParetoSort::ComputeCrowding(Objectives, NumObjectives, Ranks, Crowding);
+
+    // A finite crowding distance is at most NumObjectives: the score stays within its front's unit interval.
+    int32 NumNonDominated = 0;
+    for (int32 i = 0; i < Population.Num(); i++)
+    {
+        if (UNeuralNetwork* Network = Population[i])
+        {
+            const float CrowdingScore = Crowding[i] == MAX_flt ? 0.5f : 0.5f * Crowding[i] / (NumObjectives + 1);
+            Network->SelectionScore = CrowdingScore - Ranks[i];
+        }
+        NumNonDominated += Ranks[i] == 0;
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Multi-objective: %d fronts, %d non-dominated, sorted in %.2f ms"),
+        NumFronts, NumNonDominated, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+void UEvolutionManager::PrepareSelectionScores(const TArray<UNeuralNetwork*>& Generation)
+{
+    if (!bSelectionScoresApplied)
+    {
+        for (UNeuralNetwork* Network : Generation)
+        {
+            if (Network)
+            {
+                Network->SelectionScore = Network->Fitness;
+            }
+        }
+    }
+    // The scores apply to this generation only.
+    bSelectionScoresApplied = false;
+}
+
+void UEvolutionManager::InitializeNetwork(UNeuralNetwork* Network, const TArray<int32>& LayerConfig, bool bRecurrent)
+{
+    Network->Initialize(LayerConfig, bRecurrent);
+    // Apply an initial mutation for diversity (tune the mutation probability as needed). Same reset mutation as
+    // before, through the sparse mutator: only the mutated weights cost a random draw.
+    Network->Mutate(0.5f, InitializationStream, FMutationSettings());
+}
+
+void UEvolutionManager::PrepareGenerationSlots(const TArray<UNeuralNetwork*>& CurrentGeneration, TArray<UNeuralNetwork*>& NextGeneration, int32 Population)
+{
+    NetworksCreated = 0;
+
+    NextGeneration.SetNumZeroed(Population, EAllowShrinking::No);
+
+    // Only a slot that is neither a parent nor another slot may be bred into: a caller that copies NextGeneration
+    // into CurrentGeneration (even partly) instead of swapping them hands parents back, which must not be
+    // overwritten while being bred from. Such slots are cleared and get a new network from ReuseNetworkSlot.
+    TSet<const UNeuralNetwork*> Taken;
+    Taken.Reserve(CurrentGeneration.Num() + Population);
+    for (const UNeuralNetwork* Parent : CurrentGeneration)
+    {
+        Taken.Add(Parent);
+    }
+    int32 NumAliased = 0;
+    for (UNeuralNetwork*& Slot : NextGeneration)
+    {
+        bool bAlreadyTaken = false;
+        if (Slot)
+        {
+            Taken.Add(Slot, &bAlreadyTaken);
+        }
+        if (bAlreadyTaken)
+        {
+            Slot = nullptr;
+            NumAliased++;
+        }
+    }
+    if (NumAliased > 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("PrepareGenerationSlots: %d slots of NextGeneration alias CurrentGeneration or each other; swap the generation arrays instead of copying them."), NumAliased);
+    }
+}
+
+UNeuralNetwork* UEvolutionManager::ReuseNetworkSlot(UNeuralNetwork* Slot, const TArray<int32>& InLayerSizes, bool bInRecurrent)
+{
+    if (!Slot)
+    {
+        Slot = NewObject<UNeuralNetwork>(this, UNeuralNetwork::StaticClass());
+        NetworksCreated++;
+    }
+    if (InLayerSizes.Num() > 0 && !Slot->HasTopology(InLayerSizes, bInRecurrent))
+    {
+        Slot->Initialize(InLayerSizes, bInRecurrent);
+    }
+    Slot->Fitness = 0.f;
+    Slot->SelectionScore = 0.f;
+    return Slot;
+}
+
+int64 UEvolutionManager::GetGenerationAllocatedSize(TConstArrayView<UNeuralNetwork*> Generation)
+{
+    int64 Size = 0;
+    for (const UNeuralNetwork* Network : Generation)
+    {
+        if (Network)
+        {
+            Size += Network->GetAllocatedSize();
+        }
+    }
+    return Size;
 }
 
 void UEvolutionManager::ProcessGeneration(TArray<UNeuralNetwork*>& CurrentGeneration,
@@ -15,6 +299,12 @@ void UEvolutionManager::ProcessGeneration(TArray<UNeuralNetwork*>& CurrentGenera
     float& OutGenerationFitnessMean,
     int32 PopulationSize)
 {
+    NNMAZE_PHASE_SCOPE(Breeding);
+
+    // Remember the evaluated fitness so identical genomes are not simulated again.
+    RecordFitness(CurrentGeneration);
+    PrepareSelectionScores(CurrentGeneration);
+
     // Calculate the average fitness for the current generation.
     OutGenerationFitnessMean = 0.f;
     for (int32 i = 0; i < PopulationSize; i++)
@@ -26,84 +316,382 @@ void UEvolutionManager::ProcessGeneration(TArray<UNeuralNetwork*>& CurrentGenera
     }
     OutGenerationFitnessMean /= PopulationSize;
 
-    // Sort the current generation by fitness in descending order (best networks first).
-    CurrentGeneration.Sort([](const UNeuralNetwork& A, const UNeuralNetwork& B)
+    // Split the population into contiguous islands. Every island needs at least two individuals.
+    const int32 Population = FMath::Min(PopulationSize, CurrentGeneration.Num());
+    if (Population <= 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("ProcessGeneration called with an empty population"));
+        NextGeneration.Empty();
+        return;
+    }
+    const int32 IslandCount = FMath::Clamp(NumIslands, 1, FMath::Max(1, Population / 2));
+    EnsureIslands(IslandCount);
+
+    TArray<int32> IslandStart;
+    IslandStart.SetNum(IslandCount + 1);
+    for (int32 Island = 0; Island <= IslandCount; Island++)
+    {
+        IslandStart[Island] = Island * Population / IslandCount;
+    }
+
+    // Prepare the children on the game thread, reusing the networks already in NextGeneration.
+    // UObjects must not be created from worker threads; the islands only fill their weights.
+    PrepareGenerationSlots(CurrentGeneration, NextGeneration, Population);
+    for (int32 i = 0; i < Population; i++)
+    {
+        NextGeneration[i] = ReuseNetworkSlot(NextGeneration[i], CurrentGeneration[i]->LayerSizes, CurrentGeneration[i]->bRecurrent);
+    }
+
+    GenerationIndex++;
+    const bool bMigrate = IslandCount > 1 && MigrationInterval > 0 && MigrantsPerIsland > 0 && (GenerationIndex % MigrationInterval) == 0;
+
+    // 1. Each island sorts its individuals and pushes its best ones to the destination inboxes.
+    ParallelFor(IslandCount, [&](int32 Island)
         {
-            return A.Fitness > B.Fitness;
+            EmitMigrants(Island, MakeArrayView(CurrentGeneration.GetData() + IslandStart[Island], IslandStart[Island + 1] - IslandStart[Island]), bMigrate);
         });
 
-    // Determine the number of elite networks to preserve.
-    int32 ElitismCount = FMath::CeilToInt(PopulationSize * ElitismRate);
-    if (ElitismCount < 1)
+    // 2. Once every migrant is queued, each island absorbs its inbox and breeds independently.
+    ParallelFor(IslandCount, [&](int32 Island)
+        {
+            const int32 Start = IslandStart[Island];
+            const int32 Count = IslandStart[Island + 1] - Start;
+            BreedIsland(Island, MakeArrayView(CurrentGeneration.GetData() + Start, Count), MakeArrayView(NextGeneration.GetData() + Start, Count));
+        });
+
+    if (IslandCount > 1)
     {
-        ElitismCount = 1;
+        for (const TUniquePtr<FEvolutionIsland>& Island : Islands)
+        {
+            const FIslandStats& Stats = Island->Stats;
+            UE_LOG(LogTemp, Log, TEXT("Island %d: size %d, best %.2f, mean %.2f, worst %.2f, migrants in %d, breed %.2f ms"),
+                Stats.IslandIndex, Stats.Size, Stats.BestFitness, Stats.MeanFitness, Stats.WorstFitness, Stats.MigrantsReceived, Stats.BreedTimeMs);
+        }
     }
+}
 
-    // Clear the NextGeneration array.
-    NextGeneration.Empty();
+void UEvolutionManager::AddEvaluatedGenome(const UNeuralNetwork* Network, int32 MaxPoolSize)
+{
+    if (!Network || MaxPoolSize <= 0)
+    {
+        return;
+    }
 
-    // 1. Elitism: Clone and copy the top elite networks directly (without mutation).
-    for (int32 i = 0; i < ElitismCount; i++)
+    // The pool is a min-heap on fitness: the worst genome is always at the top, so a full pool
+    // evicts it and inserts the newcomer in O(log N).
+    if (EvaluatedPool.Num() >= MaxPoolSize)
+    {
+        if (Network->Fitness <= EvaluatedPool.HeapTop().Fitness)
+        {
+            // Worse than every genome of a full pool.
+            return;
+        }
+        EvaluatedPool.HeapPopDiscard(FWorseGenome());
+    }
+
+    FEvaluatedGenome Genome;
+    Network->FlattenWeights(Genome.Weights);
+    Genome.Fitness = Network->Fitness;
+    Genome.MutationStepSize = Network->MutationStepSize;
+    if (PoolLayerOffsets.Num() == 0 || PoolLayerOffsets.Last() != Genome.Weights.Num())
+    {
+        Network->GetLayerOffsets(PoolLayerOffsets);
+    }
+    EvaluatedPool.HeapPush(MoveTemp(Genome), FWorseGenome());
+}
+
+FBreedSettings UEvolutionManager::MakeBreedSettings(float MutationRate) const
+{
+    FBreedSettings Settings;
+    Settings.Crossover = CrossoverOperator;
+    Settings.ProbabilityA = CrossoverProbability;
+    Settings.MutationRate = MutationRate;
+    Settings.Mutation = Mutation;
+    return Settings;
+}
+
+void UEvolutionManager::GetEvaluatedPoolStats(float& OutBestFitness, float& OutMeanFitness) const
+{
+    OutBestFitness = EvaluatedPool.Num() > 0 ? -MAX_flt : 0.f;
+    OutMeanFitness = 0.f;
+    for (const FEvaluatedGenome& Genome : EvaluatedPool)
+    {
+        OutBestFitness = FMath::Max(OutBestFitness, Genome.Fitness);
+        OutMeanFitness += Genome.Fitness;
+    }
+    OutMeanFitness /= FMath::Max(1, EvaluatedPool.Num());
+}
+
+bool UEvolutionManager::BreedSteadyStateChild(UNeuralNetwork* Child)
+{
+    NNMAZE_PHASE_SCOPE(Breeding);
+
+    if (!Child || EvaluatedPool.Num() < 2)
     {
-        UNeuralNetwork* EliteClone = NewObject<UNeuralNetwork>(this, UNeuralNetwork::StaticClass());
-        EliteClone->Initialize(CurrentGeneration[i]->LayerSizes);
-        EliteClone->CopyWeights(CurrentGeneration[i]);
-        // Do not apply mutation to elite clones.
-        NextGeneration.Add(EliteClone);
+        return false;
     }
 
-    // 2. Generate offspring for the remainder of the population using crossover.
-    int32 OffspringCount = PopulationSize - ElitismCount;
-    // Use the top half of the population as the pool for parents.
-    int32 ParentPoolSize = FMath::Max(1, PopulationSize / 2);
+    const FEvaluatedGenome& Parent1 = TournamentSelect(EvaluatedPool, TournamentSize, SteadyStateStream);
+    const FEvaluatedGenome& Parent2 = TournamentSelect(EvaluatedPool, TournamentSize, SteadyStateStream);
 
-    for (int32 i = 0; i < OffspringCount; i++)
+    // The dynamic mutation rate only needs refreshing now and then; a full scan per child would make breeding O(N).
+    if (SteadyStateBirths++ % FMath::Max(1, EvaluatedPool.Num()) == 0)
     {
-        // Randomly select two parents from the top half of the sorted population.
-        int32 ParentIndex1 = FMath::RandRange(0, ParentPoolSize - 1);
-        int32 ParentIndex2 = FMath::RandRange(0, ParentPoolSize - 1);
-        UNeuralNetwork* Parent1 = CurrentGeneration[ParentIndex1];
-        UNeuralNetwork* Parent2 = CurrentGeneration[ParentIndex2];
+        float BestFitness = 0.f;
+        float MeanFitness = 0.f;
+        GetEvaluatedPoolStats(BestFitness, MeanFitness);
+        SteadyStateMutationRate = GetDynamicMutationRate(BestFitness, MeanFitness);
+    }
+
+    const float StepSize = Mutation.Operator == EMutationOperator::Gaussian
+        ? UNeuralNetwork::AdaptStepSize(InheritStepSize(Parent1.MutationStepSize, Parent2.MutationStepSize), Mutation, SteadyStateStream)
+        : 0.f;
+    FBreedSettings Settings = MakeBreedSettings(SteadyStateMutationRate);
+    Settings.LayerOffsets = PoolLayerOffsets;
 
-        // Create a new network for the child.
-        UNeuralNetwork* Child = NewObject<UNeuralNetwork>(this, UNeuralNetwork::StaticClass());
-        TArray<int32> LayerConfig = Parent1->LayerSizes; // Assume both parents share the same configuration.
-        Child->Initialize(LayerConfig);
+    TArray<float>& ChildWeights = SteadyStateScratch;
+    ChildWeights.SetNumUninitialized(Parent1.Weights.Num());
+    FBreedKernel::Breed(Parent1.Weights, Parent2.Weights, ChildWeights, Settings, StepSize, SteadyStateStream);
+    Child->MutationStepSize = StepSize;
+    return Child->SetFlatWeights(ChildWeights);
+}
 
-        // Perform uniform crossover: for each weight, randomly select the gene from Parent1 or Parent2.
-        for (int32 layer = 0; layer < Child->Weights.Num(); layer++)
+void UEvolutionManager::RequestChildren(int32 Count)
+{
+    if (Count <= 0 || EvaluatedPool.Num() < 2 || Pipeline->bBreeding.load())
+    {
+        return;
+    }
+
+    // Everything the task needs is copied here, on the game thread.
+    float BestFitness = 0.f;
+    float MeanFitness = 0.f;
+    GetEvaluatedPoolStats(BestFitness, MeanFitness);
+    const float MutationRate = GetDynamicMutationRate(BestFitness, MeanFitness);
+    const FBreedSettings BreedSettings = MakeBreedSettings(MutationRate);
+    const int32 Tournament = TournamentSize;
+    const int32 Seed = FMath::Rand();
+
+    Pipeline->bBreeding = true;
+    UE::Tasks::Launch(UE_SOURCE_LOCATION,
+        [SharedPipeline = Pipeline, Parents = EvaluatedPool, LayerOffsets = PoolLayerOffsets, Count, BreedSettings, Tournament, Seed]()
         {
-            for (int32 neuron = 0; neuron < Child->Weights[layer].Num(); neuron++)
+            NNMAZE_PHASE_SCOPE(Breeding);
+
+            FBreedSettings Settings = BreedSettings;
+            Settings.LayerOffsets = LayerOffsets;
+            const FMutationSettings& MutationSettings = Settings.Mutation;
+            FRandomStream RandomStream(Seed);
+            for (int32 i = 0; i < Count; i++)
             {
-                for (int32 weightIdx = 0; weightIdx < Child->Weights[layer][neuron].Num(); weightIdx++)
+                const FEvaluatedGenome& Parent1 = TournamentSelect(Parents, Tournament, RandomStream);
+                const FEvaluatedGenome& Parent2 = TournamentSelect(Parents, Tournament, RandomStream);
+
+                FEvaluatedGenome Child;
+                if (MutationSettings.Operator == EMutationOperator::Gaussian)
                 {
-                    float RandomValue = FMath::FRand();
-                    if (RandomValue < CrossoverProbability)
-                    {
-                        Child->Weights[layer][neuron][weightIdx] = Parent1->Weights[layer][neuron][weightIdx];
-                    }
-                    else
-                    {
-                        Child->Weights[layer][neuron][weightIdx] = Parent2->Weights[layer][neuron][weightIdx];
-                    }
+                    Child.MutationStepSize = UNeuralNetwork::AdaptStepSize(InheritStepSize(Parent1.MutationStepSize, Parent2.MutationStepSize), MutationSettings, RandomStream);
                 }
+                Child.Weights.SetNumUninitialized(Parent1.Weights.Num());
+                FBreedKernel::Breed(Parent1.Weights, Parent2.Weights, Child.Weights, Settings, Child.MutationStepSize, RandomStream);
+
+                SharedPipeline->ReadyChildren.Enqueue(MoveTemp(Child));
+                SharedPipeline->NumReadyChildren++;
             }
+            SharedPipeline->bBreeding = false;
+        });
+}
+
+bool UEvolutionManager::TryPopChild(UNeuralNetwork* Network)
+{
+    FEvaluatedGenome Child;
+    if (!Network || !Pipeline->ReadyChildren.Dequeue(Child))
+    {
+        return false;
+    }
+
+    Pipeline->NumReadyChildren--;
+    Network->MutationStepSize = Child.MutationStepSize;
+    return Network->SetFlatWeights(Child.Weights);
+}
+
+float UEvolutionManager::GetDynamicMutationRate(float BestFitness, float MeanFitness) const
+{
+    // If the difference between the best and the average fitness is small, increase the mutation rate to encourage diversity.
+    float FitnessDiff = BestFitness - MeanFitness;
+    float DynamicFactor = 1.0f;
+    if (FitnessDiff < TargetFitnessDifference)
+    {
+        DynamicFactor = 1.0f + (TargetFitnessDifference - FitnessDiff) / TargetFitnessDifference; // Factor between 1 and 2.
+    }
+    return BaseMutationRate * DynamicFactor;
+}
+
+TArray<FIslandStats> UEvolutionManager::GetIslandStats() const
+{
+    TArray<FIslandStats> Stats;
+    Stats.Reserve(Islands.Num());
+    for (const TUniquePtr<FEvolutionIsland>& Island : Islands)
+    {
+        Stats.Add(Island->Stats);
+    }
+    return Stats;
+}
+
+void UEvolutionManager::EnsureIslands(int32 IslandCount)
+{
+    if (Islands.Num() == IslandCount)
+    {
+        return;
+    }
+
+    Islands.Reset(IslandCount);
+    for (int32 Island = 0; Island < IslandCount; Island++)
+    {
+        TUniquePtr<FEvolutionIsland> NewIsland = MakeUnique<FEvolutionIsland>();
+        NewIsland->RandomStream.Initialize(FMath::Rand());
+        NewIsland->Stats.IslandIndex = Island;
+        Islands.Add(MoveTemp(NewIsland));
+    }
+}
+
+void UEvolutionManager::EmitMigrants(int32 IslandIndex, TArrayView<UNeuralNetwork*> IslandPopulation, bool bMigrate)
+{
+    NNMAZE_SCOPE(EmitMigrants);
+
+    FEvolutionIsland& Island = *Islands[IslandIndex];
+
+    // Sort the island by selection score in descending order (best networks first).
+    Algo::Sort(IslandPopulation, [](const UNeuralNetwork* A, const UNeuralNetwork* B)
+        {
+            return A->SelectionScore > B->SelectionScore;
+        });
+
+    if (!bMigrate)
+    {
+        return;
+    }
+
+    const int32 MigrantCount = FMath::Min(MigrantsPerIsland, IslandPopulation.Num() / 2);
+    for (int32 i = 0; i < MigrantCount; i++)
+    {
+        int32 Destination = (IslandIndex + 1) % Islands.Num();
+        if (MigrationTopology == EMigrationTopology::Random)
+        {
+            // Any island but this one.
+            Destination = (IslandIndex + Island.RandomStream.RandRange(1, Islands.Num() - 1)) % Islands.Num();
         }
 
-        // 3. Dynamic mutation adaptation:
-        // Calculate the difference between the best fitness and the average fitness.
-        float BestFitness = CurrentGeneration[0]->Fitness;
-        float FitnessDiff = BestFitness - OutGenerationFitnessMean;
-        // If the difference is small, increase the mutation rate to encourage diversity.
-        float DynamicFactor = 1.0f;
-        if (FitnessDiff < TargetFitnessDifference)
+        FMigrant Migrant;
+        IslandPopulation[i]->FlattenWeights(Migrant.Weights);
+        Migrant.Fitness = IslandPopulation[i]->Fitness;
+        Migrant.SelectionScore = IslandPopulation[i]->SelectionScore;
+        Migrant.MutationStepSize = IslandPopulation[i]->MutationStepSize;
+        Islands[Destination]->Inbox.Enqueue(MoveTemp(Migrant));
+    }
+}
+
+void UEvolutionManager::BreedIsland(int32 IslandIndex, TArrayView<UNeuralNetwork*> IslandPopulation, TArrayView<UNeuralNetwork*> IslandChildren)
+{
+    NNMAZE_SCOPE(BreedIsland);
+
+    const double BreedStartTime = FPlatformTime::Seconds();
+    FEvolutionIsland& Island = *Islands[IslandIndex];
+    FRandomStream& RandomStream = Island.RandomStream;
+    const int32 IslandSize = IslandPopulation.Num();
+
+    // Migrants overwrite the worst individuals of the island (the end of the sorted slice).
+    int32 MigrantsReceived = 0;
+    FMigrant Migrant;
+    while (Island.Inbox.Dequeue(Migrant))
+    {
+        if (MigrantsReceived < IslandSize / 2)
         {
-            DynamicFactor = 1.0f + (TargetFitnessDifference - FitnessDiff) / TargetFitnessDifference; // Factor between 1 and 2.
+            UNeuralNetwork* Replaced = IslandPopulation[IslandSize - 1 - MigrantsReceived];
+            if (Replaced->SetFlatWeights(Migrant.Weights))
+            {
+                Replaced->Fitness = Migrant.Fitness;
+                Replaced->SelectionScore = Migrant.SelectionScore;
+                Replaced->MutationStepSize = Migrant.MutationStepSize;
+                MigrantsReceived++;
+            }
         }
-        float FinalMutationRate = BaseMutationRate * DynamicFactor;
+    }
+    if (MigrantsReceived > 0)
+    {
+        Algo::Sort(IslandPopulation, [](const UNeuralNetwork* A, const UNeuralNetwork* B)
+            {
+                return A->SelectionScore > B->SelectionScore;
+            });
+    }
 
-        // Apply mutation to the offspring.
-        Child->Mutate(FinalMutationRate);
-        NextGeneration.Add(Child);
+    // Island statistics, also used for the dynamic mutation below. They are taken on the raw fitness: the island
+    // is sorted on the selection score, which need not share its scale.
+    float IslandFitnessMean = 0.f;
+    float BestFitness = TNumericLimits<float>::Lowest();
+    float WorstFitness = TNumericLimits<float>::Max();
+    for (const UNeuralNetwork* Network : IslandPopulation)
+    {
+        IslandFitnessMean += Network->Fitness;
+        BestFitness = FMath::Max(BestFitness, Network->Fitness);
+        WorstFitness = FMath::Min(WorstFitness, Network->Fitness);
     }
+    IslandFitnessMean /= IslandSize;
+
+    // Determine the number of elite networks to preserve.
+    int32 ElitismCount = FMath::CeilToInt(IslandSize * ElitismRate);
+    ElitismCount = FMath::Clamp(ElitismCount, 1, IslandSize);
+
+    // 1. Elitism: copy the top elite networks directly (without mutation).
+    for (int32 i = 0; i < ElitismCount; i++)
+    {
+        IslandChildren[i]->CopyWeights(IslandPopulation[i]);
+    }
+
+    // 2. Dynamic mutation adaptation based on the island's best and average fitness.
+    float FinalMutationRate = GetDynamicMutationRate(BestFitness, IslandFitnessMean);
+
+    // 3. Generate offspring for the remainder of the island using crossover.
+    // Use the top half of the island as the pool for parents.
+    int32 ParentPoolSize = FMath::Max(1, IslandSize / 2);
+
+    // The breed kernel works on flat buffers: the parent pool is flattened once, not once per child.
+    TArray<TArray<float>> ParentWeights;
+    ParentWeights.SetNum(ParentPoolSize);
+    for (int32 i = 0; i < ParentPoolSize; i++)
+    {
+        IslandPopulation[i]->FlattenWeights(ParentWeights[i]);
+    }
+    TArray<int32> LayerOffsets;
+    IslandPopulation[0]->GetLayerOffsets(LayerOffsets);
+    FBreedSettings Settings = MakeBreedSettings(FinalMutationRate);
+    Settings.LayerOffsets = LayerOffsets;
+    TArray<float> ChildWeights;
+
+    for (int32 i = ElitismCount; i < IslandSize; i++)
+    {
+        // Randomly select two parents from the top half of the sorted island.
+        const int32 Parent1Index = RandomStream.RandRange(0, ParentPoolSize - 1);
+        const int32 Parent2Index = RandomStream.RandRange(0, ParentPoolSize - 1);
+        UNeuralNetwork* Child = IslandChildren[i]; // Assume both parents share the same configuration.
+
+        // Crossover and mutation in one pass (the Gaussian operator adapts the inherited step size first).
+        float StepSize = InheritStepSize(IslandPopulation[Parent1Index]->MutationStepSize, IslandPopulation[Parent2Index]->MutationStepSize);
+        if (Mutation.Operator == EMutationOperator::Gaussian)
+        {
+            StepSize = UNeuralNetwork::AdaptStepSize(StepSize, Mutation, RandomStream);
+        }
+        ChildWeights.SetNumUninitialized(ParentWeights[Parent1Index].Num());
+        FBreedKernel::Breed(ParentWeights[Parent1Index], ParentWeights[Parent2Index], ChildWeights, Settings, StepSize, RandomStream);
+        Child->MutationStepSize = StepSize;
+        Child->SetFlatWeights(ChildWeights);
+    }
+
+    FIslandStats& Stats = Island.Stats;
+    Stats.Size = IslandSize;
+    Stats.BestFitness = BestFitness;
+    Stats.MeanFitness = IslandFitnessMean;
+    Stats.WorstFitness = WorstFitness;
+    Stats.MigrantsReceived = MigrantsReceived;
+    Stats.BreedTimeMs = static_cast<float>((FPlatformTime::Seconds() - BreedStartTime) * 1000.0);
 }
@@ -0,0 +1,227 @@
+#include "EvolutionStrategyManager.h"
+#include "NeuralNetwork.h"
+#include "NNMazeStats.h"
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+    // Y += A * X, four lanes at a time.
+    void AddScaled(TArrayView<float> Y, TConstArrayView<float> X, float A)
+    {
+        const VectorRegister4Float ScaleVector = VectorSetFloat1(A);
+        int32 i = 0;
+        for (; i + 4 <= Y.Num(); i += 4)
+        {
+            VectorStore(VectorMultiplyAdd(VectorLoad(&X[i]), ScaleVector, VectorLoad(&Y[i])), &Y[i]);
+        }
+        for (; i < Y.Num(); i++)
+        {
+            Y[i] += A * X[i];
+        }
+    }
+
+    // Y = Y * A + X * B, four lanes at a time.
+    void ScaleAndAdd(TArrayView<float> Y, float A, TConstArrayView<float> X, float B)
+    {
+        const VectorRegister4Float ScaleY = VectorSetFloat1(A);
+        const VectorRegister4Float ScaleX = VectorSetFloat1(B);
+        int32 i = 0;
+        for (; i + 4 <= Y.Num(); i += 4)
+        {
+            VectorStore(VectorMultiplyAdd(VectorLoad(&X[i]), ScaleX, VectorMultiply(VectorLoad(&Y[i]), ScaleY)), &Y[i]);
+        }
+        for (; i < Y.Num(); i++)
+        {
+            Y[i] = Y[i] * A + X[i] * B;
+        }
+    }
+}
+
+UEvolutionStrategyManager::UEvolutionStrategyManager()
+{
+    NoiseStdDev = 0.05f;
+    LearningRate = 0.03f;
+    WeightDecay = 0.005f;
+    bRecurrentLayers = false;
+    StrategyGeneration = 0;
+    RandomStream.Initialize(FMath::Rand());
+}
+
+void UEvolutionStrategyManager::GenerateNoise(int32 Seed, int32 Block, TArrayView<float> OutNoise)
+{
+    // One stream per block: any block of any perturbation can be regenerated on its own.
+    FRandomStream Stream(static_cast<int32>(HashCombineFast(static_cast<uint32>(Seed), static_cast<uint32>(Block))));
+
+    // Box-Muller, two values per pair of uniforms.
+    for (int32 i = 0; i < OutNoise.Num(); i += 2)
+    {
+        const float Radius = FMath::Sqrt(-2.f * FMath::Loge(FMath::Max(Stream.GetFraction(), UE_SMALL_NUMBER)));
+        float Sin = 0.f;
+        float Cos = 0.f;
+        FMath::SinCos(&Sin, &Cos, UE_TWO_PI * Stream.GetFraction());
+        OutNoise[i] = Radius * Cos;
+        if (i + 1 < OutNoise.Num())
+        {
+            OutNoise[i + 1] = Radius * Sin;
+        }
+    }
+}
+
+void UEvolutionStrategyManager::InitializeNetwork(UNeuralNetwork* Network, const TArray<int32>& LayerConfig, bool bRecurrent)
+{
+    // The first network defines the starting point; every network, the first included, is a perturbation of it.
+    if (Center.Num() == 0 || LayerConfig != LayerSizes || bRecurrent != bRecurrentLayers)
+    {
+        Super::InitializeNetwork(Network, LayerConfig, bRecurrent);
+        ResetCenter(Network);
+    }
+    else
+    {
+        Network->Initialize(LayerConfig, bRecurrent);
+    }
+
+    // Networks are created in population order, so consecutive calls form the mirrored pairs.
+    const bool bMirror = SampleSeeds.Num() % 2 == 1;
+    SampleSeeds.Add(bMirror ? SampleSeeds.Last() : static_cast<int32>(RandomStream.GetUnsignedInt()));
+    SampleSigns.Add(bMirror ? -1.f : 1.f);
+    SampleNetwork(Network, SampleSeeds.Last(), SampleSigns.Last());
+}
+
+void UEvolutionStrategyManager::ResetCenter(const UNeuralNetwork* Network)
+{
+    LayerSizes = Network->LayerSizes;
+    bRecurrentLayers = Network->bRecurrent;
+    Network->FlattenWeights(Center);
+    SampleSeeds.Reset();
+    SampleSigns.Reset();
+}
+
+void UEvolutionStrategyManager::SampleNetwork(UNeuralNetwork* Network, int32 Seed, float Sign) const
+{
+    TArray<float> Weights = Center;
+    if (Sign != 0.f)
+    {
+        TArray<float, TInlineAllocator<NoiseBlockSize>> Noise;
+        for (int32 Start = 0, Block = 0; Start < Weights.Num(); Start += NoiseBlockSize, Block++)
+        {
+            const int32 Count = FMath::Min(NoiseBlockSize, Weights.Num() - Start);
+            Noise.SetNumUninitialized(Count, EAllowShrinking::No);
+            GenerateNoise(Seed, Block, Noise);
+            AddScaled(MakeArrayView(Weights).Slice(Start, Count), Noise, Sign * NoiseStdDev);
+        }
+    }
+    Network->SetFlatWeights(Weights);
+}
+
+void UEvolutionStrategyManager::ProcessGeneration(TArray<UNeuralNetwork*>& CurrentGeneration,
+    TArray<UNeuralNetwork*>& NextGeneration,
+    float& OutGenerationFitnessMean,
+    int32 PopulationSize)
+{
+    NNMAZE_PHASE_SCOPE(Breeding);
+
+    // Remember the evaluated fitness so identical genomes are not simulated again.
+    RecordFitness(CurrentGeneration);
+    PrepareSelectionScores(CurrentGeneration);
+
+    OutGenerationFitnessMean = 0.f;
+    const int32 Population = FMath::Min(PopulationSize, CurrentGeneration.Num());
+    if (Population <= 0 || CurrentGeneration.Contains(nullptr))
+    {
+        UE_LOG(LogTemp, Error, TEXT("ProcessGeneration called with an empty or incomplete population"));
+        NextGeneration.Empty();
+        return;
+    }
+
+    TArray<int32> ByFitness;
+    ByFitness.Reserve(Population);
+    for (int32 i = 0; i < Population; i++)
+    {
+        OutGenerationFitnessMean += CurrentGeneration[i]->Fitness;
+        ByFitness.Add(i);
+    }
+    OutGenerationFitnessMean /= PopulationSize;
+    Algo::Sort(ByFitness, [&CurrentGeneration](int32 A, int32 B) { return CurrentGeneration[A]->SelectionScore < CurrentGeneration[B]->SelectionScore; });
+    const UNeuralNetwork* Best = CurrentGeneration[ByFitness.Last()];
+    float BestFitness = TNumericLimits<float>::Lowest();
+    for (int32 i = 0; i < Population; i++)
+    {
+        BestFitness = FMath::Max(BestFitness, CurrentGeneration[i]->Fitness);
+    }
+
+    if (SampleSeeds.Num() < Population || Best->LayerSizes != LayerSizes || Best->bRecurrent != bRecurrentLayers)
+    {
+        // The population was not sampled by this manager: restart from its best network.
+        UE_LOG(LogTemp, Warning, TEXT("Evolution strategy: unknown population, restarting from its best network."));
+        ResetCenter(Best);
+    }
+    else
+    {
+        // Rank shaping: utilities from -0.5 (worst) to 0.5 (best), whatever the fitness scale. The perturbations
+        // of a mirrored pair share a seed, so each seed gets one coefficient: the difference of the pair's utilities.
+        TMap<int32, float> SeedCoefficients;
+        SeedCoefficients.Reserve(Population / 2 + 1);
+        for (int32 Rank = 0; Rank < Population; Rank++)
+        {
+            const int32 Index = ByFitness[Rank];
+            const float Utility = Population > 1 ? static_cast<float>(Rank) / (Population - 1) - 0.5f : 0.f;
+            if (SampleSigns[Index] != 0.f)
+            {
+                SeedCoefficients.FindOrAdd(SampleSeeds[Index]) += Utility * SampleSigns[Index];
+            }
+        }
+        TArray<TPair<int32, float>> Coefficients = SeedCoefficients.Array();
+
+        // Gradient estimate: sum of Coefficient * Noise / (Population * NoiseStdDev). Blocks are independent,
+        // so each task regenerates the noise of its own block for every seed.
+        const float GradientScale = LearningRate / (Population * NoiseStdDev);
+        const float Decay = 1.f - LearningRate * WeightDecay;
+        const int32 NumBlocks = FMath::DivideAndRoundUp(Center.Num(), NoiseBlockSize);
+        ParallelFor(NumBlocks, [this, &Coefficients, GradientScale, Decay](int32 Block)
+            {
+                const int32 Start = Block * NoiseBlockSize;
+                const int32 Count = FMath::Min(NoiseBlockSize, Center.Num() - Start);
+                TArray<float, TInlineAllocator<NoiseBlockSize>> Noise;
+                TArray<float, TInlineAllocator<NoiseBlockSize>> Gradient;
+                Noise.SetNumUninitialized(Count);
+                Gradient.SetNumZeroed(Count);
+                for (const TPair<int32, float>& Coefficient : Coefficients)
+                {
+                    GenerateNoise(Coefficient.Key, Block, Noise);
+                    AddScaled(Gradient, Noise, Coefficient.Value);
+                }
+                ScaleAndAdd(MakeArrayView(Center).Slice(Start, Count), Decay, Gradient, GradientScale);
+            });
+    }
+
+    // New perturbations; with an odd population the last network evaluates the center itself.
+    SampleSeeds.Reset(Population);
+    SampleSigns.Reset(Population);
+    for (int32 i = 0; i + 1 < Population; i += 2)
+    {
+        const int32 Seed = static_cast<int32>(RandomStream.GetUnsignedInt());
+        SampleSeeds.Append({ Seed, Seed });
+        SampleSigns.Append({ 1.f, -1.f });
+    }
+    if (Population % 2 == 1)
+    {
+        SampleSeeds.Add(0);
+        SampleSigns.Add(0.f);
+    }
+
+    // Slots are prepared on the game thread; only the weights are filled in parallel.
+    PrepareGenerationSlots(CurrentGeneration, NextGeneration, Population);
+    for (int32 i = 0; i < Population; i++)
+    {
+        NextGeneration[i] = ReuseNetworkSlot(NextGeneration[i], LayerSizes, bRecurrentLayers);
+    }
+    ParallelFor(Population, [this, &NextGeneration](int32 i)
+        {
+            SampleNetwork(NextGeneration[i], SampleSeeds[i], SampleSigns[i]);
+        });
+
+    StrategyGeneration++;
+    UE_LOG(LogTemp, Log, TEXT("Evolution strategy: generation %d, best %.2f, mean %.2f, %d parameters"),
+        StrategyGeneration, BestFitness, OutGenerationFitnessMean, Center.Num());
+}
@@ -0,0 +1,58 @@
+#include "FitnessCache.h"
+#include "NeuralNetwork.h"
+
+FFitnessCache::FFitnessCache(int32 InCapacity)
+    : Entries(FMath::Max(1, InCapacity))
+    , Capacity(FMath::Max(1, InCapacity))
+    , Hits(0)
+    , Misses(0)
+{
+}
+
+uint64 FFitnessCache::MakeKey(const UNeuralNetwork* Network, uint64 EnvironmentHash)
+{
+    return Network ? Network->ComputeWeightsHash(EnvironmentHash) : EnvironmentHash;
+}
+
+bool FFitnessCache::Find(uint64 Key, float& OutFitness)
+{
+    const float* CachedFitness = Entries.FindAndTouch(Key);
+    if (!CachedFitness)
+    {
+        Misses++;
+        return false;
+    }
+
+    Hits++;
+    OutFitness = *CachedFitness;
+    return true;
+}
+
+void FFitnessCache::Add(uint64 Key, float Fitness)
+{
+    Entries.Add(Key, Fitness);
+}
+
+void FFitnessCache::Invalidate()
+{
+    // Empty() also resets the maximum size, so pass the current capacity back in.
+    Entries.Empty(Capacity);
+}
+
+void FFitnessCache::SetCapacity(int32 NewCapacity)
+{
+    Capacity = FMath::Max(1, NewCapacity);
+    Entries.Empty(Capacity);
+}
+
+void FFitnessCache::ResetCounters()
+{
+    Hits = 0;
+    Misses = 0;
+}
+
+float FFitnessCache::GetHitRate() const
+{
+    const int64 Lookups = Hits + Misses;
+    return Lookups > 0 ? static_cast<float>(Hits) / static_cast<float>(Lookups) : 0.f;
+}
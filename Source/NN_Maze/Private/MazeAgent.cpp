@@ -1,10 +1,13 @@
 #include "MazeAgent.h"
+#include "ChampionSnapshot.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Engine/World.h"
 #include "DrawDebugHelpers.h"
 #include "Checkpoint.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "NNMazeStats.h"
+#include "ProceduralMaze.h"
 
 AMazeAgent::AMazeAgent()
 {
@@ -15,10 +18,19 @@ AMazeAgent::AMazeAgent()
     MaxViewDistance = 30.f;
     FitnessTimeDecreaseRate = 10.f;
     FitnessCheckpointIncreaseRate = 100.f;
+    ProgressRewardRate = 0.f;
+    LastExitDistance = -1.f;
     Fitness = 0.f;
     IsActive = true;
     DistanceTraveled = 0.f;
+    EpisodeStartTime = 0.f;
+    BehaviorDescriptorPoints = 0;
+    bManagedUpdate = false;
+    bGridCollision = false;
+    BehaviorDescriptorDuration = 0.f;
     NeuralNet = nullptr; // To be assigned by MazeManager during spawn
+    Maze = nullptr;
+    ChampionVersion = 0;
 
     // Configure collisions
     GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Visibility, ECR_Ignore);
@@ -47,6 +59,7 @@ void AMazeAgent::BeginPlay()
 {
     Super::BeginPlay();
     LastPosition = GetActorLocation();
+    EpisodeStartTime = GetWorld()->GetTimeSeconds();
 
     if (GetCharacterMovement())
     {
@@ -60,19 +73,131 @@ void AMazeAgent::BeginPlay()
 
 void AMazeAgent::Tick(float DeltaTime)
 {
+    NNMAZE_SCOPE(AgentTick);
+
     Super::Tick(DeltaTime);
 
-    if (!IsActive)
+    if (!IsActive || bManagedUpdate)
         return;
 
     // Update sensor data via raycast (with smoothing)
     RaycastVision();
 
+    // In a procedural maze, the exit sensor and the progress reward follow the geodesic flow field.
+    const FMazeFlowField* FlowField = GetFlowField();
+
     // Update relative sensor inputs regarding the exit.
-    if (bUseExitSensor && ExitLocation != FVector::ZeroVector)
+    UpdateExitSensor(GetActorLocation(), GetActorRotation(), FlowField);
+
+    // Process neural network output if assigned
+    if (NeuralNet)
+    {
+        ProcessNeuralNetwork();
+    }
+
+    NNMAZE_PHASE_SCOPE(Movement);
+
+    // Update fitness using dedicated functions.
+    UpdateFitness(GetActorLocation(), DeltaTime, GetWorld()->GetTimeSeconds(), FlowField);
+
+    // Logging: Optionally, log agent position and fitness.
+    // UE_LOG(LogTemp, Log, TEXT("Agent Position: %s, Fitness: %.2f"), *CurrentPosition.ToString(), Fitness);
+
+    // Visualization: Draw debug line to visualize the path taken.
+    DrawDebugLine(GetWorld(), LastPosition, GetActorLocation(), FColor::Green, false, 5.f, 0, 2.f);
+}
+
+void AMazeAgent::BeginManagedUpdate(FMazeAgentUpdate& Update, float CurrentTime)
+{
+    Update.Location = GetActorLocation();
+    Update.Rotation = GetActorRotation();
+    Update.FlowField = GetFlowField();
+
+    // Physics scene queries stay on the game thread; the maze grid is read in the parallel phase.
+    if (!Maze)
+    {
+        UpdateVision(Update.Location, Update.Rotation, CurrentTime);
+    }
+}
+
+void AMazeAgent::ComputeManagedUpdate(FMazeAgentUpdate& Update, float DeltaTime, float CurrentTime, TArrayView<float> RecurrentState)
+{
+    if (Maze)
+    {
+        UpdateVision(Update.Location, Update.Rotation, CurrentTime);
+    }
+    UpdateExitSensor(Update.Location, Update.Rotation, Update.FlowField);
+
+    Update.NewLocation = Update.Location;
+    Update.NewRotation = Update.Rotation;
+    PollChampion();
+    if (NeuralNet && NeuralNet->GetInputSize() == NumNetworkInputs)
+    {
+        TArray<float, TInlineAllocator<NumNetworkInputs>> Inputs;
+        Inputs.SetNumUninitialized(NumNetworkInputs);
+        GetNetworkInputs(Inputs);
+
+        NNMAZE_PHASE_SCOPE(Inference);
+        TArray<float, TInlineAllocator<8>> Outputs;
+        Outputs.SetNumUninitialized(NeuralNet->LayerSizes.Last());
+        const int32 StateSize = NeuralNet->GetStateSize();
+        if (RecurrentState.Num() == StateSize)
+        {
+            // The hidden state belongs to this agent: MazeManager hands out disjoint slices.
+            NeuralNet->FeedForward(Inputs, RecurrentState, Outputs);
+        }
+        else
+        {
+            // No state slice for this network: a zero state, like the stateless FeedForward.
+            TArray<float, TInlineAllocator<64>> ZeroState;
+            ZeroState.SetNumZeroed(StateSize);
+            NeuralNet->FeedForward(Inputs, ZeroState, Outputs);
+        }
+        FNNMazeFrameCounters::AddInferences(1);
+
+        if (Outputs.Num() >= 2)
+        {
+            MoveFromNetworkOutputs(Outputs[0], Outputs[1], DeltaTime, Update.NewLocation, Update.NewRotation);
+        }
+    }
+
+    // SetActorLocation() without sweep always lands on the new pose, so the fitness can use it right away.
+    NNMAZE_PHASE_SCOPE(Movement);
+    UpdateFitness(Update.NewLocation, DeltaTime, CurrentTime, Update.FlowField);
+
+    // Same wall test as the headless simulator.
+    if (bGridCollision && Maze && Maze->GetGrid().OverlapsWall(Maze->WorldToGrid(Update.NewLocation), GetCapsuleComponent()->GetScaledCapsuleRadius() / Maze->BlockSize))
+    {
+        ApplyWallPenalty();
+        IsActive = false;
+    }
+}
+
+void AMazeAgent::ApplyManagedUpdate(const FMazeAgentUpdate& Update)
+{
+    if (!Update.NewLocation.Equals(Update.Location, 0.f))
+    {
+        SetActorLocation(Update.NewLocation);
+    }
+    if (!Update.NewRotation.Equals(Update.Rotation, 0.f))
+    {
+        SetActorRotation(Update.NewRotation);
+    }
+
+    // Same path trail as Tick. Debug drawing is not thread safe, so it stays in the serial phase.
+    DrawDebugLine(GetWorld(), Update.Location, Update.NewLocation, FColor::Green, false, 5.f, 0, 2.f);
+}
+
+void AMazeAgent::UpdateExitSensor(const FVector& AgentLocation, const FRotator& AgentRotation, const FMazeFlowField* FlowField)
+{
+    if (FlowField && bUseExitSensor)
+    {
+        UpdateFlowFieldSensor(*FlowField, AgentLocation, AgentRotation.Yaw);
+    }
+    else if (bUseExitSensor && ExitLocation != FVector::ZeroVector)
     {
         // Calculate the vector from the agent to the exit.
-        FVector ToExit = ExitLocation - GetActorLocation();
+        FVector ToExit = ExitLocation - AgentLocation;
         float DistanceToExit = ToExit.Size();
         // Set MaxRelevantDistance (you may define a local variable or use a constant; here we assume 1000.f for example)
         float MaxRelevantDistance = 1000.f;
@@ -80,10 +205,11 @@ void AMazeAgent::Tick(float DeltaTime)
 
         // Normalize the direction vector.
         FVector ToExitNormalized = ToExit.GetSafeNormal();
+        const FVector ForwardDir = AgentRotation.Vector();
         // Compute the angle (in radians) between the agents forward vector and the direction to the exit.
-        float Angle = FMath::Acos(FVector::DotProduct(GetActorForwardVector(), ToExitNormalized));
+        float Angle = FMath::Acos(FVector::DotProduct(ForwardDir, ToExitNormalized));
         // Determine the sign of the angle (left or right) using the cross products Z component.
-        float Sign = (FVector::CrossProduct(GetActorForwardVector(), ToExitNormalized)).Z >= 0 ? 1.0f : -1.0f;
+        float Sign = (FVector::CrossProduct(ForwardDir, ToExitNormalized)).Z >= 0 ? 1.0f : -1.0f;
         // Normalize the angle to the range [-1, 1] (assuming PI is the max relevant angle).
         RelativeAngleToExit = (Angle * Sign) / PI;
     }
@@ -93,16 +219,10 @@ void AMazeAgent::Tick(float DeltaTime)
         RelativeAngleToExit = 0.f;          // No directional bias.
         NormalizedDistanceToExit = 1.f;       // Consider exit as "far away".
     }
-    // --- End new sensor update ---
-
-    // Process neural network output if assigned
-    if (NeuralNet)
-    {
-        ProcessNeuralNetwork();
-    }
+}
 
-    // Update fitness using dedicated functions.
-    FVector CurrentPosition = GetActorLocation();
+void AMazeAgent::UpdateFitness(const FVector& CurrentPosition, float DeltaTime, float CurrentTime, const FMazeFlowField* FlowField)
+{
     float DeltaDistance = FVector::Dist(CurrentPosition, LastPosition);
     DistanceTraveled += DeltaDistance;
     LastPosition = CurrentPosition;
@@ -111,35 +231,41 @@ void AMazeAgent::Tick(float DeltaTime)
         ApplyDistanceReward(DeltaDistance);
     }
     ApplyTimePenalty(DeltaTime);
+    if (FlowField && ProgressRewardRate != 0.f)
+    {
+        ApplyProgressReward(FlowField->GetDistance(Maze->WorldToGrid(CurrentPosition)));
+    }
 
-    // Logging: Optionally, log agent position and fitness.
-    // UE_LOG(LogTemp, Log, TEXT("Agent Position: %s, Fitness: %.2f"), *CurrentPosition.ToString(), Fitness);
+    // Behaviour descriptor: point P is sampled once (P + 1) / N of the episode has elapsed.
+    const float EpisodeTime = CurrentTime - EpisodeStartTime;
+    while (BehaviorSamples.Num() < BehaviorDescriptorPoints && EpisodeTime * BehaviorDescriptorPoints >= (BehaviorSamples.Num() + 1) * BehaviorDescriptorDuration)
+    {
+        BehaviorSamples.Add(GetPlanePosition(CurrentPosition));
+    }
+}
 
-    // Visualization: Draw debug line to visualize the path taken.
-    DrawDebugLine(GetWorld(), LastPosition, CurrentPosition, FColor::Green, false, 5.f, 0, 2.f);
+void AMazeAgent::GetNetworkInputs(TArrayView<float> OutInputs) const
+{
+    check(OutInputs.Num() == NumNetworkInputs);
+
+    // Normalize primary sensor inputs using MaxViewDistance.
+    OutInputs[0] = Speed / MaxViewDistance;
+    OutInputs[1] = DistForward / MaxViewDistance;
+    OutInputs[2] = DistLeft / MaxViewDistance;
+    OutInputs[3] = DistDiagLeft / MaxViewDistance;
+    OutInputs[4] = DistRight / MaxViewDistance;
+    OutInputs[5] = DistDiagRight / MaxViewDistance;
+    OutInputs[6] = RelativeAngleToExit;     // Relative angle to exit (normalized)
+    OutInputs[7] = NormalizedDistanceToExit; // Normalized distance to exit
 }
 
 void AMazeAgent::ProcessNeuralNetwork()
 {
-    // Normalize primary sensor inputs using MaxViewDistance.
-    float NormalizedSpeed = Speed / MaxViewDistance;
-    float NormForward = DistForward / MaxViewDistance;
-    float NormLeft = DistLeft / MaxViewDistance;
-    float NormDiagLeft = DistDiagLeft / MaxViewDistance;
-    float NormRight = DistRight / MaxViewDistance;
-    float NormDiagRight = DistDiagRight / MaxViewDistance;
-
-    // Build the input array including the two new sensor inputs.
-    TArray<float> Inputs = {
-        NormalizedSpeed,
-        NormForward,
-        NormLeft,
-        NormDiagLeft,
-        NormRight,
-        NormDiagRight,
-        RelativeAngleToExit,     // Relative angle to exit (normalized)
-        NormalizedDistanceToExit // Normalized distance to exit
-    };
+    PollChampion();
+
+    TArray<float> Inputs;
+    Inputs.SetNumUninitialized(NumNetworkInputs);
+    GetNetworkInputs(Inputs);
 
     if (Inputs.Num() != NeuralNet->GetInputSize())
     {
@@ -149,7 +275,12 @@ void AMazeAgent::ProcessNeuralNetwork()
     }
 
     // Feed inputs to the neural network.
-    TArray<float> NNOutputs = NeuralNet->FeedForward(Inputs);
+    TArray<float> NNOutputs;
+    {
+        NNMAZE_PHASE_SCOPE(Inference);
+        NNOutputs = NeuralNet->FeedForward(Inputs);
+        FNNMazeFrameCounters::AddInferences(1);
+    }
     if (NNOutputs.Num() < 2)
     {
         UE_LOG(LogTemp, Warning, TEXT("Insufficient neural network outputs."));
@@ -157,34 +288,59 @@ void AMazeAgent::ProcessNeuralNetwork()
     }
 
     // Interpret outputs: NNOutputs[0] is used as speed multiplier, NNOutputs[1] as rotation delta.
-    float SpeedMultiplier = NNOutputs[0];
-    float RotationDelta = NNOutputs[1];
+    ApplyNetworkOutputs(NNOutputs[0], NNOutputs[1]);
+}
 
-    // Move agent based on neural network output.
-    FVector MoveDelta = GetActorForwardVector() * Speed * SpeedMultiplier * GetWorld()->GetDeltaSeconds();
-    SetActorLocation(GetActorLocation() + MoveDelta);
+void AMazeAgent::PollChampion()
+{
+    // A single atomic load while nothing new was published; a copy that raced with the writer is retried next tick.
+    if (ChampionSource && NeuralNet && ChampionSource->TryRead(ChampionVersion, ChampionWeights))
+    {
+        NeuralNet->SetFlatWeights(ChampionWeights);
+    }
+}
 
-    // Apply rotation.
+void AMazeAgent::ApplyNetworkOutputs(float SpeedMultiplier, float RotationDelta)
+{
+    NNMAZE_PHASE_SCOPE(Movement);
+
+    FVector NewLocation = GetActorLocation();
     FRotator NewRotation = GetActorRotation();
-    NewRotation.Yaw += RotationDelta * RotationSpeed * GetWorld()->GetDeltaSeconds();
+    MoveFromNetworkOutputs(SpeedMultiplier, RotationDelta, GetWorld()->GetDeltaSeconds(), NewLocation, NewRotation);
+    SetActorLocation(NewLocation);
     SetActorRotation(NewRotation);
 
     //UE_LOG(LogTemp, Log, TEXT("NeuralNet output: SpeedMultiplier=%.2f, RotationDelta=%.2f"), SpeedMultiplier, RotationDelta);
 }
 
+void AMazeAgent::MoveFromNetworkOutputs(float SpeedMultiplier, float RotationDelta, float DeltaTime, FVector& InOutLocation, FRotator& InOutRotation) const
+{
+    // Move agent based on neural network output.
+    InOutLocation += InOutRotation.Vector() * Speed * SpeedMultiplier * DeltaTime;
+
+    // Apply rotation.
+    InOutRotation.Yaw += RotationDelta * RotationSpeed * DeltaTime;
+}
+
 void AMazeAgent::RaycastVision()
 {
+    UpdateVision(GetActorLocation(), GetActorRotation(), GetWorld()->GetTimeSeconds());
+}
+
+void AMazeAgent::UpdateVision(const FVector& AgentLocation, const FRotator& AgentRotation, float CurrentTime)
+{
+    NNMAZE_PHASE_SCOPE(Sensing);
+
     // Only perform raycasts if the update interval has elapsed.
-    float CurrentTime = GetWorld()->GetTimeSeconds();
     if (CurrentTime - LastRaycastUpdateTime < RaycastUpdateInterval)
     {
         return;
     }
     LastRaycastUpdateTime = CurrentTime;
 
-    FVector AgentLocation = GetActorLocation();
-    FVector ForwardDir = GetActorForwardVector();
-    FVector RightDir = GetActorRightVector();
+    const FRotationMatrix AgentAxes(AgentRotation);
+    FVector ForwardDir = AgentAxes.GetScaledAxis(EAxis::X);
+    FVector RightDir = AgentAxes.GetScaledAxis(EAxis::Y);
     FVector LeftDir = -RightDir;
     FVector RightDiagDir = (ForwardDir + RightDir).GetSafeNormal();
     FVector LeftDiagDir = (ForwardDir + LeftDir).GetSafeNormal();
@@ -195,6 +351,10 @@ void AMazeAgent::RaycastVision()
     // Define a lambda that performs a line trace and returns the distance.
     auto PerformRayCast = [this, AgentLocation, &CollisionParams, &Hit](const FVector& Direction) -> float
         {
+            if (Maze)
+            {
+                return Maze->Raycast(AgentLocation, Direction, MaxViewDistance);
+            }
             bool bHit = GetWorld()->LineTraceSingleByChannel(Hit, AgentLocation, AgentLocation + Direction * MaxViewDistance, ECC_Visibility, CollisionParams);
             return bHit ? Hit.Distance : MaxViewDistance;
         };
@@ -205,6 +365,7 @@ void AMazeAgent::RaycastVision()
     float RawLeftDiag = PerformRayCast(LeftDiagDir);
     float RawRight = PerformRayCast(RightDir);
     float RawRightDiag = PerformRayCast(RightDiagDir);
+    FNNMazeFrameCounters::AddRays(5);
 
     // Apply smoothing to raw sensor readings using Lerp and clamp the values.
     DistForward = FMath::Clamp(FMath::Lerp<float>(PrevDistForward, RawForward, SensorSmoothingFactor), 0.f, MaxViewDistance);
@@ -221,6 +382,94 @@ void AMazeAgent::RaycastVision()
     PrevDistDiagRight = DistDiagRight;
 }
 
+void AMazeAgent::ResetForEpisode(const FVector& Location, const FRotator& Rotation)
+{
+    NNMAZE_PHASE_SCOPE(Spawning);
+
+    SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+    GetCharacterMovement()->StopMovementImmediately();
+
+    Fitness = 0.f;
+    Objectives = FMazeObjectives();
+    IsActive = true;
+    DistanceTraveled = 0.f;
+    LastPosition = Location;
+    EpisodeStartTime = GetWorld()->GetTimeSeconds();
+
+    // Same sensor state as a freshly spawned agent.
+    LastRaycastUpdateTime = 0.f;
+    PrevDistForward = MaxViewDistance;
+    PrevDistLeft = MaxViewDistance;
+    PrevDistDiagLeft = MaxViewDistance;
+    PrevDistRight = MaxViewDistance;
+    PrevDistDiagRight = MaxViewDistance;
+    RelativeAngleToExit = 0.f;
+    NormalizedDistanceToExit = 1.f;
+    LastExitDistance = -1.f;
+    BehaviorSamples.Reset();
+}
+
+void AMazeAgent::SetSimulationEnabled(bool bEnabled)
+{
+    // Managed agents are updated by MazeManager and never need their own tick.
+    SetActorTickEnabled(bEnabled && !bManagedUpdate);
+    SetActorHiddenInGame(!bEnabled);
+    SetActorEnableCollision(bEnabled);
+
+    // Without collision the movement component would find no floor and start falling; dead agents stay put.
+    UCharacterMovementComponent* Movement = GetCharacterMovement();
+    Movement->StopMovementImmediately();
+    Movement->SetComponentTickEnabled(bEnabled);
+    if (bEnabled)
+    {
+        Movement->SetMovementMode(MOVE_Walking);
+    }
+    else
+    {
+        Movement->DisableMovement();
+    }
+}
+
+const FMazeFlowField* AMazeAgent::GetFlowField() const
+{
+    if (!Maze || ExitLocation.IsZero() || (!bUseExitSensor && ProgressRewardRate == 0.f))
+    {
+        return nullptr;
+    }
+    return &Maze->GetFlowField(ExitLocation);
+}
+
+void AMazeAgent::UpdateFlowFieldSensor(const FMazeFlowField& FlowField, const FVector& AgentLocation, float AgentYaw)
+{
+    const FVector2D GridPosition = Maze->WorldToGrid(AgentLocation);
+
+    // Normalized by the longest path of the maze rather than a fixed distance; walls and unreachable blocks read as far.
+    const float Distance = FlowField.GetDistance(GridPosition);
+    NormalizedDistanceToExit = Distance >= 0.f ? FMath::Clamp(Distance / FMath::Max(FlowField.GetMaxDistance(), 1.f), 0.f, 1.f) : 1.f;
+
+    // The direction is one of 8 precomputed yaws, so the angle is a subtraction instead of Acos and a cross product.
+    float DirectionYaw = 0.f;
+    RelativeAngleToExit = FlowField.GetDirectionYaw(GridPosition, DirectionYaw)
+        ? FMazeFlowField::GetRelativeAngle(DirectionYaw, Maze->WorldToMazeYaw(AgentYaw))
+        : 0.f;
+}
+
+void AMazeAgent::GetBehaviorDescriptor(TArray<float>& OutDescriptor) const
+{
+    const FVector2D CurrentPosition = GetPlanePosition();
+    for (int32 i = 0; i < BehaviorDescriptorPoints; i++)
+    {
+        const FVector2D& Point = BehaviorSamples.IsValidIndex(i) ? BehaviorSamples[i] : CurrentPosition;
+        OutDescriptor.Add(Point.X);
+        OutDescriptor.Add(Point.Y);
+    }
+}
+
+FVector2D AMazeAgent::GetPlanePosition(const FVector& Location) const
+{
+    return Maze ? Maze->WorldToMaze(Location) : FVector2D(Location);
+}
+
 void AMazeAgent::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 {
     Super::SetupPlayerInputComponent(PlayerInputComponent);
@@ -232,6 +481,7 @@ void AMazeAgent::ApplyDistanceReward(float DeltaDistance)
 {
     // Reward agent for moving a distance greater than a threshold.
     Fitness += DeltaDistance / 100.f;
+    Objectives[EMazeObjective::Progress] += DeltaDistance / 100.f;
 }
 
 void AMazeAgent::ApplyTimePenalty(float DeltaTime)
@@ -244,19 +494,37 @@ void AMazeAgent::ApplyWallPenalty()
 {
     // Apply penalty when hitting a wall; you can adjust the penalty value as needed.
     Fitness -= FitnessCheckpointIncreaseRate;
+    Objectives[EMazeObjective::Collisions] -= 1.f;
 }
 
 void AMazeAgent::ApplyCheckpointReward(float RewardMultiplier)
 {
     // Reward the agent for reaching a checkpoint using the multiplier provided by the checkpoint.
     Fitness += FitnessCheckpointIncreaseRate * RewardMultiplier;
+    Objectives[EMazeObjective::Checkpoints] += RewardMultiplier;
+}
+
+void AMazeAgent::ApplyProgressReward(float ExitDistance)
+{
+    // Moving away from the exit along the shortest path costs as much as getting closer earns.
+    if (ExitDistance < 0.f)
+    {
+        return;
+    }
+    if (LastExitDistance >= 0.f)
+    {
+        Fitness += ProgressRewardRate * (LastExitDistance - ExitDistance);
+        Objectives[EMazeObjective::Progress] += ProgressRewardRate * (LastExitDistance - ExitDistance);
+    }
+    LastExitDistance = ExitDistance;
 }
 
 void AMazeAgent::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
     if (OtherActor && (OtherActor != this) && OtherComp)
     {
-        if (OtherActor->ActorHasTag("Wall"))
+        // With grid collision the walls are handled by ComputeManagedUpdate().
+        if (OtherActor->ActorHasTag("Wall") && !bGridCollision)
         {
             ApplyWallPenalty();
             IsActive = false;
@@ -0,0 +1,415 @@
+#include "MazeBenchmarkCommandlet.h"
+#include "MazeManager.h"
+#include "MazeAgent.h"
+#include "ProceduralMaze.h"
+#include "NNMazeStats.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+    struct FBenchmarkSettings
+    {
+        int32 Generations = 3;
+        float TimeLimit = 10.f;
+        float DeltaTime = 1.f / 30.f;
+        int32 Seed = 1234;
+        int32 MazeCells = 8;
+        float BlockSize = 100.f;
+        EMazeAlgorithm MazeAlgorithm = EMazeAlgorithm::RecursiveBacktracker;
+        EEvolutionMode Mode = EEvolutionMode::Generational;
+        TSubclassOf<AMazeAgent> AgentClass;
+        bool bTelemetry = false;
+        int32 MazeInstances = 1;
+        bool bHeadless = false;
+        bool bParallelAgentUpdate = true;
+
+        // Threads of the parallel agent update, one run per entry (0 = all workers).
+        TArray<int32> UpdateThreads = { 0 };
+    };
+
+    struct FBenchmarkResult
+    {
+        int32 PopulationSize = 0;
+        int32 UpdateThreads = 0;
+        int32 Generations = 0;
+        int32 Frames = 0;
+        double Seconds = 0.0;
+        double GenerationsPerSecond = 0.0;
+        double AgentStepsPerSecond = 0.0;
+        double FrameMsP50 = 0.0;
+        double FrameMsP99 = 0.0;
+        double AgentUpdateMsP50 = 0.0;
+        double AgentUpdateSpeedup = 1.0;
+        double PeakMemoryMB = 0.0;
+    };
+
+    double Percentile(TArray<double> Values, double Fraction)
+    {
+        if (Values.Num() == 0)
+        {
+            return 0.0;
+        }
+        Values.Sort();
+        return Values[FMath::Clamp(FMath::CeilToInt32(Fraction * Values.Num()) - 1, 0, Values.Num() - 1)];
+    }
+
+    // Generation time of a 512x512 cell maze for every algorithm, in milliseconds.
+    TMap<FString, double> BenchmarkGridGeneration(int32 Seed)
+    {
+        TMap<FString, double> Timings;
+        const UEnum* AlgorithmEnum = StaticEnum<EMazeAlgorithm>();
+        for (int32 i = 0; i < AlgorithmEnum->NumEnums() - 1; i++)
+        {
+            FMazeGenerationSettings GridSettings;
+            GridSettings.Algorithm = static_cast<EMazeAlgorithm>(AlgorithmEnum->GetValueByIndex(i));
+            GridSettings.CellsX = 512;
+            GridSettings.CellsY = 512;
+            GridSettings.Seed = Seed;
+            GridSettings.RoomCount = 64;
+            GridSettings.RoomMaxSize = 16;
+
+            const double StartTime = FPlatformTime::Seconds();
+            const FMazeGrid Grid = FMazeGrid::Generate(GridSettings);
+            const double Milliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+            Timings.Add(AlgorithmEnum->GetNameStringByIndex(i), Milliseconds);
+            UE_LOG(LogTemp, Display, TEXT("MazeBenchmark: 512x512 %s maze generated in %.2f ms (%d wall rectangles)"),
+                *AlgorithmEnum->GetNameStringByIndex(i), Milliseconds, Grid.BuildWallRectangles().Num());
+        }
+        return Timings;
+    }
+
+    bool RunBenchmark(int32 PopulationSize, int32 UpdateThreads, const FBenchmarkSettings& Settings, FBenchmarkResult& OutResult)
+    {
+        UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("MazeBenchmark"));
+        FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+        WorldContext.SetCurrentWorld(World);
+        World->InitializeActorsForPlay(FURL());
+        World->BeginPlay();
+
+        AProceduralMaze* Maze = World->SpawnActorDeferred<AProceduralMaze>(AProceduralMaze::StaticClass(), FTransform::Identity);
+        Maze->Settings.Algorithm = Settings.MazeAlgorithm;
+        Maze->Settings.CellsX = Settings.MazeCells;
+        Maze->Settings.CellsY = Settings.MazeCells;
+        Maze->Settings.Seed = Settings.Seed;
+        Maze->BlockSize = Settings.BlockSize;
+        Maze->FinishSpawning(FTransform::Identity);
+
+        // Same seed for every population size: initial weights and mutations are reproducible.
+        FMath::RandInit(Settings.Seed);
+        FMath::SRandInit(Settings.Seed);
+
+        AMazeManager* Manager = World->SpawnActorDeferred<AMazeManager>(AMazeManager::StaticClass(), FTransform::Identity);
+        Manager->AgentBlueprint = Settings.AgentClass;
+        Manager->PopulationSize = PopulationSize;
+        Manager->TimeLimit = Settings.TimeLimit;
+        Manager->Maze = Maze;
+        Manager->StartPosition = Maze->GetCellLocation(0, 0) + FVector(0.f, 0.f, 100.f);
+        Manager->EvolutionMode = Settings.Mode;
+        Manager->bEnableTelemetry = Settings.bTelemetry;
+        Manager->NumMazeInstances = Settings.MazeInstances;
+        Manager->bHeadlessEvaluation = Settings.bHeadless;
+        Manager->HeadlessTimeStep = Settings.DeltaTime;
+        Manager->bParallelAgentUpdate = Settings.bParallelAgentUpdate;
+        Manager->AgentUpdateThreads = UpdateThreads;
+        Manager->FinishSpawning(FTransform::Identity);
+
+        // Safety net in case a mode never completes a generation.
+        const int32 MaxFrames = FMath::CeilToInt32(Settings.Generations * Settings.TimeLimit / Settings.DeltaTime) * 2 + 100;
+
+        TArray<double> FrameMs;
+        TArray<double> AgentUpdateMs;
+        FrameMs.Reserve(MaxFrames);
+        AgentUpdateMs.Reserve(MaxFrames);
+        const int64 StartSteps = FNNMazeFrameCounters::GetTotalInferences();
+        const double StartTime = FPlatformTime::Seconds();
+        while (Manager->GetGenerationCount() < Settings.Generations && FrameMs.Num() < MaxFrames)
+        {
+            const double FrameStart = FPlatformTime::Seconds();
+            World->Tick(LEVELTICK_All, Settings.DeltaTime);
+            GFrameCounter++;
+            FrameMs.Add((FPlatformTime::Seconds() - FrameStart) * 1000.0);
+            if (Manager->GetLastAgentUpdateSeconds() > 0.0)
+            {
+                AgentUpdateMs.Add(Manager->GetLastAgentUpdateSeconds() * 1000.0);
+            }
+        }
+        // Publishes the inferences of the last frame.
+        FNNMazeFrameCounters::PublishFrame();
+
+        OutResult.PopulationSize = PopulationSize;
+        OutResult.UpdateThreads = UpdateThreads;
+        OutResult.Generations = Manager->GetGenerationCount();
+        OutResult.Frames = FrameMs.Num();
+        OutResult.Seconds = FPlatformTime::Seconds() - StartTime;
+        OutResult.GenerationsPerSecond = OutResult.Generations / FMath::Max(OutResult.Seconds, UE_DOUBLE_SMALL_NUMBER);
+        OutResult.AgentStepsPerSecond = (FNNMazeFrameCounters::GetTotalInferences() - StartSteps) / FMath::Max(OutResult.Seconds, UE_DOUBLE_SMALL_NUMBER);
+        OutResult.FrameMsP50 = Percentile(FrameMs, 0.5);
+        OutResult.FrameMsP99 = Percentile(FrameMs, 0.99);
+        OutResult.AgentUpdateMsP50 = Percentile(AgentUpdateMs, 0.5);
+        OutResult.PeakMemoryMB = FPlatformMemory::GetStats().PeakUsedPhysical / (1024.0 * 1024.0);
+
+        GEngine->DestroyWorldContext(World);
+        World->DestroyWorld(false);
+        CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+        if (OutResult.Generations < Settings.Generations)
+        {
+            UE_LOG(LogTemp, Error, TEXT("MazeBenchmark: population %d completed %d of %d generations in %d frames."),
+                PopulationSize, OutResult.Generations, Settings.Generations, OutResult.Frames);
+            return false;
+        }
+        return true;
+    }
+
+    FString BuildReport(const FBenchmarkSettings& Settings, const TMap<FString, double>& GridTimings, const TArray<FBenchmarkResult>& Results)
+    {
+        TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+        Report->SetNumberField(TEXT("seed"), Settings.Seed);
+        Report->SetNumberField(TEXT("generations"), Settings.Generations);
+        Report->SetNumberField(TEXT("time_limit"), Settings.TimeLimit);
+        Report->SetNumberField(TEXT("delta_time"), Settings.DeltaTime);
+        Report->SetNumberField(TEXT("maze_cells"), Settings.MazeCells);
+        Report->SetNumberField(TEXT("block_size"), Settings.BlockSize);
+        Report->SetStringField(TEXT("maze_algorithm"), StaticEnum<EMazeAlgorithm>()->GetNameStringByValue(static_cast<int64>(Settings.MazeAlgorithm)));
+        Report->SetStringField(TEXT("mode"), StaticEnum<EEvolutionMode>()->GetNameStringByValue(static_cast<int64>(Settings.Mode)));
+        Report->SetStringField(TEXT("agent_class"), Settings.AgentClass ? Settings.AgentClass->GetPathName() : FString());
+        Report->SetNumberField(TEXT("maze_instances"), Settings.MazeInstances);
+        Report->SetBoolField(TEXT("headless"), Settings.bHeadless);
+        Report->SetBoolField(TEXT("parallel_agent_update"), Settings.bParallelAgentUpdate);
+        Report->SetNumberField(TEXT("cores"), FPlatformMisc::NumberOfCores());
+        Report->SetNumberField(TEXT("logical_cores"), FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+
+        TSharedRef<FJsonObject> GridGeneration = MakeShared<FJsonObject>();
+        for (const TPair<FString, double>& Timing : GridTimings)
+        {
+            GridGeneration->SetNumberField(Timing.Key, Timing.Value);
+        }
+        Report->SetObjectField(TEXT("grid_generation_ms_512"), GridGeneration);
+
+        TArray<TSharedPtr<FJsonValue>> Runs;
+        for (const FBenchmarkResult& Result : Results)
+        {
+            TSharedRef<FJsonObject> Run = MakeShared<FJsonObject>();
+            Run->SetNumberField(TEXT("population"), Result.PopulationSize);
+            Run->SetNumberField(TEXT("update_threads"), Result.UpdateThreads);
+            Run->SetNumberField(TEXT("generations"), Result.Generations);
+            Run->SetNumberField(TEXT("frames"), Result.Frames);
+            Run->SetNumberField(TEXT("seconds"), Result.Seconds);
+            Run->SetNumberField(TEXT("generations_per_sec"), Result.GenerationsPerSecond);
+            Run->SetNumberField(TEXT("agent_steps_per_sec"), Result.AgentStepsPerSecond);
+            Run->SetNumberField(TEXT("frame_ms_p50"), Result.FrameMsP50);
+            Run->SetNumberField(TEXT("frame_ms_p99"), Result.FrameMsP99);
+            Run->SetNumberField(TEXT("agent_update_ms_p50"), Result.AgentUpdateMsP50);
+            Run->SetNumberField(TEXT("agent_update_speedup"), Result.AgentUpdateSpeedup);
+            Run->SetNumberField(TEXT("peak_memory_mb"), Result.PeakMemoryMB);
+            Runs.Add(MakeShared<FJsonValueObject>(Run));
+        }
+        Report->SetArrayField(TEXT("runs"), Runs);
+
+        FString Output;
+        TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Output);
+        FJsonSerializer::Serialize(Report, Writer);
+        return Output;
+    }
+
+    // Returns the number of population sizes whose throughput regressed by more than Threshold.
+    int32 CompareWithBaseline(const FString& BaselinePath, const TArray<FBenchmarkResult>& Results, float Threshold)
+    {
+        FString BaselineText;
+        TSharedPtr<FJsonObject> Baseline;
+        const TArray<TSharedPtr<FJsonValue>>* BaselineRuns = nullptr;
+        if (!FFileHelper::LoadFileToString(BaselineText, *BaselinePath)
+            || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineText), Baseline)
+            || !Baseline.IsValid()
+            || !Baseline->TryGetArrayField(TEXT("runs"), BaselineRuns))
+        {
+            UE_LOG(LogTemp, Error, TEXT("MazeBenchmark: cannot read baseline report %s"), *BaselinePath);
+            return 1;
+        }
+
+        int32 Regressions = 0;
+        for (const FBenchmarkResult& Result : Results)
+        {
+            const TSharedPtr<FJsonValue>* BaselineRun = BaselineRuns->FindByPredicate([&Result](const TSharedPtr<FJsonValue>& Run)
+                {
+                    int32 Threads = 0;
+                    Run->AsObject()->TryGetNumberField(TEXT("update_threads"), Threads);
+                    return static_cast<int32>(Run->AsObject()->GetNumberField(TEXT("population"))) == Result.PopulationSize && Threads == Result.UpdateThreads;
+                });
+            if (!BaselineRun)
+            {
+                UE_LOG(LogTemp, Warning, TEXT("MazeBenchmark: no baseline for population %d with %d update threads"), Result.PopulationSize, Result.UpdateThreads);
+                continue;
+            }
+
+            auto Check = [&Regressions, &Result, Threshold](const TCHAR* Metric, double Current, double Reference)
+                {
+                    const double Change = Reference > 0.0 ? Current / Reference - 1.0 : 0.0;
+                    if (Change < -Threshold)
+                    {
+                        UE_LOG(LogTemp, Error, TEXT("MazeBenchmark: population %d %s regressed by %.1f%% (%.2f, baseline %.2f)"),
+                            Result.PopulationSize, Metric, -Change * 100.0, Current, Reference);
+                        Regressions++;
+                    }
+                    else
+                    {
+                        UE_LOG(LogTemp, Display, TEXT("MazeBenchmark: population %d %s %+.1f%% vs baseline"), Result.PopulationSize, Metric, Change * 100.0);
+                    }
+                };
+
+            const TSharedPtr<FJsonObject> Run = (*BaselineRun)->AsObject();
+            Check(TEXT("generations_per_sec"), Result.GenerationsPerSecond, Run->GetNumberField(TEXT("generations_per_sec")));
+            Check(TEXT("agent_steps_per_sec"), Result.AgentStepsPerSecond, Run->GetNumberField(TEXT("agent_steps_per_sec")));
+        }
+        return Regressions;
+    }
+}
+
+UMazeBenchmarkCommandlet::UMazeBenchmarkCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UMazeBenchmarkCommandlet::Main(const FString& Params)
+{
+    FBenchmarkSettings Settings;
+    FParse::Value(*Params, TEXT("Generations="), Settings.Generations);
+    FParse::Value(*Params, TEXT("TimeLimit="), Settings.TimeLimit);
+    FParse::Value(*Params, TEXT("DeltaTime="), Settings.DeltaTime);
+    FParse::Value(*Params, TEXT("Seed="), Settings.Seed);
+    FParse::Value(*Params, TEXT("MazeCells="), Settings.MazeCells);
+    FParse::Value(*Params, TEXT("BlockSize="), Settings.BlockSize);
+    Settings.bTelemetry = FParse::Param(*Params, TEXT("Telemetry"));
+    FParse::Value(*Params, TEXT("MazeInstances="), Settings.MazeInstances);
+    Settings.bHeadless = FParse::Param(*Params, TEXT("Headless"));
+    Settings.bParallelAgentUpdate = !FParse::Param(*Params, TEXT("SerialAgentUpdate"));
+
+    FString UpdateThreadsString;
+    if (FParse::Value(*Params, TEXT("UpdateThreads="), UpdateThreadsString, false))
+    {
+        TArray<FString> Parts;
+        UpdateThreadsString.ParseIntoArray(Parts, TEXT(","), true);
+        Settings.UpdateThreads.Reset();
+        for (const FString& Part : Parts)
+        {
+            Settings.UpdateThreads.Add(FMath::Max(0, FCString::Atoi(*Part)));
+        }
+    }
+
+    FString ModeName;
+    if (FParse::Value(*Params, TEXT("Mode="), ModeName))
+    {
+        const int64 ModeValue = StaticEnum<EEvolutionMode>()->GetValueByNameString(ModeName);
+        if (ModeValue == INDEX_NONE)
+        {
+            UE_LOG(LogTemp, Error, TEXT("MazeBenchmark: unknown evolution mode %s"), *ModeName);
+            return 1;
+        }
+        Settings.Mode = static_cast<EEvolutionMode>(ModeValue);
+    }
+
+    FString AlgorithmName;
+    if (FParse::Value(*Params, TEXT("MazeAlgorithm="), AlgorithmName))
+    {
+        const int64 AlgorithmValue = StaticEnum<EMazeAlgorithm>()->GetValueByNameString(AlgorithmName);
+        if (AlgorithmValue == INDEX_NONE)
+        {
+            UE_LOG(LogTemp, Error, TEXT("MazeBenchmark: unknown maze algorithm %s"), *AlgorithmName);
+            return 1;
+        }
+        Settings.MazeAlgorithm = static_cast<EMazeAlgorithm>(AlgorithmValue);
+    }
+
+    FString AgentClassPath = TEXT("/Game/Blueprints/BP_MazeAgent.BP_MazeAgent_C");
+    FParse::Value(*Params, TEXT("AgentClass="), AgentClassPath);
+    Settings.AgentClass = LoadClass<AMazeAgent>(nullptr, *AgentClassPath);
+    if (!Settings.AgentClass)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("MazeBenchmark: cannot load %s, using AMazeAgent"), *AgentClassPath);
+        Settings.AgentClass = AMazeAgent::StaticClass();
+    }
+
+    TArray<int32> Populations = { 100, 1000, 10000 };
+    FString PopulationsString;
+    if (FParse::Value(*Params, TEXT("Populations="), PopulationsString, false))
+    {
+        TArray<FString> Parts;
+        PopulationsString.ParseIntoArray(Parts, TEXT(","), true);
+        Populations.Reset();
+        for (const FString& Part : Parts)
+        {
+            Populations.Add(FMath::Max(2, FCString::Atoi(*Part)));
+        }
+    }
+
+    if (Populations.Num() == 0 || Settings.UpdateThreads.Num() == 0 || Settings.Generations < 1 || Settings.TimeLimit <= 0.f || Settings.DeltaTime <= 0.f || Settings.MazeCells < 1 || Settings.MazeInstances < 1)
+    {
+        UE_LOG(LogTemp, Error, TEXT("MazeBenchmark: invalid parameters."));
+        return 1;
+    }
+
+    // Smallest populations first: peak memory is a process-wide high-water mark.
+    Populations.Sort();
+
+    const TMap<FString, double> GridTimings = BenchmarkGridGeneration(Settings.Seed);
+
+    UE_LOG(LogTemp, Display, TEXT("MazeBenchmark: %d generations of %.1fs at dt %.4f, %dx%d maze, seed %d"),
+        Settings.Generations, Settings.TimeLimit, Settings.DeltaTime, Settings.MazeCells, Settings.MazeCells, Settings.Seed);
+    UE_LOG(LogTemp, Display, TEXT("MazeBenchmark: %s agent update, %d cores (%d logical)"),
+        Settings.bParallelAgentUpdate ? TEXT("parallel") : TEXT("per-actor"), FPlatformMisc::NumberOfCores(), FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+    UE_LOG(LogTemp, Display, TEXT("%10s %8s %10s %14s %12s %12s %12s %9s %12s"),
+        TEXT("Population"), TEXT("Threads"), TEXT("Gen/sec"), TEXT("Steps/sec"), TEXT("p50 ms"), TEXT("p99 ms"), TEXT("Update ms"), TEXT("Speedup"), TEXT("Peak MB"));
+
+    TArray<FBenchmarkResult> Results;
+    bool bAllCompleted = true;
+    for (const int32 PopulationSize : Populations)
+    {
+        // The speedup of a thread count is relative to the first one of the list.
+        const int32 FirstRun = Results.Num();
+        for (const int32 UpdateThreads : Settings.UpdateThreads)
+        {
+            FBenchmarkResult& Result = Results.AddDefaulted_GetRef();
+            bAllCompleted &= RunBenchmark(PopulationSize, UpdateThreads, Settings, Result);
+            Result.AgentUpdateSpeedup = Result.AgentUpdateMsP50 > 0.0 ? Results[FirstRun].AgentUpdateMsP50 / Result.AgentUpdateMsP50 : 1.0;
+            UE_LOG(LogTemp, Display, TEXT("%10d %8d %10.3f %14.0f %12.2f %12.2f %12.3f %9.2f %12.1f"),
+                Result.PopulationSize, Result.UpdateThreads, Result.GenerationsPerSecond, Result.AgentStepsPerSecond,
+                Result.FrameMsP50, Result.FrameMsP99, Result.AgentUpdateMsP50, Result.AgentUpdateSpeedup, Result.PeakMemoryMB);
+        }
+    }
+
+    FString ReportPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("MazeBenchmark.json");
+    FParse::Value(*Params, TEXT("Report="), ReportPath);
+    if (!FFileHelper::SaveStringToFile(BuildReport(Settings, GridTimings, Results), *ReportPath))
+    {
+        UE_LOG(LogTemp, Error, TEXT("MazeBenchmark: cannot write %s"), *ReportPath);
+        return 1;
+    }
+    UE_LOG(LogTemp, Display, TEXT("MazeBenchmark: report written to %s"), *ReportPath);
+
+    FString BaselinePath;
+    if (FParse::Value(*Params, TEXT("Baseline="), BaselinePath))
+    {
+        float Threshold = 0.1f;
+        FParse::Value(*Params, TEXT("Threshold="), Threshold);
+        if (CompareWithBaseline(BaselinePath, Results, Threshold) > 0)
+        {
+            return 1;
+        }
+    }
+
+    return bAllCompleted ? 0 : 1;
+}
@@ -0,0 +1,42 @@
+#include "MazeCollisionComponent.h"
+#include "PhysicsEngine/BodySetup.h"
+
+UMazeCollisionComponent::UMazeCollisionComponent()
+    : BodySetup(nullptr)
+    , LocalBounds(ForceInit)
+{
+    SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+    SetGenerateOverlapEvents(false);
+    bHiddenInGame = true;
+    SetCastShadow(false);
+}
+
+void UMazeCollisionComponent::SetBoxes(const TArray<FBox>& Boxes)
+{
+    BodySetup = NewObject<UBodySetup>(this, NAME_None, RF_Transient);
+    BodySetup->CollisionTraceFlag = CTF_UseSimpleAsComplex;
+    BodySetup->BodySetupGuid = FGuid::NewGuid();
+
+    LocalBounds = FBox(ForceInit);
+    BodySetup->AggGeom.BoxElems.Reserve(Boxes.Num());
+    for (const FBox& Box : Boxes)
+    {
+        const FVector Size = Box.GetSize();
+        FKBoxElem& Element = BodySetup->AggGeom.BoxElems.Emplace_GetRef(Size.X, Size.Y, Size.Z);
+        Element.Center = Box.GetCenter();
+        LocalBounds += Box;
+    }
+
+    // Box shapes need no cooking: the physics state can be rebuilt right away.
+    RecreatePhysicsState();
+    UpdateBounds();
+}
+
+FBoxSphereBounds UMazeCollisionComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+    if (!LocalBounds.IsValid)
+    {
+        return FBoxSphereBounds(LocalToWorld.GetLocation(), FVector::ZeroVector, 0.f);
+    }
+    return FBoxSphereBounds(LocalBounds).TransformBy(LocalToWorld);
+}
@@ -0,0 +1,113 @@
+#include "MazeFlowField.h"
+#include "MazeGrid.h"
+
+namespace
+{
+    // Neighbour K is at yaw K * 45 degrees.
+    const FIntPoint NeighborOffsets[8] = {
+        { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 }
+    };
+
+    struct FOpenBlock
+    {
+        float Distance;
+        int32 Index;
+
+        bool operator<(const FOpenBlock& Other) const { return Distance < Other.Distance; }
+    };
+}
+
+void FMazeFlowField::Reset()
+{
+    Width = 0;
+    Height = 0;
+    ExitBlock = FIntPoint(INDEX_NONE, INDEX_NONE);
+    MaxDistance = 0.f;
+    Distances.Empty();
+    Directions.Empty();
+}
+
+void FMazeFlowField::Build(const FMazeGrid& Grid, const FIntPoint& InExitBlock)
+{
+    const double StartTime = FPlatformTime::Seconds();
+
+    Width = Grid.GetWidth();
+    Height = Grid.GetHeight();
+    ExitBlock = InExitBlock;
+    MaxDistance = 0.f;
+    Distances.Init(-1.f, Width * Height);
+    Directions.Init(NoDirection, Width * Height);
+    if (ExitBlock.X < 0 || ExitBlock.Y < 0 || ExitBlock.X >= Width || ExitBlock.Y >= Height)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Flow field: exit block (%d, %d) is outside the maze"), ExitBlock.X, ExitBlock.Y);
+        return;
+    }
+
+    // Dijkstra from the exit: each block records the direction of the neighbour it was reached from,
+    // which is the first step of its shortest path to the exit.
+    TArray<FOpenBlock> Open;
+    Open.HeapPush({ 0.f, ExitBlock.Y * Width + ExitBlock.X });
+    Distances[Open[0].Index] = 0.f;
+    while (Open.Num() > 0)
+    {
+        FOpenBlock Current;
+        Open.HeapPop(Current, EAllowShrinking::No);
+        if (Current.Distance > Distances[Current.Index])
+        {
+            // Stale entry, the block was reached by a shorter path since.
+            continue;
+        }
+        MaxDistance = FMath::Max(MaxDistance, Current.Distance);
+
+        const int32 X = Current.Index % Width;
+        const int32 Y = Current.Index / Width;
+        for (int32 K = 0; K < 8; K++)
+        {
+            const FIntPoint& Offset = NeighborOffsets[K];
+            const int32 NeighborX = X + Offset.X;
+            const int32 NeighborY = Y + Offset.Y;
+            const bool bDiagonal = Offset.X != 0 && Offset.Y != 0;
+            if (Grid.IsWall(NeighborX, NeighborY) || (bDiagonal && (Grid.IsWall(NeighborX, Y) || Grid.IsWall(X, NeighborY))))
+            {
+                continue;
+            }
+
+            const int32 NeighborIndex = NeighborY * Width + NeighborX;
+            const float NeighborDistance = Current.Distance + (bDiagonal ? UE_SQRT_2 : 1.f);
+            if (Distances[NeighborIndex] < 0.f || NeighborDistance < Distances[NeighborIndex])
+            {
+                Distances[NeighborIndex] = NeighborDistance;
+                // The neighbour steps back along the opposite direction.
+                Directions[NeighborIndex] = static_cast<uint8>((K + 4) % 8);
+                Open.HeapPush({ NeighborDistance, NeighborIndex });
+            }
+        }
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Flow field %dx%d to (%d, %d) built in %.2f ms, longest path %.1f blocks"),
+        Width, Height, ExitBlock.X, ExitBlock.Y, (FPlatformTime::Seconds() - StartTime) * 1000.0, MaxDistance);
+}
+
+int32 FMazeFlowField::GetIndex(const FVector2D& GridPosition) const
+{
+    const int32 X = FMath::FloorToInt32(GridPosition.X);
+    const int32 Y = FMath::FloorToInt32(GridPosition.Y);
+    return X >= 0 && Y >= 0 && X < Width && Y < Height ? Y * Width + X : INDEX_NONE;
+}
+
+float FMazeFlowField::GetDistance(const FVector2D& GridPosition) const
+{
+    const int32 Index = GetIndex(GridPosition);
+    return Index != INDEX_NONE ? Distances[Index] : -1.f;
+}
+
+bool FMazeFlowField::GetDirectionYaw(const FVector2D& GridPosition, float& OutYaw) const
+{
+    const int32 Index = GetIndex(GridPosition);
+    if (Index == INDEX_NONE || Directions[Index] == NoDirection)
+    {
+        return false;
+    }
+    OutYaw = Directions[Index] * 45.f;
+    return true;
+}
@@ -0,0 +1,300 @@
+#include "MazeGrid.h"
+#include "Hash/CityHash.h"
+
+namespace
+{
+    const FIntPoint CellOffsets[] = { FIntPoint(1, 0), FIntPoint(-1, 0), FIntPoint(0, 1), FIntPoint(0, -1) };
+
+    bool IsInside(const FIntPoint& Cell, int32 CellsX, int32 CellsY)
+    {
+        return Cell.X >= 0 && Cell.Y >= 0 && Cell.X < CellsX && Cell.Y < CellsY;
+    }
+
+    // A cell still surrounded by walls has not been reached by the generator yet.
+    bool IsUncarvedCell(const FMazeGrid& Grid, const FIntPoint& Cell, int32 CellsX, int32 CellsY)
+    {
+        return IsInside(Cell, CellsX, CellsY) && Grid.IsWall(2 * Cell.X + 1, 2 * Cell.Y + 1);
+    }
+
+    // Opens the wall between two adjacent cells and carves the destination cell.
+    void ConnectCells(FMazeGrid& Grid, const FIntPoint& From, const FIntPoint& To)
+    {
+        Grid.SetWall(From.X + To.X + 1, From.Y + To.Y + 1, false);
+        Grid.SetWall(2 * To.X + 1, 2 * To.Y + 1, false);
+    }
+}
+
+FMazeGrid::FMazeGrid()
+    : Width(0)
+    , Height(0)
+{
+}
+
+FMazeGrid FMazeGrid::Generate(const FMazeGenerationSettings& Settings)
+{
+    const int32 CellsX = FMath::Max(1, Settings.CellsX);
+    const int32 CellsY = FMath::Max(1, Settings.CellsY);
+
+    FMazeGrid Grid;
+    Grid.Resize(2 * CellsX + 1, 2 * CellsY + 1, true);
+
+    FRandomStream RandomStream(Settings.Seed);
+    switch (Settings.Algorithm)
+    {
+    case EMazeAlgorithm::Prim:
+        Grid.CarvePrim(CellsX, CellsY, RandomStream);
+        break;
+    case EMazeAlgorithm::Rooms:
+        Grid.CarveBacktracker(CellsX, CellsY, RandomStream);
+        Grid.CarveRooms(CellsX, CellsY, Settings.RoomCount, Settings.RoomMaxSize, RandomStream);
+        break;
+    default:
+        Grid.CarveBacktracker(CellsX, CellsY, RandomStream);
+        break;
+    }
+    return Grid;
+}
+
+void FMazeGrid::SetWall(int32 X, int32 Y, bool bWall)
+{
+    check(X >= 0 && Y >= 0 && X < Width && Y < Height);
+    const int32 Index = Y * Width + X;
+    const uint64 Mask = 1ull << (Index & 63);
+    if (bWall)
+    {
+        Bits[Index >> 6] |= Mask;
+    }
+    else
+    {
+        Bits[Index >> 6] &= ~Mask;
+    }
+}
+
+void FMazeGrid::Resize(int32 InWidth, int32 InHeight, bool bWall)
+{
+    Width = InWidth;
+    Height = InHeight;
+    Bits.Init(bWall ? ~0ull : 0ull, (Width * Height + 63) / 64);
+}
+
+void FMazeGrid::CarveBacktracker(int32 CellsX, int32 CellsY, FRandomStream& RandomStream)
+{
+    // Iterative depth-first search: the explicit stack avoids recursion depth issues on large mazes.
+    TArray<FIntPoint> Stack;
+    Stack.Reserve(CellsX * CellsY);
+    SetWall(1, 1, false);
+    Stack.Add(FIntPoint(0, 0));
+
+    while (Stack.Num() > 0)
+    {
+        const FIntPoint Cell = Stack.Last();
+
+        FIntPoint Candidates[4];
+        int32 NumCandidates = 0;
+        for (const FIntPoint& Offset : CellOffsets)
+        {
+            const FIntPoint Next = Cell + Offset;
+            if (IsUncarvedCell(*this, Next, CellsX, CellsY))
+            {
+                Candidates[NumCandidates++] = Next;
+            }
+        }
+
+        if (NumCandidates == 0)
+        {
+            Stack.Pop(EAllowShrinking::No);
+            continue;
+        }
+
+        const FIntPoint Next = Candidates[RandomStream.RandHelper(NumCandidates)];
+        ConnectCells(*this, Cell, Next);
+        Stack.Add(Next);
+    }
+}
+
+void FMazeGrid::CarvePrim(int32 CellsX, int32 CellsY, FRandomStream& RandomStream)
+{
+    TBitArray<> InFrontier(false, CellsX * CellsY);
+    TArray<FIntPoint> Frontier;
+
+    auto AddNeighborsToFrontier = [this, &InFrontier, &Frontier, CellsX, CellsY](const FIntPoint& Cell)
+        {
+            for (const FIntPoint& Offset : CellOffsets)
+            {
+                const FIntPoint Next = Cell + Offset;
+                if (IsUncarvedCell(*this, Next, CellsX, CellsY) && !InFrontier[Next.Y * CellsX + Next.X])
+                {
+                    InFrontier[Next.Y * CellsX + Next.X] = true;
+                    Frontier.Add(Next);
+                }
+            }
+        };
+
+    const FIntPoint Start(RandomStream.RandHelper(CellsX), RandomStream.RandHelper(CellsY));
+    SetWall(2 * Start.X + 1, 2 * Start.Y + 1, false);
+    AddNeighborsToFrontier(Start);
+
+    while (Frontier.Num() > 0)
+    {
+        const int32 Pick = RandomStream.RandHelper(Frontier.Num());
+        const FIntPoint Cell = Frontier[Pick];
+        Frontier.RemoveAtSwap(Pick, 1, EAllowShrinking::No);
+
+        // Attach the frontier cell to a random carved neighbor.
+        FIntPoint Carved[4];
+        int32 NumCarved = 0;
+        for (const FIntPoint& Offset : CellOffsets)
+        {
+            const FIntPoint Neighbor = Cell + Offset;
+            if (IsInside(Neighbor, CellsX, CellsY) && !IsWall(2 * Neighbor.X + 1, 2 * Neighbor.Y + 1))
+            {
+                Carved[NumCarved++] = Neighbor;
+            }
+        }
+        ConnectCells(*this, Carved[RandomStream.RandHelper(NumCarved)], Cell);
+        AddNeighborsToFrontier(Cell);
+    }
+}
+
+void FMazeGrid::CarveRooms(int32 CellsX, int32 CellsY, int32 RoomCount, int32 RoomMaxSize, FRandomStream& RandomStream)
+{
+    for (int32 Room = 0; Room < RoomCount; Room++)
+    {
+        const int32 RoomWidth = FMath::Min(RandomStream.RandRange(2, FMath::Max(2, RoomMaxSize)), CellsX);
+        const int32 RoomHeight = FMath::Min(RandomStream.RandRange(2, FMath::Max(2, RoomMaxSize)), CellsY);
+        const int32 RoomX = RandomStream.RandRange(0, CellsX - RoomWidth);
+        const int32 RoomY = RandomStream.RandRange(0, CellsY - RoomHeight);
+
+        // Clear every block inside the room; the outer border of the maze is left untouched.
+        for (int32 Y = 2 * RoomY + 1; Y < 2 * (RoomY + RoomHeight); Y++)
+        {
+            for (int32 X = 2 * RoomX + 1; X < 2 * (RoomX + RoomWidth); X++)
+            {
+                SetWall(X, Y, false);
+            }
+        }
+    }
+}
+
+float FMazeGrid::Raycast(const FVector2D& Start, const FVector2D& Direction, float MaxDistance) const
+{
+    int32 X = FMath::FloorToInt32(Start.X);
+    int32 Y = FMath::FloorToInt32(Start.Y);
+    if (IsWall(X, Y))
+    {
+        return 0.f;
+    }
+
+    // Amanatides-Woo traversal: distance along the ray to the next vertical and horizontal block boundary.
+    const int32 StepX = Direction.X >= 0.0 ? 1 : -1;
+    const int32 StepY = Direction.Y >= 0.0 ? 1 : -1;
+    const double DeltaX = Direction.X != 0.0 ? FMath::Abs(1.0 / Direction.X) : UE_DOUBLE_BIG_NUMBER;
+    const double DeltaY = Direction.Y != 0.0 ? FMath::Abs(1.0 / Direction.Y) : UE_DOUBLE_BIG_NUMBER;
+    double SideX = (StepX > 0 ? X + 1 - Start.X : Start.X - X) * DeltaX;
+    double SideY = (StepY > 0 ? Y + 1 - Start.Y : Start.Y - Y) * DeltaY;
+
+    while (true)
+    {
+        double Distance;
+        if (SideX < SideY)
+        {
+            Distance = SideX;
+            SideX += DeltaX;
+            X += StepX;
+        }
+        else
+        {
+            Distance = SideY;
+            SideY += DeltaY;
+            Y += StepY;
+        }
+
+        if (Distance >= MaxDistance)
+        {
+            return MaxDistance;
+        }
+        // Also terminates the walk when the ray leaves the grid.
+        if (IsWall(X, Y))
+        {
+            return static_cast<float>(Distance);
+        }
+    }
+}
+
+bool FMazeGrid::OverlapsWall(const FVector2D& Center, float Radius) const
+{
+    const int32 MinX = FMath::FloorToInt32(Center.X - Radius);
+    const int32 MaxX = FMath::FloorToInt32(Center.X + Radius);
+    const int32 MinY = FMath::FloorToInt32(Center.Y - Radius);
+    const int32 MaxY = FMath::FloorToInt32(Center.Y + Radius);
+    for (int32 Y = MinY; Y <= MaxY; Y++)
+    {
+        for (int32 X = MinX; X <= MaxX; X++)
+        {
+            if (IsWall(X, Y))
+            {
+                const FVector2D Closest(FMath::Clamp<double>(Center.X, X, X + 1), FMath::Clamp<double>(Center.Y, Y, Y + 1));
+                if (FVector2D::DistSquared(Center, Closest) < Radius * Radius)
+                {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+TArray<FIntRect> FMazeGrid::BuildWallRectangles() const
+{
+    TArray<FIntRect> Rectangles;
+    TBitArray<> Covered(false, Width * Height);
+
+    for (int32 Y = 0; Y < Height; Y++)
+    {
+        for (int32 X = 0; X < Width; X++)
+        {
+            if (!IsWall(X, Y) || Covered[Y * Width + X])
+            {
+                continue;
+            }
+
+            // Longest run of uncovered walls on this row...
+            int32 EndX = X + 1;
+            while (EndX < Width && IsWall(EndX, Y) && !Covered[Y * Width + EndX])
+            {
+                EndX++;
+            }
+
+            // ...extended downwards while the rows below contain the same run.
+            int32 EndY = Y + 1;
+            for (bool bRowMatches = true; bRowMatches && EndY < Height; )
+            {
+                for (int32 RunX = X; RunX < EndX; RunX++)
+                {
+                    if (!IsWall(RunX, EndY) || Covered[EndY * Width + RunX])
+                    {
+                        bRowMatches = false;
+                        break;
+                    }
+                }
+                if (bRowMatches)
+                {
+                    EndY++;
+                }
+            }
+
+            for (int32 RectY = Y; RectY < EndY; RectY++)
+            {
+                Covered.SetRange(RectY * Width + X, EndX - X, true);
+            }
+            Rectangles.Add(FIntRect(X, Y, EndX, EndY));
+        }
+    }
+    return Rectangles;
+}
+
+uint64 FMazeGrid::GetHash() const
+{
+    const uint64 Dimensions = (static_cast<uint64>(Width) << 32) | static_cast<uint32>(Height);
+    return CityHash64WithSeed(reinterpret_cast<const char*>(Bits.GetData()), Bits.Num() * sizeof(uint64), Dimensions);
+}
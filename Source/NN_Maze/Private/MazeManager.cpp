@@ -5,6 +5,50 @@
 #include "Engine/World.h"
 #include "TimerManager.h"
 #include "Kismet/GameplayStatics.h"
+#include "EngineUtils.h"
+#include "Checkpoint.h"
+#include "Hash/CityHash.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "NNMazeStats.h"
+#include "ProceduralMaze.h"
+#include "MazeSimulation.h"
+#include "Async/ParallelFor.h"
+#include "Algo/Sort.h"
+#include "ChampionSnapshot.h"
+
+namespace
+{
+    TArray<float> GatherFitness(const TArray<UNeuralNetwork*>& Population)
+    {
+        TArray<float> Fitness;
+        Fitness.Reserve(Population.Num());
+        for (const UNeuralNetwork* Network : Population)
+        {
+            if (Network)
+            {
+                Fitness.Add(Network->Fitness);
+            }
+        }
+        return Fitness;
+    }
+
+    float AggregateFitness(TConstArrayView<float> Values, EFitnessAggregation Aggregation)
+    {
+        if (Values.Num() == 0)
+        {
+            return 0.f;
+        }
+
+        float Result = Aggregation == EFitnessAggregation::Min ? Values[0] : 0.f;
+        for (const float Value : Values)
+        {
+            Result = Aggregation == EFitnessAggregation::Min ? FMath::Min(Result, Value) : Result + Value;
+        }
+        return Aggregation == EFitnessAggregation::Min ? Result : Result / Values.Num();
+    }
+}
 
 AMazeManager::AMazeManager()
 {
@@ -19,6 +63,55 @@ AMazeManager::AMazeManager()
     GenerationFitnessMean = 0.f;
     TotalSimulationTime = 0.f;
     TotalSimulations = 0;
+    GenerationSimulations = 0;
+    bUseFitnessCache = false;
+    FitnessCacheCapacity = 4096;
+    CoordinatorPort = 7878;
+    DistributedBatchSize = 8;
+    BatchTimeoutSeconds = 60.f;
+    StragglerSeconds = 20.f;
+    MaxBatchRetries = 3;
+    LocalWorkerCount = 0;
+    EvaluationRole = EEvaluationRole::Local;
+    bHasBatch = false;
+    EvolutionMode = EEvolutionMode::Generational;
+    PipelineBatchSize = 0;
+    EvaluationsSinceReport = 0;
+    bEnableTelemetry = true;
+    TelemetrySampleInterval = 0.5f;
+    LastTelemetryRecordTime = 0.0;
+    SimulatedTimeSinceRecord = 0.f;
+    TelemetrySampleElapsed = 0.f;
+    TelemetryOverheadCycles = 0;
+    bRecordTrajectories = false;
+    TrajectorySampleInterval = 0.1f;
+    TrajectoryQuantum = 2.f;
+    NumReplays = 10;
+    ReplayFileName = TEXT("TopRuns");
+    TrajectorySampleElapsed = 0.f;
+    bReplaysChanged = false;
+    NumChampionAgents = 0;
+    BestRecentFitness = -MAX_flt;
+    NumMazeInstances = 1;
+    bVaryMazeInstanceSeeds = true;
+    MazeInstanceSpacing = 500.f;
+    FitnessAggregation = EFitnessAggregation::Mean;
+    SelectionObjectives = { EMazeObjective::Progress, EMazeObjective::Collisions };
+    bHeadlessEvaluation = false;
+    HeadlessTimeStep = 1.f / 30.f;
+    bRecurrentNetwork = false;
+    RecurrentStateSize = 0;
+    bParallelAgentUpdate = true;
+    AgentUpdateThreads = 0;
+    LastAgentUpdateSeconds = 0.0;
+    bAcceleratedTraining = false;
+    SimulationSpeed = 16.f;
+    FixedTimeStep = 1.f / 30.f;
+    SubstepBudgetMs = 12.f;
+    SubstepBacklog = 0.f;
+    EffectiveSimulationSpeed = 0.f;
+    SimulationTime = 0.0;
+    GenerationEndTime = -1.0;
 }
 
 void AMazeManager::BeginPlay()
@@ -27,49 +120,321 @@ void AMazeManager::BeginPlay()
 
     UE_LOG(LogTemp, Log, TEXT("MazeManager BeginPlay: Starting Generation %d"), GenerationCount);
 
+    if (!Maze)
+    {
+        TActorIterator<AProceduralMaze> MazeIt(GetWorld());
+        Maze = MazeIt ? *MazeIt : nullptr;
+    }
+    if (bAcceleratedTraining && !Maze)
+    {
+        // Unswept substeps would tunnel through walls that only the physics scene knows about.
+        UE_LOG(LogTemp, Warning, TEXT("Accelerated training requires a procedural maze, training in real time."));
+        bAcceleratedTraining = false;
+    }
+    if (bAcceleratedTraining && (SimulationSpeed <= 0.f || FixedTimeStep <= 0.f))
+    {
+        // Without a pace, every frame would spend its whole substep budget.
+        UE_LOG(LogTemp, Warning, TEXT("Accelerated training needs a positive SimulationSpeed and FixedTimeStep (%.2f, %.4f), using x1 and 1/30 s."),
+            SimulationSpeed, FixedTimeStep);
+        SimulationSpeed = SimulationSpeed > 0.f ? SimulationSpeed : 1.f;
+        FixedTimeStep = FixedTimeStep > 0.f ? FixedTimeStep : 1.f / 30.f;
+    }
+
+    UClass* EvolutionClass = EvolutionManagerClass ? EvolutionManagerClass.Get() : UEvolutionManager::StaticClass();
+    EvolutionManager = NewObject<UEvolutionManager>(this, EvolutionClass);
+    EvolutionManager->bUseFitnessCache = bUseFitnessCache;
+    EvolutionManager->FitnessCacheCapacity = FitnessCacheCapacity;
+
+    if (!EvolutionManager->SupportsIncrementalBreeding() && EvolutionMode != EEvolutionMode::Generational)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("%s breeds whole generations, which only the generational mode supports."), *EvolutionClass->GetName());
+        EvolutionMode = EEvolutionMode::Generational;
+    }
+    if (bRecurrentNetwork && !EvolutionManager->UsesFixedTopology())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("%s breeds variable-topology genomes, recurrent layers are disabled."), *EvolutionClass->GetName());
+        bRecurrentNetwork = false;
+    }
+
+    ConfigureEvaluationRole();
+    SpawnMazeInstances();
+    if (EvolutionManager->bUseFitnessCache && !(EvaluationRole == EEvaluationRole::Local && (bHeadlessEvaluation || IsAcceleratedTraining())))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("The fitness cache requires local fixed-step evaluation (headless or accelerated), disabling it."));
+        EvolutionManager->bUseFitnessCache = false;
+    }
+    if (EvolutionManager->bUseNoveltySearch)
+    {
+        if (EvaluationRole != EEvaluationRole::Local || EvolutionMode != EEvolutionMode::Generational)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Novelty search requires the local generational mode, selecting on fitness."));
+            EvolutionManager->bUseNoveltySearch = false;
+        }
+        else if (EvolutionManager->bUseFitnessCache)
+        {
+            // Cached genomes would have no behaviour, and the score changes with the archive anyway.
+            UE_LOG(LogTemp, Warning, TEXT("Novelty search disables the fitness cache."));
+            EvolutionManager->bUseFitnessCache = false;
+        }
+    }
+    if (EvolutionManager->bUseMultiObjective)
+    {
+        if (EvaluationRole != EEvaluationRole::Local || EvolutionMode != EEvolutionMode::Generational || SelectionObjectives.Num() < 2)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Multi-objective selection requires the local generational mode and two objectives, selecting on fitness."));
+            EvolutionManager->bUseMultiObjective = false;
+        }
+        else
+        {
+            if (EvolutionManager->bUseNoveltySearch)
+            {
+                UE_LOG(LogTemp, Warning, TEXT("Multi-objective selection replaces novelty search."));
+                EvolutionManager->bUseNoveltySearch = false;
+            }
+            if (EvolutionManager->bUseFitnessCache)
+            {
+                // The cache only holds the scalar fitness.
+                UE_LOG(LogTemp, Warning, TEXT("Multi-objective selection disables the fitness cache."));
+                EvolutionManager->bUseFitnessCache = false;
+            }
+        }
+    }
+    EvolutionManager->SetEnvironmentHash(ComputeEnvironmentHash());
+    if (EvaluationRole == EEvaluationRole::Worker)
+    {
+        // Workers only simulate the batches they receive; see TickWorker().
+        return;
+    }
+
+    if (bEnableTelemetry)
+    {
+        Telemetry = MakeUnique<FMazeTelemetry>();
+        if (!Telemetry->Start(FString::Printf(TEXT("NNMaze_%s"), *FDateTime::Now().ToString())))
+        {
+            Telemetry.Reset();
+        }
+        LastTelemetryRecordTime = FPlatformTime::Seconds();
+    }
+
+    if (bRecordTrajectories)
+    {
+        if (EvaluationRole == EEvaluationRole::Local && !bHeadlessEvaluation)
+        {
+            TrajectoryRecorder = MakeUnique<FMazeTrajectoryRecorder>();
+        }
+        else
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Trajectories are only recorded from the agents of a local in-world evaluation."));
+        }
+    }
+
     // Initialize neural networks for the current generation
     InitAgentNetworks();
+    SpawnChampionAgents();
+
+    if (EvaluationRole == EEvaluationRole::Coordinator)
+    {
+        // No local agents: the generation is evaluated by the workers.
+        SubmitGenerationToWorkers();
+        bIsTraining = true;
+        return;
+    }
+
+    if (bHeadlessEvaluation)
+    {
+        // No agents: Tick() simulates a whole generation per frame.
+        bIsTraining = false;
+        return;
+    }
+
     // Create agents and assign them their neural networks
     CreateAgents();
+
+    if (EvolutionMode != EEvolutionMode::Generational)
+    {
+        // No generation timer: every agent has its own TimeLimit, see TickSteadyState().
+        AgentAwaitingChild.Init(false, Agents.Num());
+        bIsTraining = true;
+        return;
+    }
+
     // Set the timer to end the generation
-    GetWorld()->GetTimerManager().SetTimer(TimerHandle_CloseTimer, this, &AMazeManager::CloseTimer, TimeLimit, false);
+    StartGenerationTimer();
     bIsTraining = true;
+}
+
+void AMazeManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (Coordinator)
+    {
+        // Also tells the workers to exit.
+        Coordinator->Shutdown();
+        Coordinator.Reset();
+    }
+    for (FProcHandle& WorkerProcess : LocalWorkerProcesses)
+    {
+        FPlatformProcess::CloseProc(WorkerProcess);
+    }
+    LocalWorkerProcesses.Empty();
+    WorkerClient.Reset();
 
-    EvolutionManager = NewObject<UEvolutionManager>(this, UEvolutionManager::StaticClass());
+    // Runs kept since the last save (steady-state modes save once per population's worth of evaluations).
+    SaveReplays();
+
+    if (Telemetry)
+    {
+        // Writes the records still queued.
+        Telemetry->Shutdown();
+        Telemetry.Reset();
+    }
+
+    Super::EndPlay(EndPlayReason);
 }
 
 void AMazeManager::Tick(float DeltaTime)
 {
     Super::Tick(DeltaTime);
+    NNMAZE_SCOPE(ManagerTick);
 
-    if (bIsTraining)
+    FNNMazeFrameCounters::PublishFrame();
+
+    if (IsAcceleratedTraining())
     {
-        TotalSimulationTime += DeltaTime;
+        TickAccelerated(DeltaTime);
+    }
+    else
+    {
+        StepSimulation(DeltaTime);
     }
+    TickChampionAgents();
 
     // Display debug information on screen
     FString DebugMessage = FString::Printf(TEXT("Simulation Time: %.2f sec, Total Simulations: %d, Generation: %d"),
         TotalSimulationTime, TotalSimulations, GenerationCount);
+    if (IsAcceleratedTraining())
+    {
+        DebugMessage += FString::Printf(TEXT(", Speed: x%.1f"), EffectiveSimulationSpeed);
+    }
     if (GEngine)
     {
         GEngine->AddOnScreenDebugMessage(-1, 0.f, FColor::Yellow, DebugMessage);
     }
+}
+
+void AMazeManager::TickAccelerated(float DeltaTime)
+{
+    // The frame only paces the simulation: it always advances by FixedTimeStep, so the fitness does not depend
+    // on SimulationSpeed or on the frame rate.
+    SubstepBacklog += DeltaTime * SimulationSpeed;
+    if (SubstepBacklog < FixedTimeStep)
+    {
+        // Less than a substep is due (slow motion, or a very short frame): nothing to simulate this frame.
+        EffectiveSimulationSpeed = 0.f;
+        return;
+    }
+
+    const double Deadline = FPlatformTime::Seconds() + SubstepBudgetMs / 1000.0;
+    int32 Substeps = 0;
+    while (SubstepBacklog >= FixedTimeStep)
+    {
+        StepSimulation(FixedTimeStep);
+        SubstepBacklog -= FixedTimeStep;
+        Substeps++;
+        if (FPlatformTime::Seconds() >= Deadline)
+        {
+            // Slower than requested: drop the backlog instead of stalling the following frames.
+            SubstepBacklog = 0.f;
+            break;
+        }
+    }
+    SubstepBacklog = FMath::Max(SubstepBacklog, 0.f);
+    EffectiveSimulationSpeed = DeltaTime > 0.f ? Substeps * FixedTimeStep / DeltaTime : 0.f;
+}
+
+void AMazeManager::StepSimulation(float DeltaTime)
+{
+    if (IsAcceleratedTraining())
+    {
+        SimulationTime += DeltaTime;
+    }
+    if (bIsTraining)
+    {
+        TotalSimulationTime += DeltaTime;
+    }
+    // Sensing, inference and movement only touch the agents still running.
+    CompactActiveAgents();
+    if (Telemetry && !bHeadlessEvaluation)
+    {
+        SampleActiveAgents(DeltaTime);
+    }
 
+    if (EvaluationRole == EEvaluationRole::Coordinator)
+    {
+        TickCoordinator();
+    }
+    else if (EvaluationRole == EEvaluationRole::Worker)
+    {
+        TickWorker();
+    }
+    else if (EvolutionMode != EEvolutionMode::Generational)
+    {
+        TickSteadyState();
+    }
+    else if (bIsTraining && ActiveAgentIndices.Num() == 0
+        && (GenerationEndTime >= 0.0 || GetWorld()->GetTimerManager().IsTimerActive(TimerHandle_CloseTimer)))
+    {
+        // Every agent is dead: nothing can change the fitness before the timer fires.
+        GetWorld()->GetTimerManager().ClearTimer(TimerHandle_CloseTimer);
+        CloseTimer();
+    }
     // If training time is over, process the evolution cycle
-    if (!bIsTraining)
+    else if (!bIsTraining)
     {
         ProcessGeneration();
     }
 
-    // Optionally update agentseach agents own Tick handles its neural network processing
+    // Managed update of the active agents (otherwise each agents own Tick handles its neural network processing)
     UpdateAgents(DeltaTime);
+    if (TrajectoryRecorder)
+    {
+        SampleTrajectories(DeltaTime);
+    }
+
+    // Accelerated training: the generation ends after TimeLimit simulated seconds, like the timer after the agent ticks.
+    if (bIsTraining && GenerationEndTime >= 0.0 && SimulationTime >= GenerationEndTime - UE_KINDA_SMALL_NUMBER)
+    {
+        CloseTimer();
+    }
+}
+
+void AMazeManager::StartGenerationTimer()
+{
+    if (IsAcceleratedTraining())
+    {
+        // TimeLimit counts simulated seconds, see StepSimulation().
+        GenerationEndTime = SimulationTime + TimeLimit;
+        return;
+    }
+    GetWorld()->GetTimerManager().SetTimer(TimerHandle_CloseTimer, this, &AMazeManager::CloseTimer, TimeLimit, false);
+}
+
+float AMazeManager::GetSimulationTime() const
+{
+    return IsAcceleratedTraining() ? static_cast<float>(SimulationTime) : GetWorld()->GetTimeSeconds();
+}
+
+bool AMazeManager::IsAcceleratedTraining() const
+{
+    return bAcceleratedTraining && Maze && EvaluationRole == EEvaluationRole::Local && !bHeadlessEvaluation;
 }
 
 void AMazeManager::CloseTimer()
 {
     GenerationCount++;
-    TotalSimulations += PopulationSize;
+    TotalSimulations += GenerationSimulations;
+    GenerationSimulations = 0;
     bIsTraining = false;
+    GenerationEndTime = -1.0;
     UE_LOG(LogTemp, Log, TEXT("Generation %d complete. Total simulations: %d"), GenerationCount, TotalSimulations);
 }
 
@@ -96,9 +461,7 @@ void AMazeManager::InitAgentNetworks()
             UE_LOG(LogTemp, Error, TEXT("Failed to create neural network for agent %d"), i);
             continue;
         }
-        Net->Initialize(LayerConfig);
-        // Apply an initial mutation for diversity (tune the mutation probability as needed)
-        Net->Mutate(0.5f);
+        EvolutionManager->InitializeNetwork(Net, LayerConfig, bRecurrentNetwork);
         CurrentGeneration.Add(Net);
     }
     UE_LOG(LogTemp, Log, TEXT("Initialized %d neural networks for the current generation."), CurrentGeneration.Num());
@@ -106,6 +469,8 @@ void AMazeManager::InitAgentNetworks()
 
 void AMazeManager::CreateAgents()
 {
+    NNMAZE_PHASE_SCOPE(Spawning);
+
     UE_LOG(LogTemp, Log, TEXT("CreateAgents() called. PopulationSize: %d"), PopulationSize);
 
     // Safely destroy existing agents.
@@ -125,75 +490,1094 @@ void AMazeManager::CreateAgents()
         return;
     }
 
-    // Spawn new agents and assign each its corresponding neural network.
+    // Genomes already evaluated in this environment take their cached fitness and are not simulated again.
+    TBitArray<> Cached(false, PopulationSize);
     for (int32 i = 0; i < PopulationSize; i++)
     {
-        FVector SpawnLocation = StartPosition;
-        FRotator SpawnRotation = FRotator::ZeroRotator;
-        UE_LOG(LogTemp, Log, TEXT("Spawning Agent %d at location %s"), i, *SpawnLocation.ToString());
+        Cached[i] = EvolutionManager && CurrentGeneration.IsValidIndex(i) && EvolutionManager->ApplyCachedFitness(CurrentGeneration[i]);
+    }
+    GenerationSimulations = PopulationSize - Cached.CountSetBits();
 
-        // Spawn the agent safely
-        AMazeAgent* NewAgent = GetWorld()->SpawnActor<AMazeAgent>(AgentBlueprint, SpawnLocation, SpawnRotation);
-        if (!NewAgent)
+    // Spawn new agents and assign each its corresponding neural network, once per maze instance.
+    // Agents stay index-aligned with CurrentGeneration: genomes that are not simulated get a null entry.
+    const int32 NumInstances = FMath::Max(1, MazeInstances.Num());
+    Agents.Reserve(PopulationSize * NumInstances);
+    for (int32 Instance = 0; Instance < NumInstances; Instance++)
+    {
+        const FVector InstanceOffset = GetMazeInstanceOffset(Instance);
+        for (int32 i = 0; i < PopulationSize; i++)
         {
-            UE_LOG(LogTemp, Error, TEXT("Failed to spawn agent %d"), i);
-            continue;
+            if (Cached[i])
+            {
+                Agents.Add(nullptr);
+                continue;
+            }
+
+            FVector SpawnLocation = StartPosition + InstanceOffset;
+            FRotator SpawnRotation = FRotator::ZeroRotator;
+            UE_LOG(LogTemp, Log, TEXT("Spawning Agent %d at location %s"), i, *SpawnLocation.ToString());
+
+            // Spawn the agent safely
+            AMazeAgent* NewAgent = GetWorld()->SpawnActor<AMazeAgent>(AgentBlueprint, SpawnLocation, SpawnRotation);
+            if (!NewAgent)
+            {
+                UE_LOG(LogTemp, Error, TEXT("Failed to spawn agent %d"), i);
+                Agents.Add(nullptr);
+                continue;
+            }
+
+            // Verify that a neural network exists for this index; if not, log warning.
+            if (CurrentGeneration.IsValidIndex(i) && CurrentGeneration[i])
+            {
+                NewAgent->NeuralNet = CurrentGeneration[i];
+            }
+            else
+            {
+                UE_LOG(LogTemp, Warning, TEXT("CurrentGeneration does not have a valid neural network at index %d"), i);
+                NewAgent->NeuralNet = nullptr;
+            }
+            NewAgent->Maze = MazeInstances.IsValidIndex(Instance) ? MazeInstances[Instance] : Maze;
+            NewAgent->bManagedUpdate = UsesManagedAgentUpdate();
+            NewAgent->EpisodeStartTime = GetSimulationTime();
+            if (IsAcceleratedTraining())
+            {
+                // Substeps do not wait for the physics scene: walls are tested on the maze grid. Components that
+                // still tick once per frame follow the simulated clock.
+                NewAgent->bGridCollision = NewAgent->Maze != nullptr;
+                NewAgent->CustomTimeDilation = FMath::Max(SimulationSpeed, 1.f);
+            }
+            if (UsesNoveltySearch())
+            {
+                NewAgent->BehaviorDescriptorPoints = EvolutionManager->BehaviorDescriptorPoints;
+                NewAgent->BehaviorDescriptorDuration = TimeLimit;
+            }
+            if (!NewAgent->ExitLocation.IsZero())
+            {
+                NewAgent->ExitLocation += InstanceOffset;
+            }
+            Agents.Add(NewAgent);
+            UE_LOG(LogTemp, Log, TEXT("Agent %d spawned successfully."), i);
         }
+    }
+
+    // Every genome starts the generation with a blank memory.
+    ResetRecurrentState(INDEX_NONE);
+    ResetActiveAgents();
+    BeginTrajectories();
+}
 
-        // Verify that a neural network exists for this index; if not, log warning.
-        if (CurrentGeneration.IsValidIndex(i) && CurrentGeneration[i])
+void AMazeManager::ResetActiveAgents()
+{
+    ActiveAgentIndices.Reset();
+    ActiveAgentSlots.Init(INDEX_NONE, Agents.Num());
+    for (int32 i = 0; i < Agents.Num(); i++)
+    {
+        if (Agents[i] && Agents[i]->IsActive)
         {
-            NewAgent->NeuralNet = CurrentGeneration[i];
+            AddActiveAgent(i);
         }
-        else
+    }
+}
+
+void AMazeManager::AddActiveAgent(int32 AgentIndex)
+{
+    if (ActiveAgentSlots[AgentIndex] == INDEX_NONE)
+    {
+        ActiveAgentSlots[AgentIndex] = ActiveAgentIndices.Add(AgentIndex);
+    }
+    Agents[AgentIndex]->SetSimulationEnabled(true);
+}
+
+void AMazeManager::RemoveActiveAgent(int32 Slot)
+{
+    const int32 AgentIndex = ActiveAgentIndices[Slot];
+    ActiveAgentIndices.RemoveAtSwap(Slot, 1, EAllowShrinking::No);
+    ActiveAgentSlots[AgentIndex] = INDEX_NONE;
+    if (ActiveAgentIndices.IsValidIndex(Slot))
+    {
+        // The last entry moved into the freed slot.
+        ActiveAgentSlots[ActiveAgentIndices[Slot]] = Slot;
+    }
+    if (AMazeAgent* Agent = Agents[AgentIndex])
+    {
+        Agent->SetSimulationEnabled(false);
+    }
+}
+
+void AMazeManager::CompactActiveAgents()
+{
+    // Backwards, so an entry swapped into a freed slot has already been checked.
+    for (int32 Slot = ActiveAgentIndices.Num() - 1; Slot >= 0; Slot--)
+    {
+        const AMazeAgent* Agent = Agents.IsValidIndex(ActiveAgentIndices[Slot]) ? Agents[ActiveAgentIndices[Slot]] : nullptr;
+        if (!Agent || !Agent->IsActive)
         {
-            UE_LOG(LogTemp, Warning, TEXT("CurrentGeneration does not have a valid neural network at index %d"), i);
-            NewAgent->NeuralNet = nullptr;
+            RemoveActiveAgent(Slot);
         }
-        Agents.Add(NewAgent);
-        UE_LOG(LogTemp, Log, TEXT("Agent %d spawned successfully."), i);
     }
 }
 
 void AMazeManager::UpdateAgents(float DeltaTime)
 {
-    // Agents are handling their own updates in their Tick() functions.
-}
+    // Without the managed update, every agent runs its own Tick().
+    LastAgentUpdateSeconds = 0.0;
+    if (!UsesManagedAgentUpdate())
+    {
+        return;
+    }
 
-void AMazeManager::ProcessGeneration()
-{
-    UE_LOG(LogTemp, Log, TEXT("Processing Generation %d"), GenerationCount);
+    // Agents finished by the evolution step since the start of the frame.
+    CompactActiveAgents();
+    const int32 NumActive = ActiveAgentIndices.Num();
+    if (NumActive == 0)
+    {
+        return;
+    }
 
-    // (Optional) Update the fitness values from agents to the respective neural networks.
-    // For each agent, assign its fitness to its network.
-    for (int32 i = 0; i < PopulationSize; i++)
+    const double StartTime = FPlatformTime::Seconds();
+    const float CurrentTime = GetSimulationTime();
+    const bool bHasRecurrentStates = bRecurrentNetwork && RecurrentStates.Num() == Agents.Num() * RecurrentStateSize;
+
+    // Game thread: pose snapshot of every active agent.
+    AgentUpdates.SetNum(NumActive, EAllowShrinking::No);
+    for (int32 k = 0; k < NumActive; k++)
     {
-        if (Agents.IsValidIndex(i))
+        Agents[ActiveAgentIndices[k]]->BeginManagedUpdate(AgentUpdates[k], CurrentTime);
+    }
+
+    // Worker threads: sensing, inference and fitness. A task only writes to its agent, its update, its
+    // recurrent state and its phase buffer, so the agents need no synchronization.
+    const int32 MinBatchSize = AgentUpdateThreads > 0 ? FMath::DivideAndRoundUp(NumActive, AgentUpdateThreads) : 1;
+    ParallelForWithTaskContext(TEXT("NNMaze.AgentUpdate"), AgentPhaseBuffers, NumActive, MinBatchSize,
+        [this, DeltaTime, CurrentTime, bHasRecurrentStates](FMazeTelemetryPhaseBuffer& PhaseBuffer, int32 k)
         {
-            AMazeAgent* Agent = Agents[i];
-            if (Agent && CurrentGeneration.IsValidIndex(i) && CurrentGeneration[i])
-            {
-                CurrentGeneration[i]->Fitness = Agent->Fitness;
-            }
+            FMazeTelemetryPhaseBufferScope PhaseBufferScope(PhaseBuffer);
+            const int32 AgentIndex = ActiveAgentIndices[k];
+            const TArrayView<float> State = bHasRecurrentStates
+                ? MakeArrayView(RecurrentStates).Slice(AgentIndex * RecurrentStateSize, RecurrentStateSize)
+                : TArrayView<float>();
+            Agents[AgentIndex]->ComputeManagedUpdate(AgentUpdates[k], DeltaTime, CurrentTime, State);
+        });
+    for (FMazeTelemetryPhaseBuffer& PhaseBuffer : AgentPhaseBuffers)
+    {
+        FMazeTelemetry::FlushPhaseBuffer(PhaseBuffer);
+    }
+
+    // Game thread: all transforms in one batch.
+    {
+        NNMAZE_PHASE_SCOPE(Movement);
+        for (int32 k = 0; k < NumActive; k++)
+        {
+            Agents[ActiveAgentIndices[k]]->ApplyManagedUpdate(AgentUpdates[k]);
         }
     }
+    LastAgentUpdateSeconds = FPlatformTime::Seconds() - StartTime;
+}
 
-    // Delegate the evolution processing to the evolution manager.
-    float NewGenerationAverageFitness = 0.f;
-    if (EvolutionManager)
+void AMazeManager::ResetRecurrentState(int32 AgentIndex)
+{
+    if (!bRecurrentNetwork)
     {
-        EvolutionManager->ProcessGeneration(CurrentGeneration, NextGeneration, NewGenerationAverageFitness, PopulationSize);
+        return;
     }
 
-    UE_LOG(LogTemp, Log, TEXT("Average fitness for Generation %d: %.2f"), GenerationCount, NewGenerationAverageFitness);
+    if (AgentIndex == INDEX_NONE)
+    {
+        const UNeuralNetwork* const* Network = CurrentGeneration.FindByPredicate([](const UNeuralNetwork* Candidate) { return Candidate != nullptr; });
+        RecurrentStateSize = Network ? (*Network)->GetStateSize() : 0;
+        RecurrentStates.Reset();
+        RecurrentStates.SetNumZeroed(Agents.Num() * RecurrentStateSize);
+    }
+    else if (RecurrentStates.Num() == Agents.Num() * RecurrentStateSize)
+    {
+        FMemory::Memzero(&RecurrentStates[AgentIndex * RecurrentStateSize], RecurrentStateSize * sizeof(float));
+    }
+}
+
+void AMazeManager::ProcessGeneration()
+{
+    NNMAZE_SCOPE(ProcessGeneration);
+
+    if (bHeadlessEvaluation)
+    {
+        // The whole generation is simulated within this frame.
+        EvaluateGenerationHeadless();
+        CloseTimer();
+    }
+
+    const double TransitionStart = FPlatformTime::Seconds();
+
+    UE_LOG(LogTemp, Log, TEXT("Processing Generation %d"), GenerationCount);
+
+    if (!bHeadlessEvaluation)
+    {
+        CollectAgentFitness();
+        SubmitGenerationTrajectories();
+    }
+    RecordGenerationTelemetry(GatherFitness(CurrentGeneration));
+    PublishGenerationChampion();
+    if (UsesNoveltySearch())
+    {
+        // Telemetry above keeps the raw fitness; selection uses the novelty score.
+        EvolutionManager->ApplyNovelty(DescribedNetworks, BehaviorDescriptors, GetBehaviorDescriptorSize());
+    }
+    else if (UsesMultiObjective())
+    {
+        EvolutionManager->ApplyMultiObjective(DescribedNetworks, GenerationObjectives, SelectionObjectives.Num());
+    }
+    EvolveCurrentGeneration();
 
-    // Replace the current generation with the new generation
-    CurrentGeneration = NextGeneration;
+    if (bHeadlessEvaluation)
+    {
+        // The next generation is simulated on the next frame.
+        FNNMazeFrameCounters::PublishGenerationTransition((FPlatformTime::Seconds() - TransitionStart) * 1000.0);
+        return;
+    }
 
     // Spawn new agents for the new generation
     CreateAgents();
 
+    FNNMazeFrameCounters::PublishGenerationTransition((FPlatformTime::Seconds() - TransitionStart) * 1000.0);
+
     // Restart the generation timer and resume training
-    GetWorld()->GetTimerManager().SetTimer(TimerHandle_CloseTimer, this, &AMazeManager::CloseTimer, TimeLimit, false);
     bIsTraining = true;
+    const bool bHasSimulatedAgents = Agents.ContainsByPredicate([](const AMazeAgent* Agent) { return Agent != nullptr; });
+    if (bHasSimulatedAgents)
+    {
+        StartGenerationTimer();
+    }
+    else
+    {
+        // Every genome was served from the fitness cache: there is no episode to wait for.
+        CloseTimer();
+    }
+}
+
+void AMazeManager::CollectAgentFitness()
+{
+    // (Optional) Update the fitness values from agents to the respective neural networks.
+    // For each genome, combine the fitness of its agents in every maze instance.
+    const int32 NumInstances = FMath::Max(1, MazeInstances.Num());
+    const bool bCollectBehaviors = UsesNoveltySearch();
+    const bool bCollectObjectives = UsesMultiObjective();
+    DescribedNetworks.Reset();
+    BehaviorDescriptors.Reset();
+    GenerationObjectives.Reset();
+
+    TArray<float, TInlineAllocator<8>> InstanceFitness;
+    TArray<FMazeObjectives, TInlineAllocator<8>> InstanceObjectives;
+    for (int32 i = 0; i < PopulationSize; i++)
+    {
+        if (!CurrentGeneration.IsValidIndex(i) || !CurrentGeneration[i])
+        {
+            continue;
+        }
+
+        if (bCollectBehaviors)
+        {
+            DescribedNetworks.Add(CurrentGeneration[i]);
+            for (int32 Instance = 0; Instance < NumInstances; Instance++)
+            {
+                const int32 AgentIndex = Instance * PopulationSize + i;
+                if (Agents.IsValidIndex(AgentIndex) && Agents[AgentIndex])
+                {
+                    Agents[AgentIndex]->GetBehaviorDescriptor(BehaviorDescriptors);
+                }
+                else
+                {
+                    BehaviorDescriptors.AddZeroed(2 * EvolutionManager->BehaviorDescriptorPoints);
+                }
+            }
+        }
+
+        InstanceFitness.Reset();
+        InstanceObjectives.Reset();
+        for (int32 Instance = 0; Instance < NumInstances; Instance++)
+        {
+            const int32 AgentIndex = Instance * PopulationSize + i;
+            if (Agents.IsValidIndex(AgentIndex) && Agents[AgentIndex])
+            {
+                InstanceFitness.Add(Agents[AgentIndex]->Fitness);
+                InstanceObjectives.Add(Agents[AgentIndex]->GetObjectives());
+            }
+        }
+        if (bCollectObjectives)
+        {
+            DescribedNetworks.Add(CurrentGeneration[i]);
+            AppendSelectionObjectives(InstanceObjectives);
+        }
+        if (InstanceFitness.Num() > 0)
+        {
+            CurrentGeneration[i]->Fitness = AggregateFitness(InstanceFitness, FitnessAggregation);
+        }
+    }
+}
+
+bool AMazeManager::UsesNoveltySearch() const
+{
+    return EvolutionManager && EvolutionManager->bUseNoveltySearch;
+}
+
+int32 AMazeManager::GetBehaviorDescriptorSize() const
+{
+    return UsesNoveltySearch() ? 2 * EvolutionManager->BehaviorDescriptorPoints * FMath::Max(1, MazeInstances.Num()) : 0;
+}
+
+bool AMazeManager::UsesMultiObjective() const
+{
+    return EvolutionManager && EvolutionManager->bUseMultiObjective;
+}
+
+void AMazeManager::AppendSelectionObjectives(TConstArrayView<FMazeObjectives> InstanceObjectives)
+{
+    TArray<float, TInlineAllocator<8>> Values;
+    for (const EMazeObjective Objective : SelectionObjectives)
+    {
+        Values.Reset();
+        for (const FMazeObjectives& Objectives : InstanceObjectives)
+        {
+            Values.Add(Objectives[Objective]);
+        }
+        GenerationObjectives.Add(AggregateFitness(Values, FitnessAggregation));
+    }
+}
+
+void AMazeManager::SpawnMazeInstances()
+{
+    MazeInstances.Reset();
+    if (Maze)
+    {
+        MazeInstances.Add(Maze);
+    }
+
+    // Multi-maze evaluation runs whole generations at once: the other modes keep a single maze.
+    const bool bGenerational = EvaluationRole == EEvaluationRole::Local && EvolutionMode == EEvolutionMode::Generational;
+    if (!bGenerational && (NumMazeInstances > 1 || bHeadlessEvaluation))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Multiple maze instances and headless evaluation require the local generational mode, using a single maze."));
+        NumMazeInstances = 1;
+        bHeadlessEvaluation = false;
+    }
+    if (!Maze && (NumMazeInstances > 1 || bHeadlessEvaluation))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Multiple maze instances and headless evaluation require a procedural maze, using the level as is."));
+        NumMazeInstances = 1;
+        bHeadlessEvaluation = false;
+    }
+
+    for (int32 Instance = 1; Instance < NumMazeInstances; Instance++)
+    {
+        const FTransform Transform(Maze->GetActorRotation(), Maze->GetActorLocation() + GetMazeInstanceOffset(Instance));
+        AProceduralMaze* Copy = GetWorld()->SpawnActorDeferred<AProceduralMaze>(Maze->GetClass(), Transform, this);
+        if (!Copy)
+        {
+            UE_LOG(LogTemp, Error, TEXT("Failed to spawn maze instance %d"), Instance);
+            NumMazeInstances = Instance;
+            break;
+        }
+        Copy->Settings = Maze->Settings;
+        if (bVaryMazeInstanceSeeds)
+        {
+            Copy->Settings.Seed = Maze->Settings.Seed + Instance;
+        }
+        Copy->BlockSize = Maze->BlockSize;
+        Copy->WallHeight = Maze->WallHeight;
+        Copy->WallMesh = Maze->WallMesh;
+        Copy->FinishSpawning(Transform);
+        MazeInstances.Add(Copy);
+    }
+
+    if (MazeInstances.Num() > 1 || bHeadlessEvaluation)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Evaluating every genome in %d maze(s) (%s fitness, %s)"), MazeInstances.Num(),
+            FitnessAggregation == EFitnessAggregation::Min ? TEXT("min") : TEXT("mean"), bHeadlessEvaluation ? TEXT("headless") : TEXT("in world"));
+    }
+}
+
+FVector AMazeManager::GetMazeInstanceOffset(int32 Instance) const
+{
+    if (Instance == 0 || !Maze)
+    {
+        return FVector::ZeroVector;
+    }
+
+    // Instances are laid out side by side along the maze Y axis.
+    const float Stride = Maze->GetGrid().GetHeight() * Maze->BlockSize + MazeInstanceSpacing;
+    return Maze->GetActorRotation().RotateVector(FVector(0.f, Instance * Stride, 0.f));
+}
+
+void AMazeManager::EvaluateGenerationHeadless()
+{
+    NNMAZE_SCOPE(HeadlessEvaluation);
+
+    // Genomes already evaluated in this environment take their cached fitness and are not simulated again.
+    TArray<UNeuralNetwork*> Pending;
+    Pending.Reserve(CurrentGeneration.Num());
+    for (UNeuralNetwork* Network : CurrentGeneration)
+    {
+        if (Network && !(EvolutionManager && EvolutionManager->ApplyCachedFitness(Network)))
+        {
+            Pending.Add(Network);
+        }
+    }
+    GenerationSimulations = Pending.Num();
+
+    const AMazeAgent* AgentDefaults = AgentBlueprint ? AgentBlueprint->GetDefaultObject<AMazeAgent>() : GetDefault<AMazeAgent>();
+    TArray<FMazeEvaluationInstance> Instances;
+    Instances.Reserve(MazeInstances.Num());
+    for (int32 Instance = 0; Instance < MazeInstances.Num(); Instance++)
+    {
+        AProceduralMaze* InstanceMaze = MazeInstances[Instance];
+        const FVector InstanceOffset = GetMazeInstanceOffset(Instance);
+
+        FMazeEvaluationInstance& Evaluation = Instances.AddDefaulted_GetRef();
+        Evaluation.Grid = &InstanceMaze->GetGrid();
+        Evaluation.Settings.Agent = FMazeAgentParams::FromAgent(AgentDefaults);
+        Evaluation.Settings.Start = InstanceMaze->WorldToMaze(StartPosition + InstanceOffset);
+        if (!AgentDefaults->ExitLocation.IsZero())
+        {
+            Evaluation.Settings.Exit = InstanceMaze->WorldToMaze(AgentDefaults->ExitLocation + InstanceOffset);
+            // Built here, on the game thread, before the parallel evaluation reads it.
+            Evaluation.Settings.FlowField = &InstanceMaze->GetFlowField(AgentDefaults->ExitLocation + InstanceOffset);
+        }
+        // Agents spawn facing world +X.
+        Evaluation.Settings.StartYaw = -InstanceMaze->GetActorRotation().Yaw;
+        Evaluation.Settings.BlockSize = InstanceMaze->BlockSize;
+        Evaluation.Settings.TimeLimit = TimeLimit;
+        Evaluation.Settings.DeltaTime = HeadlessTimeStep;
+        Evaluation.Settings.BehaviorDescriptorPoints = UsesNoveltySearch() ? EvolutionManager->BehaviorDescriptorPoints : 0;
+    }
+
+    // Episode descriptors are laid out genome by genome, so each genome's instances are already concatenated.
+    TArray<float> EpisodeFitness;
+    TArray<FMazeObjectives> EpisodeObjectives;
+    FMazeHeadlessSimulator::EvaluateAcrossMazes(Instances, Pending, EpisodeFitness, UsesNoveltySearch() ? &BehaviorDescriptors : nullptr,
+        UsesMultiObjective() ? &EpisodeObjectives : nullptr);
+    DescribedNetworks = Pending;
+    GenerationObjectives.Reset();
+
+    const int32 NumInstances = Instances.Num();
+    for (int32 i = 0; i < Pending.Num(); i++)
+    {
+        Pending[i]->Fitness = AggregateFitness(MakeArrayView(EpisodeFitness).Slice(i * NumInstances, NumInstances), FitnessAggregation);
+        if (UsesMultiObjective())
+        {
+            AppendSelectionObjectives(MakeArrayView(EpisodeObjectives).Slice(i * NumInstances, NumInstances));
+        }
+    }
+
+    TotalSimulationTime += TimeLimit;
+    SimulatedTimeSinceRecord += TimeLimit;
+}
+
+void AMazeManager::EvolveCurrentGeneration()
+{
+    // Delegate the evolution processing to the evolution manager.
+    float NewGenerationAverageFitness = 0.f;
+    if (EvolutionManager)
+    {
+        EvolutionManager->ProcessGeneration(CurrentGeneration, NextGeneration, NewGenerationAverageFitness, PopulationSize);
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Average fitness for Generation %d: %.2f"), GenerationCount, NewGenerationAverageFitness);
+
+    if (EvolutionManager && EvolutionManager->bUseFitnessCache)
+    {
+        const FFitnessCache& Cache = EvolutionManager->GetFitnessCache();
+        UE_LOG(LogTemp, Log, TEXT("Fitness cache: %d entries, %lld hits, %lld misses (%.1f%% hit rate)"),
+            Cache.Num(), Cache.GetHits(), Cache.GetMisses(), Cache.GetHitRate() * 100.f);
+
+        // Invalidates the cache if the maze or the reward parameters changed during the generation.
+        EvolutionManager->SetEnvironmentHash(ComputeEnvironmentHash());
+    }
+
+    // Swap rather than copy: the previous generation's networks become the slots the next one is bred into,
+    // so a stable population reuses the same UObjects and weight buffers generation after generation.
+    Swap(CurrentGeneration, NextGeneration);
+    if (EvolutionManager)
+    {
+        FNNMazeFrameCounters::PublishPopulationMemory(
+            UEvolutionManager::GetGenerationAllocatedSize(CurrentGeneration) + UEvolutionManager::GetGenerationAllocatedSize(NextGeneration),
+            EvolutionManager->GetNetworksCreated());
+    }
+}
+
+void AMazeManager::TickSteadyState()
+{
+    if (!EvolutionManager)
+    {
+        return;
+    }
+
+    // Steady-state breeding waits until half of the initial population has been evaluated.
+    const bool bSteadyState = EvolutionMode == EEvolutionMode::SteadyState;
+    const bool bCanBreed = !bSteadyState || EvolutionManager->GetEvaluatedPoolSize() >= FMath::Max(2, PopulationSize / 2);
+    auto NextChild = [this, bSteadyState](UNeuralNetwork* Child)
+        {
+            return bSteadyState ? EvolutionManager->BreedSteadyStateChild(Child) : EvolutionManager->TryPopChild(Child);
+        };
+
+    // Bounds the number of cached children skipped per agent and frame.
+    const int32 MaxChildAttempts = 8;
+
+    const float Now = GetSimulationTime();
+    for (int32 i = 0; i < Agents.Num(); i++)
+    {
+        AMazeAgent* Agent = Agents[i];
+        UNeuralNetwork* Network = CurrentGeneration.IsValidIndex(i) ? CurrentGeneration[i] : nullptr;
+        if (!Agent || !Network)
+        {
+            continue;
+        }
+
+        // An evaluation ends when the agent crashes or runs out of time.
+        if (!AgentAwaitingChild[i])
+        {
+            if (Agent->IsActive && Now - Agent->EpisodeStartTime < TimeLimit)
+            {
+                continue;
+            }
+
+            Agent->IsActive = false;
+            Network->Fitness = Agent->Fitness;
+            SubmitTrajectory(i);
+            if (Network->Fitness > BestRecentFitness)
+            {
+                BestRecentFitness = Network->Fitness;
+                PublishChampion(Network);
+            }
+            EvolutionManager->RecordFitness({ Network });
+            EvolutionManager->AddEvaluatedGenome(Network, PopulationSize);
+            RecentFitness.Add(Network->Fitness);
+            AgentAwaitingChild[i] = true;
+            TotalSimulations++;
+            EvaluationsSinceReport++;
+        }
+
+        // Replace the agent as soon as a child is available: bred on the spot in steady-state mode,
+        // taken from the background batch in pipelined mode. Children already in the fitness cache
+        // go straight to the pool without being simulated.
+        for (int32 Attempt = 0; bCanBreed && Attempt < MaxChildAttempts && NextChild(Network); Attempt++)
+        {
+            if (!EvolutionManager->ApplyCachedFitness(Network))
+            {
+                Agent->ResetForEpisode(StartPosition, FRotator::ZeroRotator);
+                Agent->EpisodeStartTime = Now;
+                if (TrajectoryRecorder)
+                {
+                    TrajectoryRecorder->BeginEpisode(i, Agent->GetActorLocation(), Agent->GetActorRotation().Yaw);
+                }
+                ResetRecurrentState(i);
+                AddActiveAgent(i);
+                AgentAwaitingChild[i] = false;
+                break;
+            }
+            EvolutionManager->AddEvaluatedGenome(Network, PopulationSize);
+            RecentFitness.Add(Network->Fitness);
+        }
+    }
+
+    if (EvolutionMode == EEvolutionMode::Pipelined)
+    {
+        RequestPipelinedChildren();
+    }
+
+    // Report progress once per population's worth of evaluations.
+    if (EvaluationsSinceReport >= PopulationSize)
+    {
+        EvaluationsSinceReport -= PopulationSize;
+        GenerationCount++;
+
+        float BestFitness = 0.f;
+        EvolutionManager->GetEvaluatedPoolStats(BestFitness, GenerationFitnessMean);
+        UE_LOG(LogTemp, Log, TEXT("Generation %d complete (%s). Pool best: %.2f, pool mean: %.2f, total simulations: %d"),
+            GenerationCount, EvolutionMode == EEvolutionMode::SteadyState ? TEXT("steady-state") : TEXT("pipelined"),
+            BestFitness, GenerationFitnessMean, TotalSimulations);
+
+        RecordGenerationTelemetry(MoveTemp(RecentFitness));
+        RecentFitness.Reset();
+        SaveReplays();
+        BestRecentFitness = -MAX_flt;
+    }
+}
+
+void AMazeManager::RequestPipelinedChildren()
+{
+    // Keep a batch of children ahead of the agents, bred in the background from the evaluated pool.
+    // Breeding starts once half of the initial population has been evaluated.
+    const int32 BatchSize = PipelineBatchSize > 0 ? PipelineBatchSize : FMath::Max(1, PopulationSize / 4);
+    const int32 MinPoolSize = FMath::Max(2, PopulationSize / 2);
+    if (EvolutionManager->GetEvaluatedPoolSize() >= MinPoolSize && EvolutionManager->GetNumReadyChildren() < BatchSize)
+    {
+        EvolutionManager->RequestChildren(BatchSize);
+    }
+}
+
+void AMazeManager::ConfigureEvaluationRole()
+{
+    const TCHAR* CommandLine = FCommandLine::Get();
+    FParse::Value(CommandLine, TEXT("MazeBatchSize="), DistributedBatchSize);
+    FParse::Value(CommandLine, TEXT("MazeLocalWorkers="), LocalWorkerCount);
+
+    FString CoordinatorAddress;
+    if (FParse::Value(CommandLine, TEXT("MazeWorker="), CoordinatorAddress))
+    {
+        WorkerClient = MakeUnique<FEvaluationWorkerClient>();
+        if (!WorkerClient->Connect(CoordinatorAddress))
+        {
+            FPlatformMisc::RequestExit(false);
+        }
+        EvaluationRole = EEvaluationRole::Worker;
+        return;
+    }
+
+    const bool bCoordinator = FParse::Value(CommandLine, TEXT("MazeCoordinator="), CoordinatorPort)
+        || FParse::Param(CommandLine, TEXT("MazeCoordinator"));
+    if (!bCoordinator)
+    {
+        return;
+    }
+    if (EvolutionManager && !EvolutionManager->UsesFixedTopology())
+    {
+        UE_LOG(LogTemp, Error, TEXT("Variable-topology genomes cannot be shipped to workers, evaluating locally."));
+        return;
+    }
+
+    Coordinator = MakeUnique<FEvaluationCoordinator>();
+    Coordinator->BatchTimeoutSeconds = BatchTimeoutSeconds;
+    Coordinator->StragglerSeconds = StragglerSeconds;
+    Coordinator->MaxBatchRetries = MaxBatchRetries;
+    if (!Coordinator->Start(CoordinatorPort))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Falling back to local evaluation."));
+        Coordinator.Reset();
+        return;
+    }
+
+    EvaluationRole = EEvaluationRole::Coordinator;
+    LaunchLocalWorkers(LocalWorkerCount);
+}
+
+void AMazeManager::LaunchLocalWorkers(int32 Count)
+{
+    if (Count <= 0)
+    {
+        return;
+    }
+
+    const FString MapName = UWorld::RemovePIEPrefix(GetWorld()->GetOutermost()->GetName());
+    FString Arguments = FString::Printf(TEXT("%s -game -nullrhi -nosound -unattended -MazeWorker=127.0.0.1:%d"), *MapName, CoordinatorPort);
+#if WITH_EDITOR
+    // Editor binaries need the project file to know which game to run.
+    Arguments = FString::Printf(TEXT("\"%s\" %s"), *FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()), *Arguments);
+#endif
+
+    for (int32 i = 0; i < Count; i++)
+    {
+        FProcHandle WorkerProcess = FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *Arguments, true, false, false, nullptr, 0, nullptr, nullptr);
+        if (!WorkerProcess.IsValid())
+        {
+            UE_LOG(LogTemp, Error, TEXT("Failed to launch local evaluation worker %d"), i);
+            continue;
+        }
+        LocalWorkerProcesses.Add(WorkerProcess);
+    }
+    UE_LOG(LogTemp, Log, TEXT("Launched %d local evaluation workers: %s"), LocalWorkerProcesses.Num(), *Arguments);
+}
+
+void AMazeManager::SubmitGenerationToWorkers()
+{
+    // Genomes already evaluated in this environment are not shipped again.
+    TArray<UNeuralNetwork*> GenomesToEvaluate;
+    SubmittedGenomeIndices.Reset();
+    for (int32 i = 0; i < CurrentGeneration.Num(); i++)
+    {
+        UNeuralNetwork* Network = CurrentGeneration[i];
+        if (Network && !(EvolutionManager && EvolutionManager->ApplyCachedFitness(Network)))
+        {
+            GenomesToEvaluate.Add(Network);
+            SubmittedGenomeIndices.Add(i);
+        }
+    }
+
+    GenerationSimulations = GenomesToEvaluate.Num();
+    Coordinator->SubmitGeneration(GenerationCount, GenomesToEvaluate, DistributedBatchSize);
+}
+
+void AMazeManager::TickCoordinator()
+{
+    TArray<float> Fitness;
+    if (!Coordinator->TryGetResults(GenerationCount, Fitness))
+    {
+        return;
+    }
+
+    for (int32 i = 0; i < FMath::Min(Fitness.Num(), SubmittedGenomeIndices.Num()); i++)
+    {
+        CurrentGeneration[SubmittedGenomeIndices[i]]->Fitness = Fitness[i];
+    }
+
+    CloseTimer();
+    UE_LOG(LogTemp, Log, TEXT("Processing Generation %d (%d workers)"), GenerationCount, Coordinator->GetNumWorkers());
+    RecordGenerationTelemetry(GatherFitness(CurrentGeneration));
+    PublishGenerationChampion();
+    EvolveCurrentGeneration();
+
+    SubmitGenerationToWorkers();
+    bIsTraining = true;
+}
+
+void AMazeManager::TickWorker()
+{
+    // The generation timer fired: report the batch back to the coordinator.
+    if (bHasBatch && !bIsTraining)
+    {
+        CollectAgentFitness();
+
+        FBatchResult Result;
+        Result.BatchId = CurrentBatch.BatchId;
+        Result.GenerationId = CurrentBatch.GenerationId;
+        for (int32 i = 0; i < CurrentBatch.Genomes.Num(); i++)
+        {
+            Result.Slots.Add(CurrentBatch.Genomes[i].Slot);
+            Result.Fitness.Add(CurrentGeneration[i]->Fitness);
+        }
+        WorkerClient->SendResult(Result);
+        bHasBatch = false;
+    }
+
+    if (!bHasBatch && WorkerClient->PollBatch(CurrentBatch))
+    {
+        // Reuse the networks of the previous batch when their layout matches.
+        PopulationSize = CurrentBatch.Genomes.Num();
+        CurrentGeneration.SetNum(PopulationSize);
+        for (int32 i = 0; i < PopulationSize; i++)
+        {
+            const FGenomePayload& Payload = CurrentBatch.Genomes[i];
+            UNeuralNetwork*& Network = CurrentGeneration[i];
+            if (!Network || Network->LayerSizes != Payload.LayerSizes || Network->bRecurrent != Payload.bRecurrent)
+            {
+                Network = NewObject<UNeuralNetwork>(this, UNeuralNetwork::StaticClass());
+                Network->Initialize(Payload.LayerSizes, Payload.bRecurrent);
+            }
+            Network->SetFlatWeights(Payload.Weights);
+            Network->Fitness = 0.f;
+        }
+
+        CreateAgents();
+        StartGenerationTimer();
+        bIsTraining = true;
+        bHasBatch = true;
+    }
+
+    if (!bHasBatch && WorkerClient->ShouldExit())
+    {
+        UE_LOG(LogTemp, Log, TEXT("Coordinator is gone or training is over, worker exiting."));
+        FPlatformMisc::RequestExit(false);
+    }
+}
+
+void AMazeManager::SampleActiveAgents(float DeltaTime)
+{
+    SimulatedTimeSinceRecord += DeltaTime;
+    TelemetrySampleElapsed += DeltaTime;
+    if (TelemetrySampleElapsed < TelemetrySampleInterval)
+    {
+        return;
+    }
+    TelemetrySampleElapsed = FMath::Fmod(TelemetrySampleElapsed, TelemetrySampleInterval);
+
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+    const int32 ActiveAgents = ActiveAgentIndices.Num();
+    ActiveAgentSamples.Add(ActiveAgents);
+    SET_DWORD_STAT(STAT_NNMaze_ActiveAgents, ActiveAgents);
+    TelemetryOverheadCycles += FPlatformTime::Cycles64() - StartCycles;
+}
+
+void AMazeManager::RecordGenerationTelemetry(TArray<float> Fitness)
+{
+    if (!Telemetry)
+    {
+        return;
+    }
+
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+    const double Now = FPlatformTime::Seconds();
+
+    // Phase times cover everything since the previous record: the breeding and spawning
+    // that produced this generation, then its evaluation.
+    FGenerationTelemetry Record;
+    Record.Generation = GenerationCount;
+    Record.WallSeconds = Now - LastTelemetryRecordTime;
+    Record.SimulatedSeconds = SimulatedTimeSinceRecord;
+    Record.Fitness = MoveTemp(Fitness);
+    Record.Diversity = FMazeTelemetry::ComputeDiversity(CurrentGeneration);
+    Record.CacheHitRate = EvolutionManager && EvolutionManager->bUseFitnessCache ? EvolutionManager->GetFitnessCache().GetHitRate() : 0.f;
+    Record.ActiveAgents = MoveTemp(ActiveAgentSamples);
+    FMazeTelemetry::ConsumePhaseTimes(Record);
+
+    TelemetryOverheadCycles += FPlatformTime::Cycles64() - StartCycles;
+    Record.OverheadMs = FPlatformTime::ToMilliseconds64(TelemetryOverheadCycles);
+    Telemetry->Submit(MoveTemp(Record));
+
+    LastTelemetryRecordTime = Now;
+    SimulatedTimeSinceRecord = 0.f;
+    TelemetryOverheadCycles = 0;
+    ActiveAgentSamples.Reset();
+}
+
+void AMazeManager::BeginTrajectories()
+{
+    if (!TrajectoryRecorder)
+    {
+        return;
+    }
+
+    // One ring per agent, long enough for a whole episode. The block is reused from one generation to the next.
+    const bool bFirstGeneration = TrajectoryRecorder->GetNumAgents() == 0;
+    TrajectoryRecorder->Reset(Agents.Num(), FMath::CeilToInt32(TimeLimit / TrajectorySampleInterval) + 1, TrajectorySampleInterval, TrajectoryQuantum);
+    for (int32 i = 0; i < Agents.Num(); i++)
+    {
+        if (Agents[i])
+        {
+            TrajectoryRecorder->BeginEpisode(i, Agents[i]->GetActorLocation(), Agents[i]->GetActorRotation().Yaw);
+        }
+    }
+    TrajectorySampleElapsed = 0.f;
+
+    if (bFirstGeneration)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Trajectory recorder: %d agents, %.2f MB"),
+            Agents.Num(), TrajectoryRecorder->GetAllocatedSize() / (1024.0 * 1024.0));
+    }
+}
+
+void AMazeManager::SampleTrajectories(float DeltaTime)
+{
+    TrajectorySampleElapsed += DeltaTime;
+    if (TrajectorySampleElapsed < TrajectorySampleInterval)
+    {
+        return;
+    }
+    TrajectorySampleElapsed = FMath::Fmod(TrajectorySampleElapsed, TrajectorySampleInterval);
+
+    // Agents that died during this step still record the pose they stopped at.
+    for (const int32 AgentIndex : ActiveAgentIndices)
+    {
+        const AMazeAgent* Agent = Agents[AgentIndex];
+        TrajectoryRecorder->Record(AgentIndex, Agent->GetActorLocation(), Agent->GetActorRotation().Yaw);
+    }
+}
+
+void AMazeManager::SubmitGenerationTrajectories()
+{
+    if (!TrajectoryRecorder)
+    {
+        return;
+    }
+
+    // Only the best episodes of the generation can enter the best runs: offer them best first.
+    TArray<int32> Candidates;
+    for (int32 i = 0; i < Agents.Num(); i++)
+    {
+        if (Agents[i] && TrajectoryRecorder->WouldKeepRun(Agents[i]->Fitness, NumReplays))
+        {
+            Candidates.Add(i);
+        }
+    }
+    Algo::Sort(Candidates, [this](int32 A, int32 B) { return Agents[A]->Fitness > Agents[B]->Fitness; });
+    for (int32 k = 0; k < FMath::Min(Candidates.Num(), NumReplays); k++)
+    {
+        SubmitTrajectory(Candidates[k]);
+    }
+    SaveReplays();
+}
+
+void AMazeManager::SubmitTrajectory(int32 AgentIndex)
+{
+    if (!TrajectoryRecorder || !Agents.IsValidIndex(AgentIndex) || !Agents[AgentIndex])
+    {
+        return;
+    }
+
+    // Agent of genome G in maze instance M is at M * PopulationSize + G.
+    const int32 Instance = PopulationSize > 0 ? AgentIndex / PopulationSize : 0;
+    bReplaysChanged |= TrajectoryRecorder->SubmitRun(AgentIndex, Agents[AgentIndex]->Fitness, GenerationCount, Instance, GetMazeInstanceOffset(Instance), NumReplays);
+}
+
+void AMazeManager::SaveReplays()
+{
+    if (!TrajectoryRecorder || !bReplaysChanged)
+    {
+        return;
+    }
+
+    const FString Path = FMazeTrajectoryRun::GetReplayPath(ReplayFileName);
+    if (!FMazeTrajectoryRun::SaveRuns(Path, TrajectoryRecorder->GetTopRuns()))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Failed to write the replays to %s"), *Path);
+    }
+    bReplaysChanged = false;
+}
+
+void AMazeManager::SpawnChampionAgents()
+{
+    const UNeuralNetwork* const* Template = CurrentGeneration.FindByPredicate([](const UNeuralNetwork* Candidate) { return Candidate != nullptr; });
+    if (!Template || !EvolutionManager || !EvolutionManager->UsesFixedTopology())
+    {
+        if (NumChampionAgents > 0)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Champion agents require a fixed network topology."));
+        }
+        return;
+    }
+    ChampionSnapshot = MakeShared<FChampionSnapshot, ESPMode::ThreadSafe>((*Template)->LayerSizes, (*Template)->bRecurrent);
+
+    if (NumChampionAgents <= 0 || !AgentBlueprint)
+    {
+        return;
+    }
+    if (bRecurrentNetwork)
+    {
+        // Their hidden state would need the managed update, which only runs the population.
+        UE_LOG(LogTemp, Warning, TEXT("Champion agents do not support recurrent networks."));
+        return;
+    }
+
+    for (int32 i = 0; i < NumChampionAgents; i++)
+    {
+        AMazeAgent* Agent = GetWorld()->SpawnActor<AMazeAgent>(AgentBlueprint, StartPosition, FRotator::ZeroRotator);
+        if (!Agent)
+        {
+            UE_LOG(LogTemp, Error, TEXT("Failed to spawn champion agent %d"), i);
+            continue;
+        }
+
+        // Starts with a copy of a random genome until the first champion is published.
+        UNeuralNetwork* Network = NewObject<UNeuralNetwork>(this, UNeuralNetwork::StaticClass());
+        Network->Initialize((*Template)->LayerSizes, false);
+        Network->CopyWeights(*Template);
+        Agent->NeuralNet = Network;
+        Agent->Maze = Maze;
+        Agent->ChampionSource = ChampionSnapshot;
+        Agent->EpisodeStartTime = GetWorld()->GetTimeSeconds();
+        ChampionAgents.Add(Agent);
+    }
+}
+
+void AMazeManager::TickChampionAgents()
+{
+    // Champion agents run on the world clock, whatever the training speed.
+    const float Now = GetWorld()->GetTimeSeconds();
+    for (AMazeAgent* Agent : ChampionAgents)
+    {
+        if (Agent && (!Agent->IsActive || Now - Agent->EpisodeStartTime >= TimeLimit))
+        {
+            Agent->ResetForEpisode(StartPosition, FRotator::ZeroRotator);
+        }
+    }
+}
+
+void AMazeManager::PublishGenerationChampion()
+{
+    const UNeuralNetwork* Best = nullptr;
+    for (const UNeuralNetwork* Network : CurrentGeneration)
+    {
+        if (Network && (!Best || Network->Fitness > Best->Fitness))
+        {
+            Best = Network;
+        }
+    }
+    PublishChampion(Best);
+}
+
+void AMazeManager::PublishChampion(const UNeuralNetwork* Network)
+{
+    // One weight copy per publication; the agents pick it up on their own.
+    if (ChampionSnapshot && Network)
+    {
+        ChampionSnapshot->Publish(*Network, Network->Fitness, GenerationCount);
+    }
+}
+
+void AMazeManager::InvalidateFitnessCache()
+{
+    if (EvolutionManager)
+    {
+        EvolutionManager->InvalidateFitnessCache();
+    }
+}
+
+uint64 AMazeManager::ComputeEnvironmentHash() const
+{
+    uint64 Hash = 0;
+    auto HashBytes = [&Hash](const void* Data, uint32 Size)
+        {
+            Hash = CityHash64WithSeed(static_cast<const char*>(Data), Size, Hash);
+        };
+
+    HashBytes(&StartPosition, sizeof(StartPosition));
+    HashBytes(&TimeLimit, sizeof(TimeLimit));
+
+    // Instance layouts are hashed with the walls below.
+    HashBytes(&NumMazeInstances, sizeof(NumMazeInstances));
+    HashBytes(&FitnessAggregation, sizeof(FitnessAggregation));
+    if (bHeadlessEvaluation)
+    {
+        HashBytes(&HeadlessTimeStep, sizeof(HeadlessTimeStep));
+    }
+    else if (IsAcceleratedTraining())
+    {
+        HashBytes(&FixedTimeStep, sizeof(FixedTimeStep));
+    }
+
+    // Reward, movement and sensor parameters come from the agent class defaults.
+    if (AgentBlueprint)
+    {
+        const AMazeAgent* AgentDefaults = AgentBlueprint->GetDefaultObject<AMazeAgent>();
+        const float AgentParameters[] = {
+            AgentDefaults->RotationSpeed,
+            AgentDefaults->Speed,
+            AgentDefaults->MaxViewDistance,
+            AgentDefaults->FitnessTimeDecreaseRate,
+            AgentDefaults->FitnessCheckpointIncreaseRate,
+            AgentDefaults->SensorSmoothingFactor,
+            AgentDefaults->bUseExitSensor ? 1.f : 0.f,
+            AgentDefaults->ProgressRewardRate
+        };
+        HashBytes(AgentParameters, sizeof(AgentParameters));
+        HashBytes(&AgentDefaults->ExitLocation, sizeof(AgentDefaults->ExitLocation));
+    }
+
+    // Maze layout: walls and checkpoints placed in the level.
+    UWorld* World = GetWorld();
+    if (World)
+    {
+        for (TActorIterator<AActor> It(World); It; ++It)
+        {
+            const AActor* Actor = *It;
+            if (Actor->ActorHasTag("Wall") || Actor->ActorHasTag("Checkpoint"))
+            {
+                const FVector Location = Actor->GetActorLocation();
+                const FRotator Rotation = Actor->GetActorRotation();
+                const FVector Scale = Actor->GetActorScale3D();
+                HashBytes(&Location, sizeof(Location));
+                HashBytes(&Rotation, sizeof(Rotation));
+                HashBytes(&Scale, sizeof(Scale));
+
+                if (const ACheckpoint* Checkpoint = Cast<ACheckpoint>(Actor))
+                {
+                    HashBytes(&Checkpoint->RewardMultiplier, sizeof(Checkpoint->RewardMultiplier));
+                }
+                if (const AProceduralMaze* ProceduralMaze = Cast<AProceduralMaze>(Actor))
+                {
+                    const uint64 GridHash = ProceduralMaze->GetGrid().GetHash();
+                    HashBytes(&GridHash, sizeof(GridHash));
+                    HashBytes(&ProceduralMaze->BlockSize, sizeof(ProceduralMaze->BlockSize));
+                }
+            }
+        }
+    }
+
+    return Hash;
 }
@@ -0,0 +1,129 @@
+#include "MazeReplayActor.h"
+#include "MazeAgent.h"
+#include "Components/ActorComponent.h"
+#include "DrawDebugHelpers.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+AMazeReplayActor::AMazeReplayActor()
+{
+    PrimaryActorTick.bCanEverTick = true;
+
+    ReplayFileName = TEXT("TopRuns");
+    RunIndex = 0;
+    PlaybackRate = 1.f;
+    bLoop = true;
+    bDrawPath = true;
+    PlaybackActor = nullptr;
+    PlaybackTime = 0.f;
+
+    SceneRoot = CreateDefaultSubobject<USceneComponent>(TEXT("SceneRoot"));
+    RootComponent = SceneRoot;
+}
+
+void AMazeReplayActor::BeginPlay()
+{
+    Super::BeginPlay();
+
+    if (PlaybackActorClass)
+    {
+        PlaybackActor = GetWorld()->SpawnActor<AActor>(PlaybackActorClass, GetActorTransform());
+        if (PlaybackActor)
+        {
+            // A puppet: only this actor moves it.
+            if (AMazeAgent* Agent = Cast<AMazeAgent>(PlaybackActor))
+            {
+                Agent->IsActive = false;
+            }
+            PlaybackActor->SetActorTickEnabled(false);
+            PlaybackActor->SetActorEnableCollision(false);
+            for (UActorComponent* Component : PlaybackActor->GetComponents())
+            {
+                Component->SetComponentTickEnabled(false);
+            }
+        }
+    }
+    LoadReplays();
+}
+
+void AMazeReplayActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (PlaybackActor)
+    {
+        PlaybackActor->Destroy();
+        PlaybackActor = nullptr;
+    }
+    Super::EndPlay(EndPlayReason);
+}
+
+bool AMazeReplayActor::LoadReplays()
+{
+    const FString Path = FMazeTrajectoryRun::GetReplayPath(ReplayFileName);
+    if (!FMazeTrajectoryRun::LoadRuns(Path, Runs) || Runs.Num() == 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("No replay in %s"), *Path);
+        Locations.Reset();
+        Yaws.Reset();
+        return false;
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Loaded %d replays from %s"), Runs.Num(), *Path);
+    PlayRun(RunIndex);
+    return true;
+}
+
+void AMazeReplayActor::PlayRun(int32 Index)
+{
+    if (!Runs.IsValidIndex(Index))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Replay %d does not exist (%d runs loaded)"), Index, Runs.Num());
+        return;
+    }
+
+    RunIndex = Index;
+    PlaybackTime = 0.f;
+    Runs[RunIndex].Decode(Locations, Yaws);
+}
+
+void AMazeReplayActor::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    if (!Runs.IsValidIndex(RunIndex) || Locations.Num() == 0)
+    {
+        return;
+    }
+
+    const FMazeTrajectoryRun& Run = Runs[RunIndex];
+    const float Duration = Run.GetDuration();
+    PlaybackTime += DeltaTime * PlaybackRate;
+    if (PlaybackTime > Duration)
+    {
+        PlaybackTime = bLoop && Duration > 0.f ? FMath::Fmod(PlaybackTime, Duration) : Duration;
+    }
+
+    // Linear interpolation between the two samples around the playback time; yaw along the shortest arc.
+    const float SamplePosition = Run.SampleInterval > 0.f ? PlaybackTime / Run.SampleInterval : 0.f;
+    const int32 Sample = FMath::Clamp(FMath::FloorToInt32(SamplePosition), 0, Locations.Num() - 1);
+    const int32 NextSample = FMath::Min(Sample + 1, Locations.Num() - 1);
+    const float Alpha = FMath::Clamp(SamplePosition - Sample, 0.f, 1.f);
+    const FVector Location = FMath::Lerp(Locations[Sample], Locations[NextSample], Alpha);
+    const float Yaw = Yaws[Sample] + FRotator::NormalizeAxis(Yaws[NextSample] - Yaws[Sample]) * Alpha;
+
+    AActor* Target = PlaybackActor ? PlaybackActor : this;
+    Target->SetActorLocationAndRotation(Location, FRotator(0.f, Yaw, 0.f));
+
+    if (bDrawPath)
+    {
+        for (int32 i = 1; i < Locations.Num(); i++)
+        {
+            DrawDebugLine(GetWorld(), Locations[i - 1], Locations[i], i <= Sample ? FColor::Green : FColor::Silver, false, -1.f, 0, 2.f);
+        }
+    }
+
+    if (GEngine)
+    {
+        GEngine->AddOnScreenDebugMessage(-1, 0.f, FColor::Cyan, FString::Printf(TEXT("Replay %d/%d: generation %d, fitness %.2f, %.1f / %.1f sec"),
+            RunIndex + 1, Runs.Num(), Run.Generation, Run.Fitness, PlaybackTime, Duration));
+    }
+}
@@ -0,0 +1,231 @@
+#include "MazeSimulation.h"
+#include "MazeAgent.h"
+#include "MazeFlowField.h"
+#include "MazeGrid.h"
+#include "NeuralNetwork.h"
+#include "NNMazeStats.h"
+#include "Async/ParallelFor.h"
+#include "Components/CapsuleComponent.h"
+
+FMazeAgentParams FMazeAgentParams::FromAgent(const AMazeAgent* Agent)
+{
+    FMazeAgentParams Params;
+    if (!Agent)
+    {
+        return Params;
+    }
+
+    Params.Speed = Agent->Speed;
+    Params.RotationSpeed = Agent->RotationSpeed;
+    Params.MaxViewDistance = Agent->MaxViewDistance;
+    Params.FitnessTimeDecreaseRate = Agent->FitnessTimeDecreaseRate;
+    Params.FitnessCheckpointIncreaseRate = Agent->FitnessCheckpointIncreaseRate;
+    Params.ProgressRewardRate = Agent->ProgressRewardRate;
+    Params.SensorSmoothingFactor = Agent->SensorSmoothingFactor;
+    Params.RaycastUpdateInterval = Agent->GetRaycastUpdateInterval();
+    Params.bUseExitSensor = Agent->bUseExitSensor;
+    if (const UCapsuleComponent* Capsule = Agent->GetCapsuleComponent())
+    {
+        Params.Radius = Capsule->GetScaledCapsuleRadius();
+    }
+    return Params;
+}
+
+void FMazeHeadlessSimulator::Evaluate(const FMazeGrid& Grid, const FMazeSimulationSettings& Settings, TConstArrayView<UNeuralNetwork*> Networks)
+{
+    ParallelFor(Networks.Num(), [&Grid, &Settings, Networks](int32 Index)
+        {
+            if (UNeuralNetwork* Network = Networks[Index])
+            {
+                Network->Fitness = EvaluateOne(Grid, Settings, *Network);
+            }
+        });
+}
+
+void FMazeHeadlessSimulator::EvaluateAcrossMazes(TConstArrayView<FMazeEvaluationInstance> Mazes, TConstArrayView<UNeuralNetwork*> Networks, TArray<float>& OutFitness,
+    TArray<float>* OutDescriptors, TArray<FMazeObjectives>* OutObjectives)
+{
+    const int32 NumMazes = Mazes.Num();
+    OutFitness.SetNumZeroed(Networks.Num() * NumMazes);
+
+    const int32 DescriptorSize = OutDescriptors && NumMazes > 0 ? 2 * Mazes[0].Settings.BehaviorDescriptorPoints : 0;
+    if (OutDescriptors)
+    {
+        OutDescriptors->SetNumZeroed(OutFitness.Num() * DescriptorSize);
+    }
+    if (OutObjectives)
+    {
+        OutObjectives->Init(FMazeObjectives(), OutFitness.Num());
+    }
+
+    // One task per episode: a flat index over network x maze pairs keeps every core busy even when
+    // there are fewer networks than cores or when some mazes end much earlier than others.
+    ParallelFor(OutFitness.Num(), [Mazes, Networks, NumMazes, DescriptorSize, OutDescriptors, OutObjectives, &OutFitness](int32 Index)
+        {
+            const UNeuralNetwork* Network = Networks[Index / NumMazes];
+            const FMazeEvaluationInstance& Maze = Mazes[Index % NumMazes];
+            if (Network && Maze.Grid)
+            {
+                const TArrayView<float> Descriptor = DescriptorSize > 0 ? MakeArrayView(*OutDescriptors).Slice(Index * DescriptorSize, DescriptorSize) : TArrayView<float>();
+                OutFitness[Index] = EvaluateOne(*Maze.Grid, Maze.Settings, *Network, Descriptor, OutObjectives ? &(*OutObjectives)[Index] : nullptr);
+            }
+        });
+}
+
+float FMazeHeadlessSimulator::EvaluateOne(const FMazeGrid& Grid, const FMazeSimulationSettings& Settings, const UNeuralNetwork& Network,
+    TArrayView<float> OutDescriptor, FMazeObjectives* OutObjectives)
+{
+    const FMazeAgentParams& Agent = Settings.Agent;
+    const float InvBlockSize = 1.f / Settings.BlockSize;
+    const float DeltaTime = Settings.DeltaTime;
+    const int32 NumSteps = FMath::CeilToInt32(Settings.TimeLimit / DeltaTime);
+
+    FVector2D Position = Settings.Start;
+    float Yaw = Settings.StartYaw;
+    float Fitness = 0.f;
+    FMazeObjectives Objectives;
+
+    // Forward, left, left diagonal, right, right diagonal: same order as the agent inputs.
+    float Distances[5] = { Agent.MaxViewDistance, Agent.MaxViewDistance, Agent.MaxViewDistance, Agent.MaxViewDistance, Agent.MaxViewDistance };
+    float TimeSinceRaycast = Agent.RaycastUpdateInterval;
+
+    TArray<float> Inputs;
+    Inputs.SetNumZeroed(8);
+
+    // Recurrent networks carry their hidden state across the steps of the episode.
+    TArray<float> RecurrentState;
+    TArray<float> Outputs;
+    if (Network.bRecurrent)
+    {
+        RecurrentState.SetNumZeroed(Network.GetStateSize());
+        Outputs.SetNumUninitialized(Network.LayerSizes.Last());
+    }
+    int32 Step = 0;
+    int32 NumRays = 0;
+    float LastExitDistance = -1.f;
+
+    // Behaviour descriptor: point P is sampled once (P + 1) / NumPoints of the episode has elapsed.
+    const int32 NumDescriptorPoints = OutDescriptor.Num() / 2;
+    int32 NumSampledPoints = 0;
+    for (; Step < NumSteps; Step++)
+    {
+        const float YawRadians = FMath::DegreesToRadians(Yaw);
+        const FVector2D Forward(FMath::Cos(YawRadians), FMath::Sin(YawRadians));
+        const FVector2D Right(-Forward.Y, Forward.X);
+
+        // Sensors: same update interval and smoothing as AMazeAgent::RaycastVision.
+        TimeSinceRaycast += DeltaTime;
+        if (TimeSinceRaycast >= Agent.RaycastUpdateInterval)
+        {
+            TimeSinceRaycast = 0.f;
+            const FVector2D Directions[5] = { Forward, -Right, (Forward - Right).GetSafeNormal(), Right, (Forward + Right).GetSafeNormal() };
+            for (int32 i = 0; i < 5; i++)
+            {
+                const float Raw = Grid.Raycast(Position * InvBlockSize, Directions[i], Agent.MaxViewDistance * InvBlockSize) * Settings.BlockSize;
+                Distances[i] = FMath::Clamp(FMath::Lerp(Distances[i], Raw, Agent.SensorSmoothingFactor), 0.f, Agent.MaxViewDistance);
+            }
+            NumRays += 5;
+        }
+
+        float RelativeAngleToExit = 0.f;
+        float NormalizedDistanceToExit = 1.f;
+        if (Agent.bUseExitSensor && Settings.FlowField)
+        {
+            // Same as AMazeAgent::UpdateFlowFieldSensor.
+            const FVector2D GridPosition = Position * InvBlockSize;
+            const float ExitDistance = Settings.FlowField->GetDistance(GridPosition);
+            NormalizedDistanceToExit = ExitDistance >= 0.f ? FMath::Clamp(ExitDistance / FMath::Max(Settings.FlowField->GetMaxDistance(), 1.f), 0.f, 1.f) : 1.f;
+            float DirectionYaw = 0.f;
+            if (Settings.FlowField->GetDirectionYaw(GridPosition, DirectionYaw))
+            {
+                RelativeAngleToExit = FMazeFlowField::GetRelativeAngle(DirectionYaw, Yaw);
+            }
+        }
+        else if (Agent.bUseExitSensor && !Settings.Exit.IsZero())
+        {
+            const FVector2D ToExit = Settings.Exit - Position;
+            const FVector2D ToExitNormalized = ToExit.GetSafeNormal();
+            const float Angle = FMath::Acos(FMath::Clamp(FVector2D::DotProduct(Forward, ToExitNormalized), -1.f, 1.f));
+            const float Sign = FVector2D::CrossProduct(Forward, ToExitNormalized) >= 0.f ? 1.f : -1.f;
+            RelativeAngleToExit = Angle * Sign / PI;
+            NormalizedDistanceToExit = FMath::Clamp(ToExit.Size() / 1000.f, 0.f, 1.f);
+        }
+
+        Inputs[0] = Agent.Speed / Agent.MaxViewDistance;
+        for (int32 i = 0; i < 5; i++)
+        {
+            Inputs[i + 1] = Distances[i] / Agent.MaxViewDistance;
+        }
+        Inputs[6] = RelativeAngleToExit;
+        Inputs[7] = NormalizedDistanceToExit;
+
+        if (Network.bRecurrent)
+        {
+            Network.FeedForward(Inputs, RecurrentState, Outputs);
+        }
+        else
+        {
+            Outputs = Network.FeedForward(Inputs);
+        }
+        if (Outputs.Num() < 2)
+        {
+            break;
+        }
+
+        const FVector2D MoveDelta = Forward * Agent.Speed * Outputs[0] * DeltaTime;
+        Position += MoveDelta;
+        Yaw += Outputs[1] * Agent.RotationSpeed * DeltaTime;
+
+        const float DeltaDistance = MoveDelta.Size();
+        if (DeltaDistance > 0.2f)
+        {
+            Fitness += DeltaDistance / 100.f;
+            Objectives[EMazeObjective::Progress] += DeltaDistance / 100.f;
+        }
+        Fitness -= DeltaTime * Agent.FitnessTimeDecreaseRate;
+        if (Settings.FlowField && Agent.ProgressRewardRate != 0.f)
+        {
+            const float ExitDistance = Settings.FlowField->GetDistance(Position * InvBlockSize);
+            if (ExitDistance >= 0.f)
+            {
+                if (LastExitDistance >= 0.f)
+                {
+                    Fitness += Agent.ProgressRewardRate * (LastExitDistance - ExitDistance);
+                    Objectives[EMazeObjective::Progress] += Agent.ProgressRewardRate * (LastExitDistance - ExitDistance);
+                }
+                LastExitDistance = ExitDistance;
+            }
+        }
+
+        while (NumSampledPoints < NumDescriptorPoints && (Step + 1) * NumDescriptorPoints >= (NumSampledPoints + 1) * NumSteps)
+        {
+            OutDescriptor[2 * NumSampledPoints] = Position.X;
+            OutDescriptor[2 * NumSampledPoints + 1] = Position.Y;
+            NumSampledPoints++;
+        }
+
+        if (Grid.OverlapsWall(Position * InvBlockSize, Agent.Radius * InvBlockSize))
+        {
+            Fitness -= Agent.FitnessCheckpointIncreaseRate;
+            Objectives[EMazeObjective::Collisions] -= 1.f;
+            Step++;
+            break;
+        }
+    }
+
+    // A crashed agent stays where it stopped.
+    for (; NumSampledPoints < NumDescriptorPoints; NumSampledPoints++)
+    {
+        OutDescriptor[2 * NumSampledPoints] = Position.X;
+        OutDescriptor[2 * NumSampledPoints + 1] = Position.Y;
+    }
+
+    // Counted once per episode to keep the shared counters out of the inner loop.
+    FNNMazeFrameCounters::AddRays(NumRays);
+    FNNMazeFrameCounters::AddInferences(Step);
+    if (OutObjectives)
+    {
+        *OutObjectives = Objectives;
+    }
+    return Fitness;
+}
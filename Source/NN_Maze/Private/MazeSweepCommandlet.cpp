@@ -0,0 +1,455 @@
+#include "MazeSweepCommandlet.h"
+#include "EvolutionManager.h"
+#include "MazeAgent.h"
+#include "MazeFlowField.h"
+#include "MazeGrid.h"
+#include "MazeSimulation.h"
+#include "NeuralNetwork.h"
+#include "Algo/Sort.h"
+#include "Dom/JsonObject.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+    struct FSweepConfig
+    {
+        float ElitismRate = 0.1f;
+        float BaseMutationRate = 5.f;
+        float CrossoverProbability = 0.5f;
+        float TargetFitnessDifference = 10.f;
+        int32 PopulationSize = 100;
+        TArray<int32> Layers;
+
+        FString ToString() const
+        {
+            TArray<FString> LayerStrings;
+            for (const int32 Size : Layers)
+            {
+                LayerStrings.Add(FString::FromInt(Size));
+            }
+            return FString::Printf(TEXT("elitism %.2f, mutation %.1f, crossover %.2f, target diff %.1f, population %d, layers %s"),
+                ElitismRate, BaseMutationRate, CrossoverProbability, TargetFitnessDifference, PopulationSize, *FString::Join(LayerStrings, TEXT(",")));
+        }
+    };
+
+    struct FSweepTrial
+    {
+        FSweepConfig Config;
+        UEvolutionManager* Evolution = nullptr;
+        TArray<UNeuralNetwork*> CurrentGeneration;
+        TArray<UNeuralNetwork*> NextGeneration;
+
+        int32 Generations = 0;
+
+        // Best fitness of every evaluated generation; the last one is the trial's score.
+        TArray<float> BestFitnessCurve;
+        float MeanFitness = 0.f;
+        double BreedSeconds = 0.0;
+
+        // Rung at which successive halving stopped the trial (INDEX_NONE = still running or finished).
+        int32 StoppedAtRung = INDEX_NONE;
+
+        float GetScore() const { return BestFitnessCurve.Num() > 0 ? BestFitnessCurve.Last() : -MAX_flt; }
+    };
+
+    TArray<float> ParseFloatList(const FString& Params, const TCHAR* Key, float Default)
+    {
+        TArray<float> Values;
+        FString ListString;
+        if (FParse::Value(*Params, Key, ListString, false))
+        {
+            TArray<FString> Parts;
+            ListString.ParseIntoArray(Parts, TEXT(","), true);
+            for (const FString& Part : Parts)
+            {
+                Values.Add(FCString::Atof(*Part));
+            }
+        }
+        if (Values.Num() == 0)
+        {
+            Values.Add(Default);
+        }
+        return Values;
+    }
+
+    // Layer configurations separated by '/', layer sizes by ','.
+    TArray<TArray<int32>> ParseLayerList(const FString& Params)
+    {
+        TArray<TArray<int32>> Configurations;
+        FString ListString;
+        if (FParse::Value(*Params, TEXT("Layers="), ListString, false))
+        {
+            TArray<FString> Entries;
+            ListString.ParseIntoArray(Entries, TEXT("/"), true);
+            for (const FString& Entry : Entries)
+            {
+                TArray<FString> Parts;
+                Entry.ParseIntoArray(Parts, TEXT(","), true);
+                TArray<int32>& Layers = Configurations.AddDefaulted_GetRef();
+                for (const FString& Part : Parts)
+                {
+                    Layers.Add(FMath::Max(1, FCString::Atoi(*Part)));
+                }
+            }
+        }
+        if (Configurations.Num() == 0)
+        {
+            Configurations.Add({ AMazeAgent::NumNetworkInputs, 16, 2 });
+        }
+        return Configurations;
+    }
+
+    // Cell centre on the maze plane.
+    FVector2D GetCellCenter(int32 CellX, int32 CellY, float BlockSize)
+    {
+        const FIntPoint Block = FMazeGrid::CellToBlock(CellX, CellY);
+        return FVector2D((Block.X + 0.5f) * BlockSize, (Block.Y + 0.5f) * BlockSize);
+    }
+
+    FString BuildReport(const TArray<FSweepTrial>& Trials, const TArray<int32>& Ranking, int32 Eta, int32 MinGenerations, int32 MaxGenerations,
+        int32 MazeCells, int32 MazeInstances, int32 Seed, double Seconds)
+    {
+        TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+        Report->SetNumberField(TEXT("seed"), Seed);
+        Report->SetNumberField(TEXT("eta"), Eta);
+        Report->SetNumberField(TEXT("min_generations"), MinGenerations);
+        Report->SetNumberField(TEXT("max_generations"), MaxGenerations);
+        Report->SetNumberField(TEXT("maze_cells"), MazeCells);
+        Report->SetNumberField(TEXT("maze_instances"), MazeInstances);
+        Report->SetNumberField(TEXT("seconds"), Seconds);
+        Report->SetNumberField(TEXT("logical_cores"), FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+
+        TArray<TSharedPtr<FJsonValue>> TrialValues;
+        for (int32 Rank = 0; Rank < Ranking.Num(); Rank++)
+        {
+            const FSweepTrial& Trial = Trials[Ranking[Rank]];
+            TSharedRef<FJsonObject> TrialObject = MakeShared<FJsonObject>();
+            TrialObject->SetNumberField(TEXT("rank"), Rank + 1);
+            TrialObject->SetNumberField(TEXT("elitism_rate"), Trial.Config.ElitismRate);
+            TrialObject->SetNumberField(TEXT("base_mutation_rate"), Trial.Config.BaseMutationRate);
+            TrialObject->SetNumberField(TEXT("crossover_probability"), Trial.Config.CrossoverProbability);
+            TrialObject->SetNumberField(TEXT("target_fitness_difference"), Trial.Config.TargetFitnessDifference);
+            TrialObject->SetNumberField(TEXT("population"), Trial.Config.PopulationSize);
+
+            TArray<TSharedPtr<FJsonValue>> Layers;
+            for (const int32 Size : Trial.Config.Layers)
+            {
+                Layers.Add(MakeShared<FJsonValueNumber>(Size));
+            }
+            TrialObject->SetArrayField(TEXT("layers"), Layers);
+
+            TrialObject->SetNumberField(TEXT("generations"), Trial.Generations);
+            TrialObject->SetNumberField(TEXT("stopped_at_rung"), Trial.StoppedAtRung);
+            TrialObject->SetNumberField(TEXT("best_fitness"), Trial.GetScore());
+            TrialObject->SetNumberField(TEXT("mean_fitness"), Trial.MeanFitness);
+            TrialObject->SetNumberField(TEXT("breed_seconds"), Trial.BreedSeconds);
+
+            TArray<TSharedPtr<FJsonValue>> Curve;
+            for (const float Fitness : Trial.BestFitnessCurve)
+            {
+                Curve.Add(MakeShared<FJsonValueNumber>(Fitness));
+            }
+            TrialObject->SetArrayField(TEXT("best_fitness_curve"), Curve);
+            TrialValues.Add(MakeShared<FJsonValueObject>(TrialObject));
+        }
+        Report->SetArrayField(TEXT("trials"), TrialValues);
+
+        FString Output;
+        TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Output);
+        FJsonSerializer::Serialize(Report, Writer);
+        return Output;
+    }
+}
+
+UMazeSweepCommandlet::UMazeSweepCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UMazeSweepCommandlet::Main(const FString& Params)
+{
+    int32 Samples = 0;
+    int32 Eta = 3;
+    int32 MinGenerations = 4;
+    int32 MaxGenerations = 64;
+    int32 MazeCells = 6;
+    int32 NumMazeInstances = 2;
+    float TimeLimit = 15.f;
+    float DeltaTime = 1.f / 30.f;
+    int32 Seed = 1234;
+    FParse::Value(*Params, TEXT("Samples="), Samples);
+    FParse::Value(*Params, TEXT("Eta="), Eta);
+    FParse::Value(*Params, TEXT("MinGenerations="), MinGenerations);
+    FParse::Value(*Params, TEXT("MaxGenerations="), MaxGenerations);
+    FParse::Value(*Params, TEXT("MazeCells="), MazeCells);
+    FParse::Value(*Params, TEXT("MazeInstances="), NumMazeInstances);
+    FParse::Value(*Params, TEXT("TimeLimit="), TimeLimit);
+    FParse::Value(*Params, TEXT("DeltaTime="), DeltaTime);
+    FParse::Value(*Params, TEXT("Seed="), Seed);
+
+    const TArray<float> ElitismRates = ParseFloatList(Params, TEXT("ElitismRate="), 0.1f);
+    const TArray<float> MutationRates = ParseFloatList(Params, TEXT("BaseMutationRate="), 5.f);
+    const TArray<float> CrossoverProbabilities = ParseFloatList(Params, TEXT("CrossoverProbability="), 0.5f);
+    const TArray<float> TargetDifferences = ParseFloatList(Params, TEXT("TargetFitnessDifference="), 10.f);
+    const TArray<float> PopulationSizes = ParseFloatList(Params, TEXT("Population="), 100.f);
+    const TArray<TArray<int32>> LayerConfigurations = ParseLayerList(Params);
+
+    if (Eta < 2 || MinGenerations < 1 || MaxGenerations < MinGenerations || TimeLimit <= 0.f || DeltaTime <= 0.f)
+    {
+        UE_LOG(LogTemp, Error, TEXT("MazeSweep: invalid parameters (Eta >= 2, 1 <= MinGenerations <= MaxGenerations, TimeLimit and DeltaTime > 0)."));
+        return 1;
+    }
+    for (const TArray<int32>& Layers : LayerConfigurations)
+    {
+        if (Layers.Num() < 2 || Layers[0] != AMazeAgent::NumNetworkInputs || Layers.Last() < 2)
+        {
+            UE_LOG(LogTemp, Error, TEXT("MazeSweep: every layer configuration needs %d inputs and at least 2 outputs."), AMazeAgent::NumNetworkInputs);
+            return 1;
+        }
+    }
+
+    // Every combination of the listed values: the combination index is split into one digit per parameter.
+    const int32 NumCombinations = ElitismRates.Num() * MutationRates.Num() * CrossoverProbabilities.Num() * TargetDifferences.Num()
+        * PopulationSizes.Num() * LayerConfigurations.Num();
+    TArray<FSweepConfig> Configs;
+    Configs.SetNum(NumCombinations);
+    for (int32 Combination = 0; Combination < NumCombinations; Combination++)
+    {
+        int32 Digits = Combination;
+        auto NextDigit = [&Digits](int32 Base)
+        {
+            const int32 Digit = Digits % Base;
+            Digits /= Base;
+            return Digit;
+        };
+
+        FSweepConfig& Config = Configs[Combination];
+        Config.ElitismRate = ElitismRates[NextDigit(ElitismRates.Num())];
+        Config.BaseMutationRate = MutationRates[NextDigit(MutationRates.Num())];
+        Config.CrossoverProbability = CrossoverProbabilities[NextDigit(CrossoverProbabilities.Num())];
+        Config.TargetFitnessDifference = TargetDifferences[NextDigit(TargetDifferences.Num())];
+        Config.PopulationSize = FMath::Max(2, FMath::RoundToInt32(PopulationSizes[NextDigit(PopulationSizes.Num())]));
+        Config.Layers = LayerConfigurations[NextDigit(LayerConfigurations.Num())];
+    }
+
+    // Random search: a seeded sample of the grid.
+    FRandomStream SampleStream(Seed);
+    if (Samples > 0 && Samples < Configs.Num())
+    {
+        for (int32 i = 0; i < Samples; i++)
+        {
+            Configs.Swap(i, SampleStream.RandRange(i, Configs.Num() - 1));
+        }
+        Configs.SetNum(Samples);
+    }
+
+    // Evaluation mazes: same size, one seed each, start and exit in opposite corners.
+    FString AgentClassPath = TEXT("/Game/Blueprints/BP_MazeAgent.BP_MazeAgent_C");
+    FParse::Value(*Params, TEXT("AgentClass="), AgentClassPath);
+    const UClass* AgentClass = LoadClass<AMazeAgent>(nullptr, *AgentClassPath);
+    const AMazeAgent* AgentDefaults = AgentClass ? AgentClass->GetDefaultObject<AMazeAgent>() : GetDefault<AMazeAgent>();
+
+    NumMazeInstances = FMath::Max(1, NumMazeInstances);
+    TArray<FMazeGrid> Grids;
+    TArray<FMazeFlowField> FlowFields;
+    TArray<FMazeEvaluationInstance> Instances;
+    Grids.SetNum(NumMazeInstances);
+    FlowFields.SetNum(NumMazeInstances);
+    Instances.SetNum(NumMazeInstances);
+    for (int32 Instance = 0; Instance < NumMazeInstances; Instance++)
+    {
+        FMazeGenerationSettings GridSettings;
+        GridSettings.CellsX = FMath::Max(1, MazeCells);
+        GridSettings.CellsY = FMath::Max(1, MazeCells);
+        GridSettings.Seed = Seed + Instance;
+        Grids[Instance] = FMazeGrid::Generate(GridSettings);
+        const FIntPoint ExitCell(GridSettings.CellsX - 1, GridSettings.CellsY - 1);
+        FlowFields[Instance].Build(Grids[Instance], FMazeGrid::CellToBlock(ExitCell.X, ExitCell.Y));
+
+        FMazeEvaluationInstance& Evaluation = Instances[Instance];
+        Evaluation.Grid = &Grids[Instance];
+        Evaluation.Settings.Agent = FMazeAgentParams::FromAgent(AgentDefaults);
+        Evaluation.Settings.Start = GetCellCenter(0, 0, Evaluation.Settings.BlockSize);
+        Evaluation.Settings.Exit = GetCellCenter(ExitCell.X, ExitCell.Y, Evaluation.Settings.BlockSize);
+        Evaluation.Settings.FlowField = &FlowFields[Instance];
+        Evaluation.Settings.TimeLimit = TimeLimit;
+        Evaluation.Settings.DeltaTime = DeltaTime;
+    }
+
+    FMath::RandInit(Seed);
+    TArray<FSweepTrial> Trials;
+    Trials.SetNum(Configs.Num());
+    for (int32 TrialIndex = 0; TrialIndex < Trials.Num(); TrialIndex++)
+    {
+        FSweepTrial& Trial = Trials[TrialIndex];
+        Trial.Config = Configs[TrialIndex];
+        Trial.Evolution = NewObject<UEvolutionManager>(GetTransientPackage());
+        Trial.Evolution->ElitismRate = Trial.Config.ElitismRate;
+        Trial.Evolution->BaseMutationRate = Trial.Config.BaseMutationRate;
+        Trial.Evolution->CrossoverProbability = Trial.Config.CrossoverProbability;
+        Trial.Evolution->TargetFitnessDifference = Trial.Config.TargetFitnessDifference;
+        for (int32 i = 0; i < Trial.Config.PopulationSize; i++)
+        {
+            UNeuralNetwork* Network = NewObject<UNeuralNetwork>(Trial.Evolution);
+            Trial.Evolution->InitializeNetwork(Network, Trial.Config.Layers, false);
+            Trial.CurrentGeneration.Add(Network);
+        }
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("MazeSweep: %d trials, successive halving with eta %d from %d to %d generations, %d mazes of %dx%d cells"),
+        Trials.Num(), Eta, MinGenerations, MaxGenerations, NumMazeInstances, MazeCells, MazeCells);
+
+    // Both generations of a running trial survive a collection: the previous one holds the slots the next is bred into.
+    auto CollectTrialGarbage = [this, &Trials]()
+    {
+        TrialObjects.Reset();
+        for (const FSweepTrial& Trial : Trials)
+        {
+            if (Trial.StoppedAtRung == INDEX_NONE)
+            {
+                TrialObjects.Add(Trial.Evolution);
+                TrialObjects.Append(Trial.CurrentGeneration);
+                TrialObjects.Append(Trial.NextGeneration);
+            }
+        }
+        CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+    };
+
+    TArray<int32> Running;
+    for (int32 TrialIndex = 0; TrialIndex < Trials.Num(); TrialIndex++)
+    {
+        Running.Add(TrialIndex);
+    }
+
+    TArray<UNeuralNetwork*> Batch;
+    TArray<float> EpisodeFitness;
+    const double StartTime = FPlatformTime::Seconds();
+    int32 Rung = 0;
+    for (int32 Budget = MinGenerations; Running.Num() > 0; Rung++, Budget = FMath::Min(Budget * Eta, MaxGenerations))
+    {
+        // Train every running trial up to the rung's budget, one generation of all of them per batch.
+        for (int32 Step = 0; ; Step++)
+        {
+            Batch.Reset();
+            TArray<int32, TInlineAllocator<64>> Stepping;
+            for (const int32 TrialIndex : Running)
+            {
+                if (Trials[TrialIndex].Generations < Budget)
+                {
+                    Stepping.Add(TrialIndex);
+                    Batch.Append(Trials[TrialIndex].CurrentGeneration);
+                }
+            }
+            if (Stepping.Num() == 0)
+            {
+                break;
+            }
+
+            // One episode per network and maze for all trials together, spread over the shared worker threads.
+            FMazeHeadlessSimulator::EvaluateAcrossMazes(Instances, Batch, EpisodeFitness);
+
+            int32 BatchOffset = 0;
+            for (const int32 TrialIndex : Stepping)
+            {
+                FSweepTrial& Trial = Trials[TrialIndex];
+                float BestFitness = -MAX_flt;
+                for (UNeuralNetwork* Network : Trial.CurrentGeneration)
+                {
+                    float Fitness = 0.f;
+                    for (int32 Instance = 0; Instance < NumMazeInstances; Instance++)
+                    {
+                        Fitness += EpisodeFitness[BatchOffset * NumMazeInstances + Instance];
+                    }
+                    Network->Fitness = Fitness / NumMazeInstances;
+                    BestFitness = FMath::Max(BestFitness, Network->Fitness);
+                    BatchOffset++;
+                }
+                Trial.BestFitnessCurve.Add(BestFitness);
+
+                const double BreedStart = FPlatformTime::Seconds();
+                Trial.Evolution->ProcessGeneration(Trial.CurrentGeneration, Trial.NextGeneration, Trial.MeanFitness, Trial.Config.PopulationSize);
+                Swap(Trial.CurrentGeneration, Trial.NextGeneration);
+                Trial.BreedSeconds += FPlatformTime::Seconds() - BreedStart;
+                Trial.Generations++;
+            }
+
+            if (Step % 8 == 7)
+            {
+                CollectTrialGarbage();
+            }
+        }
+
+        Algo::Sort(Running, [&Trials](int32 A, int32 B) { return Trials[A].GetScore() > Trials[B].GetScore(); });
+        UE_LOG(LogTemp, Display, TEXT("MazeSweep: rung %d (%d generations), %d trials, best %.2f (%s)"),
+            Rung, Budget, Running.Num(), Trials[Running[0]].GetScore(), *Trials[Running[0]].Config.ToString());
+        if (Budget >= MaxGenerations || Running.Num() == 1)
+        {
+            break;
+        }
+
+        // Successive halving: the best 1/Eta go on to the next rung.
+        const int32 Promoted = FMath::Max(1, Running.Num() / Eta);
+        for (int32 i = Promoted; i < Running.Num(); i++)
+        {
+            Trials[Running[i]].StoppedAtRung = Rung;
+        }
+        Running.SetNum(Promoted);
+        CollectTrialGarbage();
+    }
+    const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+    // Ranking: trials that went further first, then by score.
+    TArray<int32> Ranking;
+    for (int32 TrialIndex = 0; TrialIndex < Trials.Num(); TrialIndex++)
+    {
+        Ranking.Add(TrialIndex);
+    }
+    Algo::Sort(Ranking, [&Trials](int32 A, int32 B)
+        {
+            if (Trials[A].Generations != Trials[B].Generations)
+            {
+                return Trials[A].Generations > Trials[B].Generations;
+            }
+            return Trials[A].GetScore() > Trials[B].GetScore();
+        });
+
+    UE_LOG(LogTemp, Display, TEXT("%6s %12s %12s %10s  %s"), TEXT("Rank"), TEXT("Generations"), TEXT("Best"), TEXT("Mean"), TEXT("Configuration"));
+    for (int32 Rank = 0; Rank < Ranking.Num(); Rank++)
+    {
+        const FSweepTrial& Trial = Trials[Ranking[Rank]];
+        UE_LOG(LogTemp, Display, TEXT("%6d %12d %12.2f %10.2f  %s"), Rank + 1, Trial.Generations, Trial.GetScore(), Trial.MeanFitness, *Trial.Config.ToString());
+    }
+
+    int32 TotalGenerations = 0;
+    for (const FSweepTrial& Trial : Trials)
+    {
+        TotalGenerations += Trial.Generations;
+    }
+    UE_LOG(LogTemp, Display, TEXT("MazeSweep: %d trial generations in %.1f s (%d without early stopping)"),
+        TotalGenerations, Seconds, Trials.Num() * MaxGenerations);
+
+    FString ReportPath = FPaths::ProjectSavedDir() / TEXT("Sweeps") / TEXT("MazeSweep.json");
+    FParse::Value(*Params, TEXT("Report="), ReportPath);
+    const bool bWritten = FFileHelper::SaveStringToFile(
+        BuildReport(Trials, Ranking, Eta, MinGenerations, MaxGenerations, MazeCells, NumMazeInstances, Seed, Seconds), *ReportPath);
+
+    TrialObjects.Empty();
+    CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+    if (!bWritten)
+    {
+        UE_LOG(LogTemp, Error, TEXT("MazeSweep: cannot write %s"), *ReportPath);
+        return 1;
+    }
+    UE_LOG(LogTemp, Display, TEXT("MazeSweep: report written to %s"), *ReportPath);
+    return 0;
+}
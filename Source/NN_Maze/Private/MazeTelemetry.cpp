@@ -0,0 +1,329 @@
+#include "MazeTelemetry.h"
+#include "NNMazeStats.h"
+#include "NeuralNetwork.h"
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/RunnableThread.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Misc/Paths.h"
+
+std::atomic<uint64> FMazeTelemetry::PhaseCycles[static_cast<int32>(EMazeTelemetryPhase::Count)];
+std::atomic<uint64> FMazeTelemetry::PhaseScopeCount;
+
+namespace
+{
+    thread_local FMazeTelemetryPhaseBuffer* ThreadPhaseBuffer = nullptr;
+
+    const TCHAR* PhaseNames[] = { TEXT("sensing"), TEXT("inference"), TEXT("movement"), TEXT("breeding"), TEXT("spawning") };
+    static_assert(UE_ARRAY_COUNT(PhaseNames) == static_cast<int32>(EMazeTelemetryPhase::Count), "Missing telemetry phase name");
+
+    // Nearest-rank percentile of a sorted array.
+    float Percentile(const TArray<float>& Sorted, float Fraction)
+    {
+        const int32 Rank = FMath::Clamp(FMath::CeilToInt32(Fraction * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+        return Sorted[Rank];
+    }
+
+    FString JoinSamples(const TArray<int32>& Samples, const TCHAR* Separator)
+    {
+        return FString::JoinBy(Samples, Separator, [](int32 Sample) { return FString::FromInt(Sample); });
+    }
+}
+
+FMazeTelemetry::FMazeTelemetry()
+    : ScopeCostCycles(0.0)
+    , Thread(nullptr)
+    , WakeEvent(nullptr)
+{
+}
+
+FMazeTelemetry::~FMazeTelemetry()
+{
+    Shutdown();
+}
+
+bool FMazeTelemetry::Start(const FString& RunName)
+{
+    const FString Directory = FPaths::ProjectSavedDir() / TEXT("Telemetry");
+    const FString CsvPath = Directory / RunName + TEXT(".csv");
+    const FString JsonPath = Directory / RunName + TEXT(".jsonl");
+    IFileManager::Get().MakeDirectory(*Directory, true);
+
+    CsvFile.Reset(IFileManager::Get().CreateFileWriter(*CsvPath));
+    JsonFile.Reset(IFileManager::Get().CreateFileWriter(*JsonPath));
+    if (!CsvFile || !JsonFile)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Failed to create telemetry files in %s"), *Directory);
+        CsvFile.Reset();
+        JsonFile.Reset();
+        return false;
+    }
+
+    FString Header = TEXT("generation,wall_s,sim_s,evaluations,min,mean,max,p10,p50,p90,diversity,cache_hit_rate");
+    for (const TCHAR* PhaseName : PhaseNames)
+    {
+        Header += FString::Printf(TEXT(",%s_ms"), PhaseName);
+    }
+    Header += TEXT(",overhead_pct,active_agents");
+    WriteLine(*CsvFile, Header);
+
+    ScopeCostCycles = CalibrateScopeCost();
+    UE_LOG(LogTemp, Log, TEXT("Telemetry: %.1f ns per phase scope, measured on %d worker threads"),
+        ScopeCostCycles * FPlatformTime::GetSecondsPerCycle64() * 1e9, FTaskGraphInterface::Get().GetNumWorkerThreads());
+
+    // Phase time spent before the run started (calibration included) is not part of any generation.
+    FGenerationTelemetry Discarded;
+    ConsumePhaseTimes(Discarded);
+
+    WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    bStopping = false;
+    Thread = FRunnableThread::Create(this, TEXT("NNMazeTelemetryWriter"), 0, TPri_BelowNormal);
+    if (!Thread)
+    {
+        FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+        WakeEvent = nullptr;
+        return false;
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Telemetry: writing %s and %s"), *CsvPath, *JsonPath);
+    return true;
+}
+
+void FMazeTelemetry::Shutdown()
+{
+    if (Thread)
+    {
+        Stop();
+        Thread->WaitForCompletion();
+        delete Thread;
+        Thread = nullptr;
+    }
+    if (WakeEvent)
+    {
+        FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+        WakeEvent = nullptr;
+    }
+    CsvFile.Reset();
+    JsonFile.Reset();
+}
+
+void FMazeTelemetry::Submit(FGenerationTelemetry&& Record)
+{
+    if (!Thread)
+    {
+        return;
+    }
+    PendingRecords.Enqueue(MoveTemp(Record));
+    WakeEvent->Trigger();
+}
+
+void FMazeTelemetry::AddPhaseCycles(EMazeTelemetryPhase Phase, uint64 Cycles)
+{
+    if (FMazeTelemetryPhaseBuffer* Buffer = ThreadPhaseBuffer)
+    {
+        Buffer->Cycles[static_cast<int32>(Phase)] += Cycles;
+        Buffer->Scopes++;
+        return;
+    }
+    PhaseCycles[static_cast<int32>(Phase)].fetch_add(Cycles, std::memory_order_relaxed);
+    PhaseScopeCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+FMazeTelemetryPhaseBuffer* FMazeTelemetry::SetThreadPhaseBuffer(FMazeTelemetryPhaseBuffer* Buffer)
+{
+    FMazeTelemetryPhaseBuffer* Previous = ThreadPhaseBuffer;
+    ThreadPhaseBuffer = Buffer;
+    return Previous;
+}
+
+void FMazeTelemetry::FlushPhaseBuffer(FMazeTelemetryPhaseBuffer& Buffer)
+{
+    for (int32 i = 0; i < static_cast<int32>(EMazeTelemetryPhase::Count); i++)
+    {
+        if (Buffer.Cycles[i] > 0)
+        {
+            PhaseCycles[i].fetch_add(Buffer.Cycles[i], std::memory_order_relaxed);
+        }
+    }
+    PhaseScopeCount.fetch_add(Buffer.Scopes, std::memory_order_relaxed);
+    Buffer = FMazeTelemetryPhaseBuffer();
+}
+
+double FMazeTelemetry::CalibrateScopeCost()
+{
+    // Same pattern as the agent update: every worker closes scopes into its task buffer at the same time.
+    // Each task times its own loop, so the result is CPU cycles per scope under a full parallel load.
+    struct FCalibrationTask
+    {
+        FMazeTelemetryPhaseBuffer Buffer;
+        uint64 LoopCycles = 0;
+    };
+    constexpr int32 NumTasks = 256;
+    constexpr int32 ScopesPerTask = 1000;
+    TArray<FCalibrationTask> Tasks;
+    ParallelForWithTaskContext(TEXT("NNMaze.TelemetryCalibration"), Tasks, NumTasks, 1, [](FCalibrationTask& Task, int32 Index)
+        {
+            FMazeTelemetryPhaseBufferScope BufferScope(Task.Buffer);
+            const uint64 StartCycles = FPlatformTime::Cycles64();
+            for (int32 i = 0; i < ScopesPerTask; i++)
+            {
+                FMazeTelemetryPhaseScope Scope(EMazeTelemetryPhase::Sensing);
+            }
+            Task.LoopCycles += FPlatformTime::Cycles64() - StartCycles;
+        });
+
+    uint64 ParallelCycles = 0;
+    for (const FCalibrationTask& Task : Tasks)
+    {
+        ParallelCycles += Task.LoopCycles;
+    }
+    const double BufferedCost = static_cast<double>(ParallelCycles) / (NumTasks * ScopesPerTask);
+
+    // Game thread scopes go to the shared atomics. The buffered calibration scopes were never flushed.
+    const uint64 SerialStartCycles = FPlatformTime::Cycles64();
+    for (int32 i = 0; i < ScopesPerTask; i++)
+    {
+        FMazeTelemetryPhaseScope Scope(EMazeTelemetryPhase::Sensing);
+    }
+    const double SharedCost = static_cast<double>(FPlatformTime::Cycles64() - SerialStartCycles) / ScopesPerTask;
+
+    return FMath::Max(BufferedCost, SharedCost);
+}
+
+void FMazeTelemetry::ConsumePhaseTimes(FGenerationTelemetry& Record)
+{
+    for (int32 i = 0; i < static_cast<int32>(EMazeTelemetryPhase::Count); i++)
+    {
+        Record.PhaseMs[i] = FPlatformTime::ToMilliseconds64(PhaseCycles[i].exchange(0, std::memory_order_relaxed));
+    }
+    Record.PhaseScopes = PhaseScopeCount.exchange(0, std::memory_order_relaxed);
+}
+
+float FMazeTelemetry::ComputeDiversity(const TArray<UNeuralNetwork*>& Population)
+{
+    // Single pass: mean squared distance to the centroid = mean(|w|^2) - |mean(w)|^2.
+    TArray<float> Weights;
+    TArray<double> Sum;
+    double SumSquaredNorms = 0.0;
+    int32 Count = 0;
+    for (const UNeuralNetwork* Network : Population)
+    {
+        if (!Network)
+        {
+            continue;
+        }
+        Network->FlattenWeights(Weights);
+        if (Count == 0)
+        {
+            Sum.Init(0.0, Weights.Num());
+        }
+        else if (Weights.Num() != Sum.Num())
+        {
+            // Mixed layouts have no common centroid.
+            continue;
+        }
+
+        for (int32 i = 0; i < Weights.Num(); i++)
+        {
+            Sum[i] += Weights[i];
+            SumSquaredNorms += Weights[i] * Weights[i];
+        }
+        Count++;
+    }
+
+    if (Count == 0 || Sum.Num() == 0)
+    {
+        return 0.f;
+    }
+
+    double CentroidSquaredNorm = 0.0;
+    for (const double Value : Sum)
+    {
+        CentroidSquaredNorm += (Value / Count) * (Value / Count);
+    }
+    const double MeanSquaredDistance = FMath::Max(0.0, SumSquaredNorms / Count - CentroidSquaredNorm);
+    return static_cast<float>(FMath::Sqrt(MeanSquaredDistance / Sum.Num()));
+}
+
+uint32 FMazeTelemetry::Run()
+{
+    while (true)
+    {
+        FGenerationTelemetry Record;
+        while (PendingRecords.Dequeue(Record))
+        {
+            WriteRecord(Record);
+        }
+
+        // Records submitted before Stop() are still written.
+        if (bStopping)
+        {
+            break;
+        }
+        WakeEvent->Wait(FTimespan::FromMilliseconds(500));
+    }
+    return 0;
+}
+
+void FMazeTelemetry::Stop()
+{
+    bStopping = true;
+    if (WakeEvent)
+    {
+        WakeEvent->Trigger();
+    }
+}
+
+void FMazeTelemetry::WriteRecord(const FGenerationTelemetry& Record)
+{
+    TArray<float> Sorted = Record.Fitness;
+    Sorted.Sort();
+
+    float MinFitness = 0.f, MeanFitness = 0.f, MaxFitness = 0.f, P10 = 0.f, P50 = 0.f, P90 = 0.f;
+    if (Sorted.Num() > 0)
+    {
+        double Sum = 0.0;
+        for (const float Value : Sorted)
+        {
+            Sum += Value;
+        }
+        MinFitness = Sorted[0];
+        MaxFitness = Sorted.Last();
+        MeanFitness = static_cast<float>(Sum / Sorted.Num());
+        P10 = Percentile(Sorted, 0.1f);
+        P50 = Percentile(Sorted, 0.5f);
+        P90 = Percentile(Sorted, 0.9f);
+    }
+    const double ScopeMs = FPlatformTime::ToMilliseconds64(static_cast<uint64>(Record.PhaseScopes * ScopeCostCycles));
+    const double OverheadPercent = Record.WallSeconds > 0.0 ? (Record.OverheadMs + ScopeMs) / (Record.WallSeconds * 10.0) : 0.0;
+
+    FString Csv = FString::Printf(TEXT("%d,%.4f,%.3f,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.6f,%.4f"),
+        Record.Generation, Record.WallSeconds, Record.SimulatedSeconds, Record.Fitness.Num(),
+        MinFitness, MeanFitness, MaxFitness, P10, P50, P90, Record.Diversity, Record.CacheHitRate);
+    FString Json = FString::Printf(TEXT("{\"generation\":%d,\"wall_s\":%.4f,\"sim_s\":%.3f,\"evaluations\":%d,")
+        TEXT("\"fitness\":{\"min\":%.4f,\"mean\":%.4f,\"max\":%.4f,\"p10\":%.4f,\"p50\":%.4f,\"p90\":%.4f},")
+        TEXT("\"diversity\":%.6f,\"cache_hit_rate\":%.4f,\"phases_ms\":{"),
+        Record.Generation, Record.WallSeconds, Record.SimulatedSeconds, Record.Fitness.Num(),
+        MinFitness, MeanFitness, MaxFitness, P10, P50, P90, Record.Diversity, Record.CacheHitRate);
+
+    for (int32 i = 0; i < static_cast<int32>(EMazeTelemetryPhase::Count); i++)
+    {
+        Csv += FString::Printf(TEXT(",%.3f"), Record.PhaseMs[i]);
+        Json += FString::Printf(TEXT("%s\"%s\":%.3f"), i > 0 ? TEXT(",") : TEXT(""), PhaseNames[i], Record.PhaseMs[i]);
+    }
+
+    Csv += FString::Printf(TEXT(",%.4f,%s"), OverheadPercent, *JoinSamples(Record.ActiveAgents, TEXT(";")));
+    Json += FString::Printf(TEXT("},\"overhead_pct\":%.4f,\"active_agents\":[%s]}"), OverheadPercent, *JoinSamples(Record.ActiveAgents, TEXT(",")));
+
+    WriteLine(*CsvFile, Csv);
+    WriteLine(*JsonFile, Json);
+}
+
+void FMazeTelemetry::WriteLine(FArchive& File, const FString& Line)
+{
+    FTCHARToUTF8 Utf8(*(Line + TEXT("\n")));
+    File.Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Utf8.Length());
+    // Flushed per record so a crashed or killed run keeps its history.
+    File.Flush();
+}
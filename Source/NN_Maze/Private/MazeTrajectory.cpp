@@ -0,0 +1,161 @@
+#include "MazeTrajectory.h"
+#include "Algo/BinarySearch.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+    // "NNTR", then the format version.
+    const uint32 ReplayFileMagic = 0x5254'4E4E;
+    const int32 ReplayFileVersion = 1;
+
+    uint8 QuantizeYaw(float Yaw)
+    {
+        return static_cast<uint8>(FMath::RoundToInt32(Yaw * (256.f / 360.f)) & 0xFF);
+    }
+}
+
+void FMazeTrajectoryRun::Decode(TArray<FVector>& OutLocations, TArray<float>& OutYaws) const
+{
+    OutLocations.SetNumUninitialized(Samples.Num());
+    OutYaws.SetNumUninitialized(Samples.Num());
+
+    FIntPoint Position = FIntPoint::ZeroValue;
+    for (int32 i = 0; i < Samples.Num(); i++)
+    {
+        Position.X += Samples[i].DeltaX;
+        Position.Y += Samples[i].DeltaY;
+        OutLocations[i] = Origin + FVector(Position.X * Quantum, Position.Y * Quantum, 0.f);
+        OutYaws[i] = Samples[i].Yaw * (360.f / 256.f);
+    }
+}
+
+FString FMazeTrajectoryRun::GetReplayPath(const FString& Name)
+{
+    return FPaths::ProjectSavedDir() / TEXT("Replays") / Name + TEXT(".nnreplay");
+}
+
+bool FMazeTrajectoryRun::SaveRuns(const FString& Path, const TArray<FMazeTrajectoryRun>& Runs)
+{
+    TArray<uint8> Bytes;
+    FMemoryWriter Writer(Bytes);
+    uint32 Magic = ReplayFileMagic;
+    int32 Version = ReplayFileVersion;
+    Writer << Magic << Version;
+    Writer << const_cast<TArray<FMazeTrajectoryRun>&>(Runs);
+    return FFileHelper::SaveArrayToFile(Bytes, *Path);
+}
+
+bool FMazeTrajectoryRun::LoadRuns(const FString& Path, TArray<FMazeTrajectoryRun>& OutRuns)
+{
+    OutRuns.Reset();
+    TArray<uint8> Bytes;
+    if (!FFileHelper::LoadFileToArray(Bytes, *Path, FILEREAD_Silent))
+    {
+        return false;
+    }
+
+    FMemoryReader Reader(Bytes);
+    uint32 Magic = 0;
+    int32 Version = 0;
+    Reader << Magic << Version;
+    if (Magic != ReplayFileMagic || Version != ReplayFileVersion)
+    {
+        UE_LOG(LogTemp, Error, TEXT("%s is not a replay file of version %d"), *Path, ReplayFileVersion);
+        return false;
+    }
+    Reader << OutRuns;
+    if (Reader.IsError())
+    {
+        UE_LOG(LogTemp, Error, TEXT("Replay file %s is truncated"), *Path);
+        OutRuns.Reset();
+        return false;
+    }
+    return true;
+}
+
+void FMazeTrajectoryRecorder::Reset(int32 NumAgents, int32 InCapacity, float InSampleInterval, float InQuantum)
+{
+    Capacity = FMath::Max(2, InCapacity);
+    SampleInterval = InSampleInterval;
+    Quantum = FMath::Max(InQuantum, UE_KINDA_SMALL_NUMBER);
+    Samples.SetNumUninitialized(NumAgents * Capacity, EAllowShrinking::No);
+    Heads.Reset();
+    Heads.SetNum(NumAgents);
+}
+
+void FMazeTrajectoryRecorder::BeginEpisode(int32 AgentIndex, const FVector& Location, float Yaw)
+{
+    FHead& Head = Heads[AgentIndex];
+    Head = FHead();
+    Head.Anchor = Location;
+
+    FMazeTrajectorySample& Sample = Samples[AgentIndex * Capacity];
+    Sample = FMazeTrajectorySample();
+    Sample.Yaw = QuantizeYaw(Yaw);
+    Head.Num = 1;
+}
+
+void FMazeTrajectoryRecorder::Record(int32 AgentIndex, const FVector& Location, float Yaw)
+{
+    FHead& Head = Heads[AgentIndex];
+    FMazeTrajectorySample* Ring = &Samples[AgentIndex * Capacity];
+
+    // Full ring: the oldest displacement moves into the base.
+    if (Head.Num == Capacity)
+    {
+        Head.Base.X += Ring[Head.First].DeltaX;
+        Head.Base.Y += Ring[Head.First].DeltaY;
+        Head.First = (Head.First + 1) % Capacity;
+        Head.Num--;
+    }
+
+    // Displacement from the reconstructed position, not from the previous location.
+    const FVector Offset = (Location - Head.Anchor) / Quantum;
+    FMazeTrajectorySample& Sample = Ring[(Head.First + Head.Num) % Capacity];
+    Sample.DeltaX = static_cast<int8>(FMath::Clamp(FMath::RoundToInt32(Offset.X) - Head.Cursor.X, -127, 127));
+    Sample.DeltaY = static_cast<int8>(FMath::Clamp(FMath::RoundToInt32(Offset.Y) - Head.Cursor.Y, -127, 127));
+    Sample.Yaw = QuantizeYaw(Yaw);
+    Head.Cursor.X += Sample.DeltaX;
+    Head.Cursor.Y += Sample.DeltaY;
+    Head.Num++;
+}
+
+bool FMazeTrajectoryRecorder::WouldKeepRun(float Fitness, int32 MaxRuns) const
+{
+    return MaxRuns > 0 && (TopRuns.Num() < MaxRuns || Fitness > TopRuns.Last().Fitness);
+}
+
+bool FMazeTrajectoryRecorder::SubmitRun(int32 AgentIndex, float Fitness, int32 Generation, int32 MazeInstance, const FVector& OriginOffset, int32 MaxRuns)
+{
+    if (!Heads.IsValidIndex(AgentIndex) || Heads[AgentIndex].Num == 0 || !WouldKeepRun(Fitness, MaxRuns))
+    {
+        return false;
+    }
+
+    const FHead& Head = Heads[AgentIndex];
+    FMazeTrajectoryRun Run;
+    Run.Generation = Generation;
+    Run.Fitness = Fitness;
+    Run.MazeInstance = MazeInstance;
+    Run.SampleInterval = SampleInterval;
+    Run.Quantum = Quantum;
+    Run.Origin = Head.Anchor - OriginOffset + FVector(Head.Base.X * Quantum, Head.Base.Y * Quantum, 0.f);
+    Run.Samples.SetNumUninitialized(Head.Num);
+    const FMazeTrajectorySample* Ring = &Samples[AgentIndex * Capacity];
+    for (int32 i = 0; i < Head.Num; i++)
+    {
+        Run.Samples[i] = Ring[(Head.First + i) % Capacity];
+    }
+
+    // Best first; a run ties after the runs already kept.
+    const int32 Index = Algo::UpperBoundBy(TopRuns, -Fitness, [](const FMazeTrajectoryRun& Kept) { return -Kept.Fitness; });
+    TopRuns.Insert(MoveTemp(Run), Index);
+    if (TopRuns.Num() > MaxRuns)
+    {
+        TopRuns.SetNum(MaxRuns);
+    }
+    return true;
+}
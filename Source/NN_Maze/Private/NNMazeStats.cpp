@@ -0,0 +1,73 @@
+#include "NNMazeStats.h"
+#include "HAL/MemoryBase.h"
+#include "ProfilingDebugging/CountersTrace.h"
+
+UE_TRACE_CHANNEL_DEFINE(NNMazeChannel);
+
+DEFINE_STAT(STAT_NNMaze_Sensing);
+DEFINE_STAT(STAT_NNMaze_Inference);
+DEFINE_STAT(STAT_NNMaze_Movement);
+DEFINE_STAT(STAT_NNMaze_Breeding);
+DEFINE_STAT(STAT_NNMaze_Spawning);
+DEFINE_STAT(STAT_NNMaze_AgentTick);
+DEFINE_STAT(STAT_NNMaze_ManagerTick);
+DEFINE_STAT(STAT_NNMaze_ProcessGeneration);
+DEFINE_STAT(STAT_NNMaze_EmitMigrants);
+DEFINE_STAT(STAT_NNMaze_BreedIsland);
+DEFINE_STAT(STAT_NNMaze_HeadlessEvaluation);
+DEFINE_STAT(STAT_NNMaze_ActiveAgents);
+DEFINE_STAT(STAT_NNMaze_RaysPerFrame);
+DEFINE_STAT(STAT_NNMaze_InferencesPerFrame);
+DEFINE_STAT(STAT_NNMaze_AllocationsPerFrame);
+DEFINE_STAT(STAT_NNMaze_GenerationTransitionMs);
+DEFINE_STAT(STAT_NNMaze_PopulationMemory);
+DEFINE_STAT(STAT_NNMaze_NetworksCreated);
+
+TRACE_DECLARE_INT_COUNTER(NNMaze_RaysPerFrame, TEXT("NNMaze/RaysPerFrame"));
+TRACE_DECLARE_INT_COUNTER(NNMaze_InferencesPerFrame, TEXT("NNMaze/InferencesPerFrame"));
+TRACE_DECLARE_INT_COUNTER(NNMaze_AllocationsPerFrame, TEXT("NNMaze/AllocationsPerFrame"));
+TRACE_DECLARE_FLOAT_COUNTER(NNMaze_GenerationTransitionMs, TEXT("NNMaze/GenerationTransitionMs"));
+TRACE_DECLARE_MEMORY_COUNTER(NNMaze_PopulationMemory, TEXT("NNMaze/PopulationMemory"));
+TRACE_DECLARE_INT_COUNTER(NNMaze_NetworksCreated, TEXT("NNMaze/NetworksCreated"));
+
+std::atomic<int32> FNNMazeFrameCounters::Rays(0);
+std::atomic<int32> FNNMazeFrameCounters::Inferences(0);
+int64 FNNMazeFrameCounters::TotalInferences = 0;
+uint64 FNNMazeFrameCounters::LastMallocCalls = 0;
+
+void FNNMazeFrameCounters::PublishFrame()
+{
+    const int32 FrameRays = Rays.exchange(0, std::memory_order_relaxed);
+    const int32 FrameInferences = Inferences.exchange(0, std::memory_order_relaxed);
+    TotalInferences += FrameInferences;
+
+    SET_DWORD_STAT(STAT_NNMaze_RaysPerFrame, FrameRays);
+    SET_DWORD_STAT(STAT_NNMaze_InferencesPerFrame, FrameInferences);
+    TRACE_COUNTER_SET(NNMaze_RaysPerFrame, FrameRays);
+    TRACE_COUNTER_SET(NNMaze_InferencesPerFrame, FrameInferences);
+
+#if STATS
+    // Allocator call counters are only maintained when stats are compiled in. Counts every
+    // allocation of the process during the frame, not only the ones made by this module.
+    const uint64 MallocCalls = FMalloc::TotalMallocCalls;
+    const int64 FrameAllocations = LastMallocCalls > 0 ? static_cast<int64>(MallocCalls - LastMallocCalls) : 0;
+    LastMallocCalls = MallocCalls;
+
+    SET_DWORD_STAT(STAT_NNMaze_AllocationsPerFrame, FrameAllocations);
+    TRACE_COUNTER_SET(NNMaze_AllocationsPerFrame, FrameAllocations);
+#endif
+}
+
+void FNNMazeFrameCounters::PublishGenerationTransition(double Milliseconds)
+{
+    SET_FLOAT_STAT(STAT_NNMaze_GenerationTransitionMs, Milliseconds);
+    TRACE_COUNTER_SET(NNMaze_GenerationTransitionMs, Milliseconds);
+}
+
+void FNNMazeFrameCounters::PublishPopulationMemory(int64 Bytes, int32 NetworksCreated)
+{
+    SET_MEMORY_STAT(STAT_NNMaze_PopulationMemory, Bytes);
+    SET_DWORD_STAT(STAT_NNMaze_NetworksCreated, NetworksCreated);
+    TRACE_COUNTER_SET(NNMaze_PopulationMemory, Bytes);
+    TRACE_COUNTER_SET(NNMaze_NetworksCreated, NetworksCreated);
+}
@@ -0,0 +1,274 @@
+#include "NeatEvolutionManager.h"
+#include "NeuralNetwork.h"
+#include "NNMazeStats.h"
+#include "Algo/Sort.h"
+
+UNeatEvolutionManager::UNeatEvolutionManager()
+{
+    // Defaults from the original NEAT experiments.
+    CompatibilityThreshold = 3.f;
+    TargetSpeciesCount = 10;
+    ExcessCoefficient = 1.f;
+    DisjointCoefficient = 1.f;
+    WeightCoefficient = 0.4f;
+    AddConnectionProbability = 0.05f;
+    AddNodeProbability = 0.03f;
+    WeightMutationProbability = 0.8f;
+    WeightPerturbPower = 0.5f;
+    WeightReplaceProbability = 0.1f;
+    CrossoverRate = 0.75f;
+    SurvivalThreshold = 0.2f;
+    StagnationGenerations = 15;
+
+    RandomStream.Initialize(FMath::Rand());
+    NextSpeciesId = 0;
+    NeatGeneration = 0;
+    bInnovationsInitialized = false;
+}
+
+void UNeatEvolutionManager::InitializeNetwork(UNeuralNetwork* Network, const TArray<int32>& LayerConfig, bool bRecurrent)
+{
+    if (LayerConfig.Num() < 2)
+    {
+        UE_LOG(LogTemp, Error, TEXT("NEAT needs at least an input and an output layer size"));
+        return;
+    }
+
+    // Hidden layer sizes are ignored: NEAT grows its own hidden nodes.
+    const int32 NumInputs = LayerConfig[0];
+    const int32 NumOutputs = LayerConfig.Last();
+    if (!bInnovationsInitialized)
+    {
+        Innovations.Reset(FNeatGenome::GetFirstHiddenNodeId(NumInputs, NumOutputs));
+        bInnovationsInitialized = true;
+    }
+    Network->SetGenome(FNeatGenome::CreateMinimal(NumInputs, NumOutputs, Innovations, RandomStream));
+}
+
+void UNeatEvolutionManager::ProcessGeneration(TArray<UNeuralNetwork*>& CurrentGeneration,
+    TArray<UNeuralNetwork*>& NextGeneration,
+    float& OutGenerationFitnessMean,
+    int32 PopulationSize)
+{
+    NNMAZE_PHASE_SCOPE(Breeding);
+
+    // Remember the evaluated fitness so identical genomes are not simulated again.
+    RecordFitness(CurrentGeneration);
+    PrepareSelectionScores(CurrentGeneration);
+
+    OutGenerationFitnessMean = 0.f;
+    const int32 Population = FMath::Min(PopulationSize, CurrentGeneration.Num());
+    if (Population <= 0 || CurrentGeneration.Contains(nullptr))
+    {
+        UE_LOG(LogTemp, Error, TEXT("ProcessGeneration called with an empty or incomplete population"));
+        NextGeneration.Empty();
+        return;
+    }
+
+    float BestFitness = TNumericLimits<float>::Lowest();
+    for (int32 i = 0; i < Population; i++)
+    {
+        // Networks that did not come from InitializeNetwork start over from a minimal genome.
+        if (!CurrentGeneration[i]->GetGenome())
+        {
+            InitializeNetwork(CurrentGeneration[i], CurrentGeneration[i]->LayerSizes, false);
+        }
+        OutGenerationFitnessMean += CurrentGeneration[i]->Fitness;
+        BestFitness = FMath::Max(BestFitness, CurrentGeneration[i]->Fitness);
+    }
+    OutGenerationFitnessMean /= PopulationSize;
+
+    NeatGeneration++;
+    Speciate(CurrentGeneration);
+
+    // Sort each species best first (on the selection score) and track improvements.
+    int32 BestSpeciesId = INDEX_NONE;
+    float BestScore = TNumericLimits<float>::Lowest();
+    for (FNeatSpecies& Group : Species)
+    {
+        Algo::Sort(Group.Members, [&CurrentGeneration](int32 A, int32 B)
+            {
+                return CurrentGeneration[A]->SelectionScore > CurrentGeneration[B]->SelectionScore;
+            });
+
+        const float GroupBest = CurrentGeneration[Group.Members[0]]->SelectionScore;
+        if (GroupBest > Group.BestFitness)
+        {
+            Group.BestFitness = GroupBest;
+            Group.LastImprovementGeneration = NeatGeneration;
+        }
+        if (GroupBest > BestScore)
+        {
+            BestScore = GroupBest;
+            BestSpeciesId = Group.Id;
+        }
+    }
+
+    // Stagnant species are dropped, except the one holding the best genome.
+    const int32 NumSpeciesBefore = Species.Num();
+    Species.RemoveAll([this, BestSpeciesId](const FNeatSpecies& Group)
+        {
+            return Group.Id != BestSpeciesId && NeatGeneration - Group.LastImprovementGeneration >= StagnationGenerations;
+        });
+
+    // Explicit fitness sharing: a species gets offspring in proportion to the mean (shifted) fitness of its members.
+    float MinFitness = TNumericLimits<float>::Max();
+    for (const FNeatSpecies& Group : Species)
+    {
+        for (const int32 Member : Group.Members)
+        {
+            MinFitness = FMath::Min(MinFitness, CurrentGeneration[Member]->SelectionScore);
+        }
+    }
+
+    TArray<double> Shares;
+    double TotalShare = 0.0;
+    for (const FNeatSpecies& Group : Species)
+    {
+        double Sum = 0.0;
+        for (const int32 Member : Group.Members)
+        {
+            Sum += CurrentGeneration[Member]->SelectionScore - MinFitness;
+        }
+        // Small floor so a species of equally bad genomes still gets a chance.
+        const double Share = Sum / Group.Members.Num() + 1e-3;
+        Shares.Add(Share);
+        TotalShare += Share;
+    }
+
+    // Largest remainder rounding, so the counts add up to the population exactly.
+    TArray<int32> OffspringCounts;
+    TArray<TPair<double, int32>> Remainders;
+    int32 Assigned = 0;
+    for (int32 s = 0; s < Species.Num(); s++)
+    {
+        const double Quota = Shares[s] / TotalShare * Population;
+        OffspringCounts.Add(FMath::FloorToInt32(Quota));
+        Remainders.Add(TPair<double, int32>(Quota - OffspringCounts[s], s));
+        Assigned += OffspringCounts[s];
+    }
+    Algo::Sort(Remainders, [](const TPair<double, int32>& A, const TPair<double, int32>& B) { return A.Key > B.Key; });
+    for (int32 i = 0; Assigned < Population; i++, Assigned++)
+    {
+        OffspringCounts[Remainders[i % Remainders.Num()].Value]++;
+    }
+
+    // Every child gets a new genome (or its champion's), so reused slots need no reset.
+    PrepareGenerationSlots(CurrentGeneration, NextGeneration, Population);
+    for (int32 i = 0; i < Population; i++)
+    {
+        NextGeneration[i] = ReuseNetworkSlot(NextGeneration[i], TArray<int32>(), false);
+    }
+
+    int32 ChildIndex = 0;
+    for (int32 s = 0; s < Species.Num(); s++)
+    {
+        const FNeatSpecies& Group = Species[s];
+        int32 Count = OffspringCounts[s];
+
+        // The champion of a large enough species survives unchanged (it shares its compiled form).
+        if (Count > 0 && Group.Members.Num() >= 5)
+        {
+            NextGeneration[ChildIndex++]->CopyWeights(CurrentGeneration[Group.Members[0]]);
+            Count--;
+        }
+
+        const int32 NumParents = FMath::Clamp(FMath::CeilToInt32(SurvivalThreshold * Group.Members.Num()), 1, Group.Members.Num());
+        for (; Count > 0; Count--)
+        {
+            BreedChild(Group, NumParents, CurrentGeneration, NextGeneration[ChildIndex++]);
+        }
+    }
+
+    // New members are compared against a random member of the previous generation.
+    for (FNeatSpecies& Group : Species)
+    {
+        Group.Representative = *CurrentGeneration[Group.Members[RandomStream.RandRange(0, Group.Members.Num() - 1)]]->GetGenome();
+    }
+
+    if (TargetSpeciesCount > 0)
+    {
+        const float Step = 0.3f;
+        if (Species.Num() < TargetSpeciesCount)
+        {
+            CompatibilityThreshold = FMath::Max(Step, CompatibilityThreshold - Step);
+        }
+        else if (Species.Num() > TargetSpeciesCount)
+        {
+            CompatibilityThreshold += Step;
+        }
+    }
+
+    int32 TotalHiddenNodes = 0;
+    for (const UNeuralNetwork* Child : NextGeneration)
+    {
+        TotalHiddenNodes += Child->GetGenome() ? Child->GetGenome()->GetNumHiddenNodes() : 0;
+    }
+    UE_LOG(LogTemp, Log, TEXT("NEAT: %d species (%d stagnant dropped), threshold %.2f, best %.2f, %.2f hidden nodes per genome"),
+        Species.Num(), NumSpeciesBefore - Species.Num(), CompatibilityThreshold, BestFitness, static_cast<float>(TotalHiddenNodes) / Population);
+}
+
+void UNeatEvolutionManager::Speciate(const TArray<UNeuralNetwork*>& Generation)
+{
+    for (FNeatSpecies& Group : Species)
+    {
+        Group.Members.Reset();
+    }
+
+    for (int32 i = 0; i < Generation.Num(); i++)
+    {
+        const FNeatGenome* Genome = Generation[i] ? Generation[i]->GetGenome() : nullptr;
+        if (!Genome)
+        {
+            continue;
+        }
+
+        FNeatSpecies* Match = Species.FindByPredicate([this, Genome](const FNeatSpecies& Group)
+            {
+                return FNeatGenome::CompatibilityDistance(*Genome, Group.Representative, ExcessCoefficient, DisjointCoefficient, WeightCoefficient) < CompatibilityThreshold;
+            });
+        if (!Match)
+        {
+            Match = &Species.AddDefaulted_GetRef();
+            Match->Id = NextSpeciesId++;
+            Match->Representative = *Genome;
+            Match->LastImprovementGeneration = NeatGeneration;
+        }
+        Match->Members.Add(i);
+    }
+
+    Species.RemoveAll([](const FNeatSpecies& Group) { return Group.Members.Num() == 0; });
+}
+
+void UNeatEvolutionManager::BreedChild(const FNeatSpecies& Parents, int32 NumParents, const TArray<UNeuralNetwork*>& Generation, UNeuralNetwork* Child)
+{
+    const UNeuralNetwork* ParentA = Generation[Parents.Members[RandomStream.RandRange(0, NumParents - 1)]];
+
+    FNeatGenome ChildGenome;
+    if (NumParents > 1 && RandomStream.FRand() < CrossoverRate)
+    {
+        const UNeuralNetwork* ParentB = Generation[Parents.Members[RandomStream.RandRange(0, NumParents - 1)]];
+        const bool bAFitter = ParentA->SelectionScore >= ParentB->SelectionScore;
+        ChildGenome = FNeatGenome::Crossover(*(bAFitter ? ParentA : ParentB)->GetGenome(), *(bAFitter ? ParentB : ParentA)->GetGenome(), RandomStream);
+    }
+    else
+    {
+        ChildGenome = *ParentA->GetGenome();
+    }
+
+    if (RandomStream.FRand() < AddNodeProbability)
+    {
+        ChildGenome.MutateAddNode(Innovations, RandomStream);
+    }
+    if (RandomStream.FRand() < AddConnectionProbability)
+    {
+        ChildGenome.MutateAddConnection(Innovations, RandomStream);
+    }
+    if (RandomStream.FRand() < WeightMutationProbability)
+    {
+        ChildGenome.MutateWeights(WeightPerturbPower, WeightReplaceProbability, RandomStream);
+    }
+
+    // Compiled once here, then reused for every tick of the evaluation.
+    Child->SetGenome(MoveTemp(ChildGenome));
+}
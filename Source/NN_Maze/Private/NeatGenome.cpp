@@ -0,0 +1,412 @@
+#include "NeatGenome.h"
+#include "Algo/BinarySearch.h"
+#include "Hash/CityHash.h"
+#include <cmath>
+
+void FNeatInnovationTracker::Reset(int32 FirstHiddenNodeId)
+{
+    ConnectionInnovations.Reset();
+    SplitNodeIds.Reset();
+    NextInnovation = 0;
+    NextNodeId = FirstHiddenNodeId;
+}
+
+int32 FNeatInnovationTracker::GetConnectionInnovation(int32 From, int32 To)
+{
+    int32& Innovation = ConnectionInnovations.FindOrAdd(TPair<int32, int32>(From, To), INDEX_NONE);
+    if (Innovation == INDEX_NONE)
+    {
+        Innovation = NextInnovation++;
+    }
+    return Innovation;
+}
+
+int32 FNeatInnovationTracker::GetSplitNodeId(int32 ConnectionInnovation)
+{
+    int32& NodeId = SplitNodeIds.FindOrAdd(ConnectionInnovation, INDEX_NONE);
+    if (NodeId == INDEX_NONE)
+    {
+        NodeId = NextNodeId++;
+    }
+    return NodeId;
+}
+
+FNeatGenome FNeatGenome::CreateMinimal(int32 InNumInputs, int32 InNumOutputs, FNeatInnovationTracker& Innovations, FRandomStream& RandomStream)
+{
+    FNeatGenome Genome;
+    Genome.NumInputs = InNumInputs;
+    Genome.NumOutputs = InNumOutputs;
+
+    const int32 BiasId = InNumInputs;
+    for (int32 Id = 0; Id < GetFirstHiddenNodeId(InNumInputs, InNumOutputs); Id++)
+    {
+        const ENeatNodeType Type = Id < BiasId ? ENeatNodeType::Input : (Id == BiasId ? ENeatNodeType::Bias : ENeatNodeType::Output);
+        Genome.Nodes.Add({ Id, Type });
+    }
+
+    for (int32 Output = BiasId + 1; Output <= BiasId + InNumOutputs; Output++)
+    {
+        for (int32 Input = 0; Input <= BiasId; Input++)
+        {
+            FNeatConnectionGene Gene;
+            Gene.Innovation = Innovations.GetConnectionInnovation(Input, Output);
+            Gene.From = Input;
+            Gene.To = Output;
+            Gene.Weight = RandomStream.FRandRange(-1.f, 1.f);
+            Genome.AddConnection(Gene);
+        }
+    }
+    return Genome;
+}
+
+void FNeatGenome::MutateWeights(float PerturbPower, float ReplaceProbability, FRandomStream& RandomStream)
+{
+    for (FNeatConnectionGene& Gene : Connections)
+    {
+        if (RandomStream.FRand() < ReplaceProbability)
+        {
+            Gene.Weight = RandomStream.FRandRange(-1.f, 1.f);
+        }
+        else
+        {
+            // Bounded so tanh units do not saturate for good.
+            Gene.Weight = FMath::Clamp(Gene.Weight + RandomStream.FRandRange(-PerturbPower, PerturbPower), -8.f, 8.f);
+        }
+    }
+}
+
+bool FNeatGenome::MutateAddConnection(FNeatInnovationTracker& Innovations, FRandomStream& RandomStream)
+{
+    // Random pairs are cheap to test; a dense genome simply runs out of attempts.
+    const int32 MaxAttempts = 20;
+    for (int32 Attempt = 0; Attempt < MaxAttempts; Attempt++)
+    {
+        const FNeatNodeGene& From = Nodes[RandomStream.RandRange(0, Nodes.Num() - 1)];
+        const FNeatNodeGene& To = Nodes[RandomStream.RandRange(0, Nodes.Num() - 1)];
+        if (From.Id == To.Id || From.Type == ENeatNodeType::Output || To.Type == ENeatNodeType::Input || To.Type == ENeatNodeType::Bias)
+        {
+            continue;
+        }
+        if (HasConnection(From.Id, To.Id) || IsReachable(To.Id, From.Id))
+        {
+            continue;
+        }
+
+        FNeatConnectionGene Gene;
+        Gene.Innovation = Innovations.GetConnectionInnovation(From.Id, To.Id);
+        Gene.From = From.Id;
+        Gene.To = To.Id;
+        Gene.Weight = RandomStream.FRandRange(-1.f, 1.f);
+        AddConnection(Gene);
+        return true;
+    }
+    return false;
+}
+
+bool FNeatGenome::MutateAddNode(FNeatInnovationTracker& Innovations, FRandomStream& RandomStream)
+{
+    TArray<int32, TInlineAllocator<64>> Enabled;
+    for (int32 i = 0; i < Connections.Num(); i++)
+    {
+        if (Connections[i].bEnabled)
+        {
+            Enabled.Add(i);
+        }
+    }
+    if (Enabled.Num() == 0)
+    {
+        return false;
+    }
+
+    const FNeatConnectionGene Split = Connections[Enabled[RandomStream.RandRange(0, Enabled.Num() - 1)]];
+    const int32 NodeId = Innovations.GetSplitNodeId(Split.Innovation);
+    if (HasNode(NodeId))
+    {
+        // This genome already split the connection once (it was re-enabled by a crossover).
+        return false;
+    }
+
+    for (FNeatConnectionGene& Gene : Connections)
+    {
+        if (Gene.Innovation == Split.Innovation)
+        {
+            Gene.bEnabled = false;
+        }
+    }
+    Nodes.Insert({ NodeId, ENeatNodeType::Hidden }, Algo::LowerBoundBy(Nodes, NodeId, &FNeatNodeGene::Id));
+
+    // The incoming weight is 1 and the outgoing weight the old one, so the behaviour barely changes at first.
+    FNeatConnectionGene In;
+    In.Innovation = Innovations.GetConnectionInnovation(Split.From, NodeId);
+    In.From = Split.From;
+    In.To = NodeId;
+    In.Weight = 1.f;
+    AddConnection(In);
+
+    FNeatConnectionGene Out;
+    Out.Innovation = Innovations.GetConnectionInnovation(NodeId, Split.To);
+    Out.From = NodeId;
+    Out.To = Split.To;
+    Out.Weight = Split.Weight;
+    AddConnection(Out);
+    return true;
+}
+
+FNeatGenome FNeatGenome::Crossover(const FNeatGenome& Fitter, const FNeatGenome& Other, FRandomStream& RandomStream)
+{
+    FNeatGenome Child;
+    Child.NumInputs = Fitter.NumInputs;
+    Child.NumOutputs = Fitter.NumOutputs;
+
+    // The child has the fitter parent's structure, so it also has its nodes.
+    Child.Nodes = Fitter.Nodes;
+    Child.Connections.Reserve(Fitter.Connections.Num());
+
+    int32 OtherIndex = 0;
+    for (const FNeatConnectionGene& Gene : Fitter.Connections)
+    {
+        while (OtherIndex < Other.Connections.Num() && Other.Connections[OtherIndex].Innovation < Gene.Innovation)
+        {
+            OtherIndex++;
+        }
+
+        FNeatConnectionGene& ChildGene = Child.Connections.Add_GetRef(Gene);
+        if (OtherIndex < Other.Connections.Num() && Other.Connections[OtherIndex].Innovation == Gene.Innovation)
+        {
+            const FNeatConnectionGene& OtherGene = Other.Connections[OtherIndex];
+            if (RandomStream.FRand() < 0.5f)
+            {
+                ChildGene.Weight = OtherGene.Weight;
+            }
+            ChildGene.bEnabled = (Gene.bEnabled && OtherGene.bEnabled) || RandomStream.FRand() >= 0.75f;
+        }
+    }
+    return Child;
+}
+
+float FNeatGenome::CompatibilityDistance(const FNeatGenome& A, const FNeatGenome& B, float ExcessCoefficient, float DisjointCoefficient, float WeightCoefficient)
+{
+    int32 IndexA = 0;
+    int32 IndexB = 0;
+    int32 Matching = 0;
+    int32 Disjoint = 0;
+    float WeightDifference = 0.f;
+    while (IndexA < A.Connections.Num() && IndexB < B.Connections.Num())
+    {
+        const FNeatConnectionGene& GeneA = A.Connections[IndexA];
+        const FNeatConnectionGene& GeneB = B.Connections[IndexB];
+        if (GeneA.Innovation == GeneB.Innovation)
+        {
+            WeightDifference += FMath::Abs(GeneA.Weight - GeneB.Weight);
+            Matching++;
+            IndexA++;
+            IndexB++;
+        }
+        else
+        {
+            Disjoint++;
+            (GeneA.Innovation < GeneB.Innovation ? IndexA : IndexB)++;
+        }
+    }
+    const int32 Excess = (A.Connections.Num() - IndexA) + (B.Connections.Num() - IndexB);
+
+    // Small genomes are not normalized, as in the original NEAT.
+    const int32 LargerSize = FMath::Max(A.Connections.Num(), B.Connections.Num());
+    const float N = LargerSize < 20 ? 1.f : static_cast<float>(LargerSize);
+    const float MeanWeightDifference = Matching > 0 ? WeightDifference / Matching : 0.f;
+    return ExcessCoefficient * Excess / N + DisjointCoefficient * Disjoint / N + WeightCoefficient * MeanWeightDifference;
+}
+
+uint64 FNeatGenome::ComputeHash(uint64 Seed) const
+{
+    const int32 Header[] = { NumInputs, NumOutputs, Nodes.Num() };
+    uint64 Hash = CityHash64WithSeed(reinterpret_cast<const char*>(Header), sizeof(Header), Seed);
+    for (const FNeatConnectionGene& Gene : Connections)
+    {
+        // Field by field: the struct has padding bytes.
+        uint32 Fields[5] = { static_cast<uint32>(Gene.Innovation), static_cast<uint32>(Gene.From), static_cast<uint32>(Gene.To), 0, Gene.bEnabled ? 1u : 0u };
+        FMemory::Memcpy(&Fields[3], &Gene.Weight, sizeof(float));
+        Hash = CityHash64WithSeed(reinterpret_cast<const char*>(Fields), sizeof(Fields), Hash);
+    }
+    return Hash;
+}
+
+bool FNeatGenome::HasNode(int32 Id) const
+{
+    return Algo::BinarySearchBy(Nodes, Id, &FNeatNodeGene::Id) != INDEX_NONE;
+}
+
+bool FNeatGenome::HasConnection(int32 From, int32 To) const
+{
+    return Connections.ContainsByPredicate([From, To](const FNeatConnectionGene& Gene) { return Gene.From == From && Gene.To == To; });
+}
+
+void FNeatGenome::AddConnection(const FNeatConnectionGene& Gene)
+{
+    Connections.Insert(Gene, Algo::LowerBoundBy(Connections, Gene.Innovation, &FNeatConnectionGene::Innovation));
+}
+
+bool FNeatGenome::IsReachable(int32 From, int32 To) const
+{
+    TArray<int32, TInlineAllocator<32>> Stack;
+    TSet<int32> Visited;
+    Stack.Add(From);
+    while (Stack.Num() > 0)
+    {
+        const int32 Node = Stack.Pop(EAllowShrinking::No);
+        if (Node == To)
+        {
+            return true;
+        }
+        bool bAlreadyVisited = false;
+        Visited.Add(Node, &bAlreadyVisited);
+        if (bAlreadyVisited)
+        {
+            continue;
+        }
+        for (const FNeatConnectionGene& Gene : Connections)
+        {
+            if (Gene.From == Node)
+            {
+                Stack.Add(Gene.To);
+            }
+        }
+    }
+    return false;
+}
+
+FNeatCompiledNetwork::FNeatCompiledNetwork(const FNeatGenome& Genome)
+{
+    NumInputs = Genome.NumInputs;
+    const int32 NumNodes = Genome.Nodes.Num();
+
+    TMap<int32, int32> NodeIndexById;
+    NodeIndexById.Reserve(NumNodes);
+    for (int32 i = 0; i < NumNodes; i++)
+    {
+        NodeIndexById.Add(Genome.Nodes[i].Id, i);
+    }
+
+    // Adjacency of the enabled connections, by node index.
+    TArray<TArray<int32>> Outgoing;
+    TArray<TArray<TPair<int32, float>>> Incoming;
+    TArray<int32> InDegree;
+    Outgoing.SetNum(NumNodes);
+    Incoming.SetNum(NumNodes);
+    InDegree.SetNumZeroed(NumNodes);
+    for (const FNeatConnectionGene& Gene : Genome.Connections)
+    {
+        const int32* From = NodeIndexById.Find(Gene.From);
+        const int32* To = NodeIndexById.Find(Gene.To);
+        if (Gene.bEnabled && From && To)
+        {
+            Outgoing[*From].Add(*To);
+            Incoming[*To].Add(TPair<int32, float>(*From, Gene.Weight));
+            InDegree[*To]++;
+        }
+    }
+
+    // Kahn's algorithm. Inputs and the bias (node ids 0..NumInputs) keep slots 0..NumInputs.
+    TArray<int32> SlotOfNode;
+    SlotOfNode.Init(INDEX_NONE, NumNodes);
+    TArray<int32> Order;
+    Order.Reserve(NumNodes);
+    for (int32 i = 0; i < NumNodes; i++)
+    {
+        const ENeatNodeType Type = Genome.Nodes[i].Type;
+        if (Type == ENeatNodeType::Input || Type == ENeatNodeType::Bias)
+        {
+            SlotOfNode[i] = Genome.Nodes[i].Id;
+            Order.Add(i);
+        }
+    }
+    for (int32 i = 0; i < NumNodes; i++)
+    {
+        if (SlotOfNode[i] == INDEX_NONE && InDegree[i] == 0)
+        {
+            Order.Add(i);
+        }
+    }
+    int32 NextSlot = NumInputs + 1;
+    for (int32 Cursor = 0; Cursor < Order.Num(); Cursor++)
+    {
+        const int32 Node = Order[Cursor];
+        if (SlotOfNode[Node] == INDEX_NONE)
+        {
+            SlotOfNode[Node] = NextSlot++;
+        }
+        for (const int32 Target : Outgoing[Node])
+        {
+            if (--InDegree[Target] == 0)
+            {
+                Order.Add(Target);
+            }
+        }
+    }
+    // Genomes are acyclic by construction; should one not be, its remaining nodes go last.
+    for (int32 i = 0; i < NumNodes; i++)
+    {
+        if (SlotOfNode[i] == INDEX_NONE)
+        {
+            SlotOfNode[i] = NextSlot++;
+        }
+    }
+    NumSlots = NextSlot;
+
+    TArray<int32> NodeOfSlot;
+    NodeOfSlot.SetNum(NumSlots);
+    for (int32 i = 0; i < NumNodes; i++)
+    {
+        NodeOfSlot[SlotOfNode[i]] = i;
+    }
+
+    // CSR rows of the computed slots; a connection from a later slot (cycle) is dropped.
+    RowOffsets.Reserve(NumSlots - NumInputs);
+    RowOffsets.Add(0);
+    for (int32 Slot = NumInputs + 1; Slot < NumSlots; Slot++)
+    {
+        for (const TPair<int32, float>& Connection : Incoming[NodeOfSlot[Slot]])
+        {
+            const int32 SourceSlot = SlotOfNode[Connection.Key];
+            if (SourceSlot < Slot)
+            {
+                SourceSlots.Add(SourceSlot);
+                RowWeights.Add(Connection.Value);
+            }
+        }
+        RowOffsets.Add(SourceSlots.Num());
+    }
+
+    // Output node ids are consecutive and follow the bias.
+    for (int32 Output = 0; Output < Genome.NumOutputs; Output++)
+    {
+        const int32* Node = NodeIndexById.Find(NumInputs + 1 + Output);
+        OutputSlots.Add(Node ? SlotOfNode[*Node] : INDEX_NONE);
+    }
+}
+
+void FNeatCompiledNetwork::Evaluate(TConstArrayView<float> Inputs, TArrayView<float> Outputs) const
+{
+    check(Inputs.Num() == NumInputs && Outputs.Num() == OutputSlots.Num());
+
+    TArray<float, TInlineAllocator<64>> Values;
+    Values.SetNumUninitialized(NumSlots);
+    FMemory::Memcpy(Values.GetData(), Inputs.GetData(), NumInputs * sizeof(float));
+    Values[NumInputs] = 1.f;
+
+    const int32 FirstComputedSlot = NumInputs + 1;
+    for (int32 Row = 0; Row < NumSlots - FirstComputedSlot; Row++)
+    {
+        float Sum = 0.f;
+        for (int32 Entry = RowOffsets[Row]; Entry < RowOffsets[Row + 1]; Entry++)
+        {
+            Sum += RowWeights[Entry] * Values[SourceSlots[Entry]];
+        }
+        Values[FirstComputedSlot + Row] = tanh(Sum);
+    }
+
+    for (int32 Output = 0; Output < OutputSlots.Num(); Output++)
+    {
+        Outputs[Output] = OutputSlots[Output] != INDEX_NONE ? Values[OutputSlots[Output]] : 0.f;
+    }
+}
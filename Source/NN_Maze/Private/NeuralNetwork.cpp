@@ -1,7 +1,78 @@
 #include "NeuralNetwork.h"
+#include "Hash/CityHash.h"
 #include <cmath>
 
-void UNeuralNetwork::Initialize(const TArray<int32>& Layers)
+namespace
+{
+    float SampleGaussian(FRandomStream& RandomStream)
+    {
+        // Box-Muller; the second value of the pair is not worth caching at mutation rates.
+        const float Radius = FMath::Sqrt(-2.f * FMath::Loge(FMath::Max(RandomStream.GetFraction(), UE_SMALL_NUMBER)));
+        return Radius * FMath::Cos(UE_TWO_PI * RandomStream.GetFraction());
+    }
+
+    // ln(1 - P) for a mutation rate of Condition percent.
+    double GetLogKeepProbability(float Condition)
+    {
+        const double Probability = FMath::Clamp(Condition / 100.0, 0.0, 1.0);
+        return Probability >= 1.0 ? -TNumericLimits<double>::Max() : FMath::Loge(1.0 - Probability);
+    }
+
+    // Number of weights left untouched before the next mutated one: geometric with P = 1 - exp(LogKeep).
+    int64 DrawSkip(double LogKeep, FRandomStream& RandomStream)
+    {
+        if (LogKeep == 0.0)
+        {
+            return MAX_int64;
+        }
+        const double Uniform = FMath::Max(static_cast<double>(RandomStream.GetFraction()), UE_DOUBLE_SMALL_NUMBER);
+        return static_cast<int64>(FMath::Min(FMath::Loge(Uniform) / LogKeep, 1e15));
+    }
+
+    float ApplyClampPolicy(float Weight, const FMutationSettings& Settings)
+    {
+        const float Limit = Settings.WeightLimit;
+        switch (Settings.ClampPolicy)
+        {
+        case EWeightClampPolicy::Clamp:
+            return FMath::Clamp(Weight, -Limit, Limit);
+        case EWeightClampPolicy::Reflect:
+            if (FMath::Abs(Weight) > Limit)
+            {
+                Weight = FMath::Sign(Weight) * (2.f * Limit - FMath::Abs(Weight));
+            }
+            // Overshoots of more than twice the limit end up clamped.
+            return FMath::Clamp(Weight, -Limit, Limit);
+        default:
+            return Weight;
+        }
+    }
+}
+
+FSparseMutator::FSparseMutator(float Condition, const FMutationSettings& InSettings, float InStepSize, FRandomStream& InRandomStream)
+    : Settings(InSettings)
+    , StepSize(InStepSize)
+    , RandomStream(InRandomStream)
+    , LogKeep(GetLogKeepProbability(Condition))
+    , Skip(DrawSkip(LogKeep, RandomStream))
+{
+}
+
+void FSparseMutator::Apply(TArrayView<float> Chunk)
+{
+    while (Skip < Chunk.Num())
+    {
+        float& Weight = Chunk[static_cast<int32>(Skip)];
+        const float Mutated = Settings.Operator == EMutationOperator::Gaussian
+            ? Weight + StepSize * SampleGaussian(RandomStream)
+            : RandomStream.FRandRange(-1.f, 1.f);
+        Weight = ApplyClampPolicy(Mutated, Settings);
+        Skip += 1 + DrawSkip(LogKeep, RandomStream);
+    }
+    Skip -= Chunk.Num();
+}
+
+void UNeuralNetwork::Initialize(const TArray<int32>& Layers, bool bInRecurrent)
 {
     if (Layers.Num() == 0)
     {
@@ -10,6 +81,9 @@ void UNeuralNetwork::Initialize(const TArray<int32>& Layers)
     }
 
     LayerSizes = Layers;
+    bRecurrent = bInRecurrent;
+    Genome.Reset();
+    CompiledGenome.Reset();
 
     Neurons.SetNum(LayerSizes.Num());
     for (int32 i = 0; i < LayerSizes.Num(); i++)
@@ -21,10 +95,12 @@ void UNeuralNetwork::Initialize(const TArray<int32>& Layers)
     for (int32 i = 0; i < LayerSizes.Num() - 1; i++)
     {
         Weights[i].SetNum(LayerSizes[i + 1]);
+        // Recurrent layers: the weights of the layer's own previous outputs follow the input weights.
+        const int32 RowSize = LayerSizes[i] + (IsRecurrentLayer(i + 1) ? LayerSizes[i + 1] : 0);
         for (int32 j = 0; j < LayerSizes[i + 1]; j++)
         {
-            Weights[i][j].SetNum(LayerSizes[i]);
-            for (int32 k = 0; k < LayerSizes[i]; k++)
+            Weights[i][j].SetNum(RowSize);
+            for (int32 k = 0; k < RowSize; k++)
             {
                 Weights[i][j][k] = FMath::FRandRange(-1.f, 1.f);
             }
@@ -40,7 +116,24 @@ void UNeuralNetwork::CopyWeights(const UNeuralNetwork* SourceNetwork)
         return;
     }
 
-    if (SourceNetwork->LayerSizes != LayerSizes)
+    MutationStepSize = SourceNetwork->MutationStepSize;
+
+    if (SourceNetwork->Genome)
+    {
+        LayerSizes = SourceNetwork->LayerSizes;
+        bRecurrent = false;
+        Neurons.Empty();
+        Weights.Empty();
+        Genome = SourceNetwork->Genome;
+        CompiledGenome = SourceNetwork->CompiledGenome;
+        return;
+    }
+    if (Genome)
+    {
+        Initialize(SourceNetwork->LayerSizes, SourceNetwork->bRecurrent);
+    }
+
+    if (SourceNetwork->LayerSizes != LayerSizes || SourceNetwork->bRecurrent != bRecurrent)
     {
         UE_LOG(LogTemp, Error, TEXT("SourceNetwork LayerSizes do not match in CopyWeights"));
         return;
@@ -72,6 +165,24 @@ TArray<float> UNeuralNetwork::FeedForward(const TArray<float>& Inputs) const
         return TArray<float>();
     }
 
+    if (CompiledGenome)
+    {
+        TArray<float> Outputs;
+        Outputs.SetNumUninitialized(CompiledGenome->GetNumOutputs());
+        CompiledGenome->Evaluate(Inputs, Outputs);
+        return Outputs;
+    }
+
+    if (bRecurrent)
+    {
+        TArray<float> State;
+        State.SetNumZeroed(GetStateSize());
+        TArray<float> Outputs;
+        Outputs.SetNumUninitialized(LayerSizes.Last());
+        FeedForward(Inputs, State, Outputs);
+        return Outputs;
+    }
+
     // Use a single array for current outputs, starting with the input layer
     TArray<float> CurrentOutputs = Inputs;
 
@@ -100,6 +211,67 @@ TArray<float> UNeuralNetwork::FeedForward(const TArray<float>& Inputs) const
     return CurrentOutputs;
 }
 
+void UNeuralNetwork::FeedForward(TConstArrayView<float> Inputs, TArrayView<float> State, TArrayView<float> Outputs) const
+{
+    check(Inputs.Num() == GetInputSize() && State.Num() == GetStateSize() && Outputs.Num() == LayerSizes.Last());
+
+    if (CompiledGenome)
+    {
+        CompiledGenome->Evaluate(Inputs, Outputs);
+        return;
+    }
+
+    TArray<float, TInlineAllocator<64>> Current(Inputs.GetData(), Inputs.Num());
+    TArray<float, TInlineAllocator<64>> Next;
+    int32 StateOffset = 0;
+    for (int32 LayerIndex = 1; LayerIndex < LayerSizes.Num(); LayerIndex++)
+    {
+        const int32 LayerSize = LayerSizes[LayerIndex];
+        const int32 PreviousSize = LayerSizes[LayerIndex - 1];
+        const bool bRecurrentLayer = IsRecurrentLayer(LayerIndex);
+        const float* PreviousState = bRecurrentLayer ? &State[StateOffset] : nullptr;
+
+        Next.SetNumUninitialized(LayerSize, EAllowShrinking::No);
+        for (int32 Neuron = 0; Neuron < LayerSize; Neuron++)
+        {
+            const float* Row = Weights[LayerIndex - 1][Neuron].GetData();
+            float Sum = 0.f;
+            for (int32 k = 0; k < PreviousSize; k++)
+            {
+                Sum += Row[k] * Current[k];
+            }
+            if (bRecurrentLayer)
+            {
+                for (int32 k = 0; k < LayerSize; k++)
+                {
+                    Sum += Row[PreviousSize + k] * PreviousState[k];
+                }
+            }
+            Next[Neuron] = tanh(Sum);
+        }
+
+        // The whole layer reads the previous state before it is overwritten.
+        if (bRecurrentLayer)
+        {
+            FMemory::Memcpy(&State[StateOffset], Next.GetData(), LayerSize * sizeof(float));
+            StateOffset += LayerSize;
+        }
+        Swap(Current, Next);
+    }
+
+    FMemory::Memcpy(Outputs.GetData(), Current.GetData(), Outputs.Num() * sizeof(float));
+}
+
+int32 UNeuralNetwork::GetStateSize() const
+{
+    int32 Size = 0;
+    for (int32 LayerIndex = 0; LayerIndex < LayerSizes.Num(); LayerIndex++)
+    {
+        Size += IsRecurrentLayer(LayerIndex) ? LayerSizes[LayerIndex] : 0;
+    }
+    return Size;
+}
+
 void UNeuralNetwork::Mutate(float Condition)
 {
     for (int32 i = 0; i < Weights.Num(); i++)
@@ -117,6 +289,166 @@ void UNeuralNetwork::Mutate(float Condition)
     }
 }
 
+void UNeuralNetwork::Mutate(float Condition, FRandomStream& RandomStream)
+{
+    Mutate(Condition, RandomStream, FMutationSettings());
+}
+
+void UNeuralNetwork::Mutate(float Condition, FRandomStream& RandomStream, const FMutationSettings& Settings)
+{
+    if (Settings.Operator == EMutationOperator::Gaussian)
+    {
+        MutationStepSize = AdaptStepSize(MutationStepSize, Settings, RandomStream);
+    }
+
+    // One skip sequence across all rows, as if the weights were flat.
+    FSparseMutator Mutator(Condition, Settings, MutationStepSize, RandomStream);
+    for (TArray<TArray<float>>& Layer : Weights)
+    {
+        for (TArray<float>& Row : Layer)
+        {
+            Mutator.Apply(Row);
+        }
+    }
+}
+
+void UNeuralNetwork::MutateWeights(TArrayView<float> InWeights, float Condition, FRandomStream& RandomStream)
+{
+    MutateWeights(InWeights, Condition, RandomStream, FMutationSettings(), 0.f);
+}
+
+void UNeuralNetwork::MutateWeights(TArrayView<float> InWeights, float Condition, FRandomStream& RandomStream, const FMutationSettings& Settings, float StepSize)
+{
+    FSparseMutator(Condition, Settings, StepSize, RandomStream).Apply(InWeights);
+}
+
+float UNeuralNetwork::AdaptStepSize(float StepSize, const FMutationSettings& Settings, FRandomStream& RandomStream)
+{
+    const float Inherited = StepSize > 0.f ? StepSize : Settings.InitialStepSize;
+    const float Adapted = Settings.SelfAdaptationRate > 0.f ? Inherited * FMath::Exp(Settings.SelfAdaptationRate * SampleGaussian(RandomStream)) : Inherited;
+    return FMath::Clamp(Adapted, Settings.MinStepSize, FMath::Max(Settings.MinStepSize, Settings.MaxStepSize));
+}
+
+int32 UNeuralNetwork::GetNumWeights() const
+{
+    // NEAT networks have no flat weight layout.
+    if (Genome)
+    {
+        return 0;
+    }
+
+    int32 Count = 0;
+    for (int32 i = 0; i < LayerSizes.Num() - 1; i++)
+    {
+        Count += (LayerSizes[i] + (IsRecurrentLayer(i + 1) ? LayerSizes[i + 1] : 0)) * LayerSizes[i + 1];
+    }
+    return Count;
+}
+
+bool UNeuralNetwork::HasTopology(const TArray<int32>& InLayerSizes, bool bInRecurrent) const
+{
+    return !Genome && bRecurrent == bInRecurrent && LayerSizes == InLayerSizes;
+}
+
+int64 UNeuralNetwork::GetAllocatedSize() const
+{
+    int64 Size = LayerSizes.GetAllocatedSize() + Neurons.GetAllocatedSize() + Weights.GetAllocatedSize();
+    for (const TArray<float>& Layer : Neurons)
+    {
+        Size += Layer.GetAllocatedSize();
+    }
+    for (const TArray<TArray<float>>& Layer : Weights)
+    {
+        Size += Layer.GetAllocatedSize();
+        for (const TArray<float>& Row : Layer)
+        {
+            Size += Row.GetAllocatedSize();
+        }
+    }
+    if (Genome)
+    {
+        Size += sizeof(FNeatGenome) + Genome->Nodes.GetAllocatedSize() + Genome->Connections.GetAllocatedSize();
+    }
+    return Size;
+}
+
+void UNeuralNetwork::FlattenWeights(TArray<float>& OutWeights) const
+{
+    OutWeights.Reset(GetNumWeights());
+    for (const TArray<TArray<float>>& Layer : Weights)
+    {
+        for (const TArray<float>& Row : Layer)
+        {
+            OutWeights.Append(Row);
+        }
+    }
+}
+
+void UNeuralNetwork::GetLayerOffsets(TArray<int32>& OutOffsets) const
+{
+    OutOffsets.Reset(Weights.Num() + 1);
+    int32 Offset = 0;
+    for (const TArray<TArray<float>>& Layer : Weights)
+    {
+        OutOffsets.Add(Offset);
+        for (const TArray<float>& Row : Layer)
+        {
+            Offset += Row.Num();
+        }
+    }
+    OutOffsets.Add(Offset);
+}
+
+bool UNeuralNetwork::SetFlatWeights(TConstArrayView<float> FlatWeights)
+{
+    if (FlatWeights.Num() != GetNumWeights())
+    {
+        UE_LOG(LogTemp, Error, TEXT("SetFlatWeights size mismatch. Expected: %d, Got: %d"), GetNumWeights(), FlatWeights.Num());
+        return false;
+    }
+
+    int32 Offset = 0;
+    for (TArray<TArray<float>>& Layer : Weights)
+    {
+        for (TArray<float>& Row : Layer)
+        {
+            FMemory::Memcpy(Row.GetData(), FlatWeights.GetData() + Offset, Row.Num() * sizeof(float));
+            Offset += Row.Num();
+        }
+    }
+    return true;
+}
+
+uint64 UNeuralNetwork::ComputeWeightsHash(uint64 Seed) const
+{
+    uint64 Hash = CityHash64WithSeed(reinterpret_cast<const char*>(LayerSizes.GetData()), LayerSizes.Num() * sizeof(int32), Seed);
+
+    // Chained row by row to avoid flattening the weights into a copy. The result depends on the row boundaries,
+    // so it is not comparable with a hash of FlattenWeights.
+    for (const TArray<TArray<float>>& Layer : Weights)
+    {
+        for (const TArray<float>& Row : Layer)
+        {
+            Hash = CityHash64WithSeed(reinterpret_cast<const char*>(Row.GetData()), Row.Num() * sizeof(float), Hash);
+        }
+    }
+    if (Genome)
+    {
+        Hash = Genome->ComputeHash(Hash);
+    }
+    return Hash;
+}
+
+void UNeuralNetwork::SetGenome(FNeatGenome&& InGenome)
+{
+    LayerSizes = { InGenome.NumInputs, InGenome.NumOutputs };
+    bRecurrent = false;
+    Neurons.Empty();
+    Weights.Empty();
+    Genome = MakeShared<FNeatGenome>(MoveTemp(InGenome));
+    CompiledGenome = MakeShared<FNeatCompiledNetwork>(*Genome);
+}
+
 int32 UNeuralNetwork::GetInputSize() const
 {
     if (LayerSizes.Num() == 0)
@@ -0,0 +1,212 @@
+#include "NoveltyArchive.h"
+#include "Async/ParallelFor.h"
+#include <algorithm>
+
+void FDescriptorKdTree::Build(TConstArrayView<float> InPoints, int32 InDimension)
+{
+    Reset();
+    Dimension = InDimension;
+    if (Dimension <= 0)
+    {
+        return;
+    }
+
+    const int32 NumPoints = InPoints.Num() / Dimension;
+    TArray<int32> Order;
+    Order.SetNumUninitialized(NumPoints);
+    for (int32 i = 0; i < NumPoints; i++)
+    {
+        Order[i] = i;
+    }
+    SplitAxis.SetNumZeroed(NumPoints);
+    BuildRange(0, NumPoints, Order, InPoints);
+
+    Points.SetNumUninitialized(NumPoints * Dimension);
+    for (int32 i = 0; i < NumPoints; i++)
+    {
+        FMemory::Memcpy(&Points[i * Dimension], &InPoints[Order[i] * Dimension], Dimension * sizeof(float));
+    }
+    Indices = MoveTemp(Order);
+}
+
+void FDescriptorKdTree::Reset()
+{
+    Points.Reset();
+    Indices.Reset();
+    SplitAxis.Reset();
+}
+
+void FDescriptorKdTree::BuildRange(int32 Begin, int32 End, TArray<int32>& Order, TConstArrayView<float> InPoints)
+{
+    if (End - Begin <= LeafSize)
+    {
+        return;
+    }
+
+    // Split along the axis with the largest spread in this range.
+    int32 Axis = 0;
+    float BestSpread = -1.f;
+    for (int32 d = 0; d < Dimension; d++)
+    {
+        float Min = TNumericLimits<float>::Max();
+        float Max = TNumericLimits<float>::Lowest();
+        for (int32 i = Begin; i < End; i++)
+        {
+            const float Value = InPoints[Order[i] * Dimension + d];
+            Min = FMath::Min(Min, Value);
+            Max = FMath::Max(Max, Value);
+        }
+        if (Max - Min > BestSpread)
+        {
+            BestSpread = Max - Min;
+            Axis = d;
+        }
+    }
+
+    // Median partition in linear time.
+    const int32 Mid = (Begin + End) / 2;
+    const float* Data = InPoints.GetData();
+    const int32 Stride = Dimension;
+    std::nth_element(Order.GetData() + Begin, Order.GetData() + Mid, Order.GetData() + End,
+        [Data, Stride, Axis](int32 A, int32 B) { return Data[A * Stride + Axis] < Data[B * Stride + Axis]; });
+    SplitAxis[Mid] = static_cast<uint16>(Axis);
+
+    BuildRange(Begin, Mid, Order, InPoints);
+    BuildRange(Mid + 1, End, Order, InPoints);
+}
+
+void FDescriptorKdTree::GatherNearest(const float* Query, int32 K, FNearestNeighbors& Nearest, int32 SkipIndex) const
+{
+    if (Indices.Num() > 0 && K > 0)
+    {
+        SearchRange(0, Indices.Num(), Query, K, Nearest, SkipIndex);
+    }
+}
+
+void FDescriptorKdTree::SearchRange(int32 Begin, int32 End, const float* Query, int32 K, FNearestNeighbors& Nearest, int32 SkipIndex) const
+{
+    if (End - Begin <= LeafSize)
+    {
+        for (int32 i = Begin; i < End; i++)
+        {
+            if (Indices[i] != SkipIndex)
+            {
+                AddCandidate(DistanceSquared(Query, &Points[i * Dimension], Dimension), K, Nearest);
+            }
+        }
+        return;
+    }
+
+    const int32 Mid = (Begin + End) / 2;
+    if (Indices[Mid] != SkipIndex)
+    {
+        AddCandidate(DistanceSquared(Query, &Points[Mid * Dimension], Dimension), K, Nearest);
+    }
+
+    const int32 Axis = SplitAxis[Mid];
+    const float AxisDistance = Query[Axis] - Points[Mid * Dimension + Axis];
+    if (AxisDistance < 0.f)
+    {
+        SearchRange(Begin, Mid, Query, K, Nearest, SkipIndex);
+    }
+    else
+    {
+        SearchRange(Mid + 1, End, Query, K, Nearest, SkipIndex);
+    }
+
+    // The other side can only hold closer points if the splitting plane is closer than the current K-th neighbour.
+    if (Nearest.Num() < K || AxisDistance * AxisDistance < Nearest.HeapTop())
+    {
+        if (AxisDistance < 0.f)
+        {
+            SearchRange(Mid + 1, End, Query, K, Nearest, SkipIndex);
+        }
+        else
+        {
+            SearchRange(Begin, Mid, Query, K, Nearest, SkipIndex);
+        }
+    }
+}
+
+void FDescriptorKdTree::AddCandidate(float CandidateDistanceSquared, int32 K, FNearestNeighbors& Nearest)
+{
+    if (Nearest.Num() < K)
+    {
+        Nearest.HeapPush(CandidateDistanceSquared, TGreater<float>());
+    }
+    else if (CandidateDistanceSquared < Nearest.HeapTop())
+    {
+        Nearest.HeapPopDiscard(TGreater<float>());
+        Nearest.HeapPush(CandidateDistanceSquared, TGreater<float>());
+    }
+}
+
+float FDescriptorKdTree::DistanceSquared(const float* A, const float* B, int32 NumDimensions)
+{
+    float Sum = 0.f;
+    for (int32 d = 0; d < NumDimensions; d++)
+    {
+        const float Delta = A[d] - B[d];
+        Sum += Delta * Delta;
+    }
+    return Sum;
+}
+
+void FNoveltyArchive::Reset(int32 InDimension)
+{
+    Dimension = InDimension;
+    Descriptors.Reset();
+    Index.Reset();
+}
+
+void FNoveltyArchive::Add(TConstArrayView<float> Descriptor)
+{
+    check(Descriptor.Num() == Dimension);
+    Descriptors.Append(Descriptor.GetData(), Descriptor.Num());
+}
+
+void FNoveltyArchive::UpdateIndex()
+{
+    if (Num() - Index.Num() > MaxUnindexed)
+    {
+        Index.Build(Descriptors, Dimension);
+    }
+}
+
+void FNoveltyArchive::ComputeNovelty(TConstArrayView<float> Batch, int32 K, TArray<float>& OutNovelty)
+{
+    const int32 BatchSize = Dimension > 0 ? Batch.Num() / Dimension : 0;
+    OutNovelty.SetNumZeroed(BatchSize);
+    if (BatchSize == 0 || K <= 0)
+    {
+        return;
+    }
+
+    UpdateIndex();
+
+    // The rest of the generation counts as neighbours too, through its own tree.
+    FDescriptorKdTree BatchIndex;
+    BatchIndex.Build(Batch, Dimension);
+
+    const int32 NumIndexed = Index.Num();
+    const int32 NumArchived = Num();
+    ParallelFor(BatchSize, [this, Batch, K, NumIndexed, NumArchived, &BatchIndex, &OutNovelty](int32 QueryIndex)
+        {
+            const float* Query = &Batch[QueryIndex * Dimension];
+
+            FNearestNeighbors Nearest;
+            Index.GatherNearest(Query, K, Nearest);
+            for (int32 i = NumIndexed; i < NumArchived; i++)
+            {
+                FDescriptorKdTree::AddCandidate(FDescriptorKdTree::DistanceSquared(Query, &Descriptors[i * Dimension], Dimension), K, Nearest);
+            }
+            BatchIndex.GatherNearest(Query, K, Nearest, QueryIndex);
+
+            float Sum = 0.f;
+            for (const float NeighborDistanceSquared : Nearest)
+            {
+                Sum += FMath::Sqrt(NeighborDistanceSquared);
+            }
+            OutNovelty[QueryIndex] = Nearest.Num() > 0 ? Sum / Nearest.Num() : 0.f;
+        });
+}
@@ -0,0 +1,265 @@
+#include "ParetoSort.h"
+#include "Algo/Sort.h"
+
+namespace
+{
+    // Lexicographic order, best first: a point can only be dominated by points sorted before it,
+    // and identical points are next to each other.
+    void SortLexicographic(TConstArrayView<float> Objectives, int32 NumObjectives, TArray<int32>& OutOrder)
+    {
+        const int32 Num = Objectives.Num() / NumObjectives;
+        OutOrder.SetNumUninitialized(Num);
+        for (int32 i = 0; i < Num; i++)
+        {
+            OutOrder[i] = i;
+        }
+        const float* Values = Objectives.GetData();
+        Algo::Sort(OutOrder, [Values, NumObjectives](int32 A, int32 B)
+            {
+                const float* PointA = Values + A * NumObjectives;
+                const float* PointB = Values + B * NumObjectives;
+                for (int32 Objective = 0; Objective < NumObjectives; Objective++)
+                {
+                    if (PointA[Objective] != PointB[Objective])
+                    {
+                        return PointA[Objective] > PointB[Objective];
+                    }
+                }
+                return A < B;
+            });
+    }
+
+    bool IsSamePoint(const float* A, const float* B, int32 NumObjectives)
+    {
+        return FMemory::Memcmp(A, B, NumObjectives * sizeof(float)) == 0;
+    }
+
+    // Two objectives: the members of a front are placed with a decreasing first objective, so each one has a
+    // higher second objective than the previous. A point is dominated by a front iff the front's best second
+    // objective is at least its own; the best values decrease front after front, hence the binary search.
+    void ComputeFronts2D(TConstArrayView<float> Objectives, TConstArrayView<int32> Order, TArray<int32>& OutRanks, int32& OutNumFronts)
+    {
+        TArray<float> FrontBest;
+        for (int32 i = 0; i < Order.Num(); i++)
+        {
+            const int32 Point = Order[i];
+            const float* Values = &Objectives[2 * Point];
+            if (i > 0 && IsSamePoint(Values, &Objectives[2 * Order[i - 1]], 2))
+            {
+                OutRanks[Point] = OutRanks[Order[i - 1]];
+                continue;
+            }
+
+            int32 Low = 0;
+            int32 High = FrontBest.Num();
+            while (Low < High)
+            {
+                const int32 Mid = (Low + High) / 2;
+                if (FrontBest[Mid] < Values[1])
+                {
+                    High = Mid;
+                }
+                else
+                {
+                    Low = Mid + 1;
+                }
+            }
+            if (Low == FrontBest.Num())
+            {
+                FrontBest.Add(Values[1]);
+            }
+            else
+            {
+                FrontBest[Low] = Values[1];
+            }
+            OutRanks[Point] = Low;
+        }
+        OutNumFronts = FrontBest.Num();
+    }
+
+    // Efficient non-dominated sort: a point not dominated by front K is not dominated by any later front either
+    // (its dominator would itself be dominated by front K), so the first front that does not dominate it is found
+    // by a binary search.
+    void ComputeFrontsND(TConstArrayView<float> Objectives, int32 NumObjectives, TConstArrayView<int32> Order, TArray<int32>& OutRanks, int32& OutNumFronts)
+    {
+        TArray<TArray<int32>> Fronts;
+        auto IsDominatedByFront = [&Objectives, NumObjectives](const TArray<int32>& Front, const float* Values)
+        {
+            // The latest members are the closest in lexicographic order, hence the most likely dominators.
+            for (int32 i = Front.Num() - 1; i >= 0; i--)
+            {
+                if (FParetoSort::Dominates(&Objectives[Front[i] * NumObjectives], Values, NumObjectives))
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        for (int32 i = 0; i < Order.Num(); i++)
+        {
+            const int32 Point = Order[i];
+            const float* Values = &Objectives[Point * NumObjectives];
+            int32 Front = 0;
+            if (i > 0 && IsSamePoint(Values, &Objectives[Order[i - 1] * NumObjectives], NumObjectives))
+            {
+                Front = OutRanks[Order[i - 1]];
+            }
+            else
+            {
+                int32 High = Fronts.Num();
+                while (Front < High)
+                {
+                    const int32 Mid = (Front + High) / 2;
+                    if (IsDominatedByFront(Fronts[Mid], Values))
+                    {
+                        Front = Mid + 1;
+                    }
+                    else
+                    {
+                        High = Mid;
+                    }
+                }
+            }
+            if (Front == Fronts.Num())
+            {
+                Fronts.AddDefaulted();
+            }
+            Fronts[Front].Add(Point);
+            OutRanks[Point] = Front;
+        }
+        OutNumFronts = Fronts.Num();
+    }
+}
+
+bool FParetoSort::Dominates(const float* A, const float* B, int32 NumObjectives)
+{
+    bool bBetter = false;
+    for (int32 Objective = 0; Objective < NumObjectives; Objective++)
+    {
+        if (A[Objective] < B[Objective])
+        {
+            return false;
+        }
+        bBetter |= A[Objective] > B[Objective];
+    }
+    return bBetter;
+}
+
+void FParetoSort::ComputeFronts(TConstArrayView<float> Objectives, int32 NumObjectives, TArray<int32>& OutRanks, int32& OutNumFronts)
+{
+    OutNumFronts = 0;
+    OutRanks.Reset();
+    if (NumObjectives <= 0 || Objectives.Num() == 0)
+    {
+        return;
+    }
+    check(Objectives.Num() % NumObjectives == 0);
+
+    TArray<int32> Order;
+    SortLexicographic(Objectives, NumObjectives, Order);
+    OutRanks.SetNumUninitialized(Order.Num());
+    if (NumObjectives == 1)
+    {
+        // Every distinct value is its own front.
+        for (int32 i = 0; i < Order.Num(); i++)
+        {
+            OutRanks[Order[i]] = i > 0 && Objectives[Order[i]] == Objectives[Order[i - 1]] ? OutRanks[Order[i - 1]] : OutNumFronts++;
+        }
+    }
+    else if (NumObjectives == 2)
+    {
+        ComputeFronts2D(Objectives, Order, OutRanks, OutNumFronts);
+    }
+    else
+    {
+        ComputeFrontsND(Objectives, NumObjectives, Order, OutRanks, OutNumFronts);
+    }
+}
+
+void FParetoSort::ComputeCrowding(TConstArrayView<float> Objectives, int32 NumObjectives, TConstArrayView<int32> Ranks, TArray<float>& OutCrowding)
+{
+    const int32 Num = Ranks.Num();
+    OutCrowding.Init(0.f, Num);
+    if (NumObjectives <= 0 || Num == 0)
+    {
+        return;
+    }
+    check(Objectives.Num() == Num * NumObjectives);
+
+    // Per objective, the points sorted by front then value are gathered into contiguous arrays, so the gaps of
+    // every front are computed by a single SIMD pass over the population; only the accumulation is scattered.
+    TArray<int32> Order;
+    TArray<float> Sorted;
+    TArray<float> Scale;
+    TArray<float> Gaps;
+    TArray<bool> bExtreme;
+    Order.SetNumUninitialized(Num);
+    Sorted.SetNumUninitialized(Num);
+    Scale.SetNumUninitialized(Num);
+    Gaps.SetNumUninitialized(Num);
+    bExtreme.Init(false, Num);
+
+    for (int32 Objective = 0; Objective < NumObjectives; Objective++)
+    {
+        for (int32 i = 0; i < Num; i++)
+        {
+            Order[i] = i;
+        }
+        Algo::Sort(Order, [&Objectives, &Ranks, NumObjectives, Objective](int32 A, int32 B)
+            {
+                return Ranks[A] != Ranks[B] ? Ranks[A] < Ranks[B] : Objectives[A * NumObjectives + Objective] < Objectives[B * NumObjectives + Objective];
+            });
+        for (int32 i = 0; i < Num; i++)
+        {
+            Sorted[i] = Objectives[Order[i] * NumObjectives + Objective];
+        }
+
+        // Interior points of a front are scaled by its inverse range; its first and last points are extremes.
+        for (int32 Begin = 0; Begin < Num;)
+        {
+            int32 End = Begin + 1;
+            while (End < Num && Ranks[Order[End]] == Ranks[Order[Begin]])
+            {
+                End++;
+            }
+            const float Range = Sorted[End - 1] - Sorted[Begin];
+            const float InvRange = Range > 0.f ? 1.f / Range : 0.f;
+            for (int32 i = Begin; i < End; i++)
+            {
+                Scale[i] = InvRange;
+            }
+            Scale[Begin] = 0.f;
+            Scale[End - 1] = 0.f;
+            bExtreme[Order[Begin]] = true;
+            bExtreme[Order[End - 1]] = true;
+            Begin = End;
+        }
+
+        // Gaps[i] = (Sorted[i + 1] - Sorted[i - 1]) * Scale[i]; the first and last points are always extremes.
+        Gaps[0] = 0.f;
+        Gaps[Num - 1] = 0.f;
+        int32 i = 1;
+        for (; i + 4 < Num; i += 4)
+        {
+            VectorStore(VectorMultiply(VectorSubtract(VectorLoad(&Sorted[i + 1]), VectorLoad(&Sorted[i - 1])), VectorLoad(&Scale[i])), &Gaps[i]);
+        }
+        for (; i < Num - 1; i++)
+        {
+            Gaps[i] = (Sorted[i + 1] - Sorted[i - 1]) * Scale[i];
+        }
+
+        for (int32 Index = 0; Index < Num; Index++)
+        {
+            OutCrowding[Order[Index]] += Gaps[Index];
+        }
+    }
+
+    for (int32 Point = 0; Point < Num; Point++)
+    {
+        if (bExtreme[Point])
+        {
+            OutCrowding[Point] = MAX_flt;
+        }
+    }
+}
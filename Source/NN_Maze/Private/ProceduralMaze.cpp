@@ -0,0 +1,107 @@
+#include "ProceduralMaze.h"
+#include "MazeCollisionComponent.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "UObject/ConstructorHelpers.h"
+
+AProceduralMaze::AProceduralMaze()
+{
+    PrimaryActorTick.bCanEverTick = false;
+
+    BlockSize = 100.f;
+    WallHeight = 200.f;
+
+    SceneRoot = CreateDefaultSubobject<USceneComponent>(TEXT("SceneRoot"));
+    RootComponent = SceneRoot;
+
+    // Rendering only: collision is handled by WallCollision.
+    WallInstances = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("WallInstances"));
+    WallInstances->SetupAttachment(SceneRoot);
+    WallInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+    WallCollision = CreateDefaultSubobject<UMazeCollisionComponent>(TEXT("WallCollision"));
+    WallCollision->SetupAttachment(SceneRoot);
+
+    static ConstructorHelpers::FObjectFinder<UStaticMesh> CubeMesh(TEXT("/Engine/BasicShapes/Cube.Cube"));
+    WallMesh = CubeMesh.Object;
+
+    // Agents treat the maze like the hand-placed walls (wall penalty, environment hash).
+    Tags.Add(TEXT("Wall"));
+}
+
+void AProceduralMaze::OnConstruction(const FTransform& Transform)
+{
+    Super::OnConstruction(Transform);
+    Generate();
+}
+
+void AProceduralMaze::Generate()
+{
+    const double StartTime = FPlatformTime::Seconds();
+    Grid = FMazeGrid::Generate(Settings);
+    FlowField.Reset();
+    const double GeneratedTime = FPlatformTime::Seconds();
+
+    const TArray<FIntRect> Rectangles = Grid.BuildWallRectangles();
+
+    // Map the mesh bounds onto each wall rectangle.
+    const FBox MeshBounds = WallMesh ? WallMesh->GetBoundingBox() : FBox(FVector(-50.f), FVector(50.f));
+    const FVector MeshSize = MeshBounds.GetSize().ComponentMax(FVector(UE_KINDA_SMALL_NUMBER));
+
+    TArray<FBox> Boxes;
+    TArray<FTransform> Instances;
+    Boxes.Reserve(Rectangles.Num());
+    Instances.Reserve(Rectangles.Num());
+    for (const FIntRect& Rectangle : Rectangles)
+    {
+        const FBox Box(FVector(Rectangle.Min.X * BlockSize, Rectangle.Min.Y * BlockSize, 0.f),
+            FVector(Rectangle.Max.X * BlockSize, Rectangle.Max.Y * BlockSize, WallHeight));
+        const FVector Scale = Box.GetSize() / MeshSize;
+        Boxes.Add(Box);
+        Instances.Add(FTransform(FQuat::Identity, Box.GetCenter() - MeshBounds.GetCenter() * Scale, Scale));
+    }
+
+    WallInstances->ClearInstances();
+    WallInstances->SetStaticMesh(WallMesh);
+    WallInstances->AddInstances(Instances, false);
+    WallCollision->SetBoxes(Boxes);
+
+    UE_LOG(LogTemp, Log, TEXT("Procedural maze %dx%d (seed %d): grid %.2f ms, %d wall rectangles, total %.2f ms"),
+        Settings.CellsX, Settings.CellsY, Settings.Seed, (GeneratedTime - StartTime) * 1000.0,
+        Rectangles.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+FVector AProceduralMaze::GetCellLocation(int32 CellX, int32 CellY) const
+{
+    const FIntPoint Block = FMazeGrid::CellToBlock(CellX, CellY);
+    return GetActorTransform().TransformPositionNoScale(FVector((Block.X + 0.5f) * BlockSize, (Block.Y + 0.5f) * BlockSize, 0.f));
+}
+
+float AProceduralMaze::Raycast(const FVector& Start, const FVector& Direction, float MaxDistance) const
+{
+    const FVector LocalDirection = GetActorTransform().InverseTransformVectorNoScale(Direction);
+    const FVector2D PlanarDirection = FVector2D(LocalDirection).GetSafeNormal();
+    if (PlanarDirection.IsZero())
+    {
+        return MaxDistance;
+    }
+    return Grid.Raycast(WorldToMaze(Start) / BlockSize, PlanarDirection, MaxDistance / BlockSize) * BlockSize;
+}
+
+FVector2D AProceduralMaze::WorldToMaze(const FVector& WorldLocation) const
+{
+    return FVector2D(GetActorTransform().InverseTransformPositionNoScale(WorldLocation));
+}
+
+const FMazeFlowField& AProceduralMaze::GetFlowField(const FVector& ExitWorldLocation)
+{
+    check(IsInGameThread());
+
+    const FVector2D ExitGrid = WorldToGrid(ExitWorldLocation);
+    const FIntPoint ExitBlock(FMath::FloorToInt32(ExitGrid.X), FMath::FloorToInt32(ExitGrid.Y));
+    if (!FlowField.IsBuilt() || FlowField.GetExitBlock() != ExitBlock)
+    {
+        FlowField.Build(Grid, ExitBlock);
+    }
+    return FlowField;
+}
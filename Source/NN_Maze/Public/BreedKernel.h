@@ -0,0 +1,38 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NeuralNetwork.h"
+
+// Crossover operator and mutation of a breeding pass.
+struct FBreedSettings
+{
+    ECrossoverOperator Crossover = ECrossoverOperator::Uniform;
+
+    // Uniform and layer-wise crossover: probability to take a weight (a layer) from the first parent.
+    float ProbabilityA = 0.5f;
+
+    // Layer-wise crossover: start of every layer in the flat layout, then the total (see UNeuralNetwork::GetLayerOffsets).
+    TConstArrayView<int32> LayerOffsets;
+
+    // Percentage of mutated weights, as in UNeuralNetwork::Mutate.
+    float MutationRate = 0.f;
+    FMutationSettings Mutation;
+};
+
+/**
+ * Fused breeding of flat weight buffers: crossover of two parents then sparse mutation of the child, chunk by
+ * chunk in a single pass, so every weight is written once while it is in cache.
+ *
+ * Uniform crossover draws the parent choices as 64-bit masks (biased to ProbabilityA with a 1/256 resolution)
+ * and blends four weights per SIMD select instead of drawing and branching per weight.
+ */
+class NN_MAZE_API FBreedKernel
+{
+public:
+    // The parents and the child share one layout. StepSize is the Gaussian mutation standard deviation.
+    static void Breed(TConstArrayView<float> ParentA, TConstArrayView<float> ParentB, TArrayView<float> Child,
+        const FBreedSettings& Settings, float StepSize, FRandomStream& RandomStream);
+
+    // Weights per crossover mask and per mutation chunk.
+    static constexpr int32 ChunkSize = 64;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+class UNeuralNetwork;
+
+/**
+ * Latest champion weights, published by the training and picked up by live agents without locks.
+ *
+ * Publication N is written to buffer N % 2, i.e. the one readers are not directed to, then made visible by a
+ * release store of N. Each buffer also carries a sequence number, odd while it is being written: a reader
+ * checks it before and after copying, so a copy overlapping a write (the writer published twice during the
+ * copy) is detected and dropped instead of being used torn. The reader keeps its current weights and tries
+ * again at its next tick, so neither side ever waits.
+ *
+ * The weight layout is fixed at construction and the buffers never reallocate (fixed topologies only).
+ */
+class NN_MAZE_API FChampionSnapshot
+{
+public:
+    FChampionSnapshot(const TArray<int32>& InLayerSizes, bool bInRecurrent);
+
+    /**
+     * Copies the weights of Network into the back buffer and publishes them. One writer at a time.
+     *
+     * @return False if the network does not have the snapshot's layout.
+     */
+    bool Publish(const UNeuralNetwork& Network, float Fitness, int32 Generation);
+
+    /**
+     * Copies the latest publication into OutWeights if it is newer than InOutVersion, and updates InOutVersion.
+     * Any thread, no lock. Returns false when there is nothing new or when the copy was overwritten meanwhile.
+     */
+    bool TryRead(uint32& InOutVersion, TArray<float>& OutWeights, float* OutFitness = nullptr, int32* OutGeneration = nullptr) const;
+
+    // Latest publication (0 = none yet).
+    uint32 GetVersion() const { return PublishedVersion.load(std::memory_order_acquire); }
+
+    const TArray<int32>& GetLayerSizes() const { return LayerSizes; }
+    bool IsRecurrent() const { return bRecurrent; }
+
+private:
+    struct FBuffer
+    {
+        std::atomic<uint32> Sequence{ 0 };
+        TArray<float> Weights;
+        float Fitness = 0.f;
+        int32 Generation = 0;
+    };
+
+    const TArray<int32> LayerSizes;
+    const bool bRecurrent;
+    FBuffer Buffers[2];
+    std::atomic<uint32> PublishedVersion{ 0 };
+};
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+
+class FSocket;
+class FRunnableThread;
+class UNeuralNetwork;
+
+/**
+ * Coordinator/worker protocol used to spread genome evaluation over several processes.
+ *
+ * The coordinator ships batches of serialized genomes over TCP to headless worker processes, which
+ * simulate them in their own world and send back one fitness value per genome. Workers pull work:
+ * an idle worker is given the next queued batch, and once the queue is empty idle workers duplicate
+ * batches that are taking too long (work stealing for stragglers, the first result wins). Batches of
+ * workers that disconnect or exceed the timeout are queued again, up to a retry limit.
+ *
+ * Every message is a frame: uint32 size, uint8 message type, then the FArchive-serialized body
+ * (native little-endian byte order).
+ *
+ * Local test on one Linux box (coordinator plus four worker processes):
+ *   UnrealEditor NN_Maze.uproject /Game/Level/LVL_Maze -game -nullrhi -MazeCoordinator=7878 -MazeLocalWorkers=4
+ * Workers can also be started by hand, on this or another machine:
+ *   UnrealEditor NN_Maze.uproject /Game/Level/LVL_Maze -game -nullrhi -MazeWorker=192.168.1.10:7878
+ */
+
+enum class EEvaluationMessage : uint8
+{
+    // Worker -> coordinator: worker is connected and ready for work.
+    Hello,
+    // Coordinator -> worker: genomes to evaluate.
+    Batch,
+    // Worker -> coordinator: fitness of every genome of a batch.
+    Result,
+    // Coordinator -> worker: training is over, the worker process should exit.
+    Shutdown
+};
+
+struct FGenomePayload
+{
+    // Position of the genome in the submitted generation.
+    int32 Slot = INDEX_NONE;
+    TArray<int32> LayerSizes;
+    bool bRecurrent = false;
+    TArray<float> Weights;
+
+    friend FArchive& operator<<(FArchive& Ar, FGenomePayload& Payload)
+    {
+        return Ar << Payload.Slot << Payload.LayerSizes << Payload.bRecurrent << Payload.Weights;
+    }
+};
+
+struct FGenomeBatch
+{
+    int32 BatchId = INDEX_NONE;
+    int32 GenerationId = INDEX_NONE;
+    TArray<FGenomePayload> Genomes;
+
+    friend FArchive& operator<<(FArchive& Ar, FGenomeBatch& Batch)
+    {
+        return Ar << Batch.BatchId << Batch.GenerationId << Batch.Genomes;
+    }
+};
+
+struct FBatchResult
+{
+    int32 BatchId = INDEX_NONE;
+    int32 GenerationId = INDEX_NONE;
+    TArray<int32> Slots;
+    TArray<float> Fitness;
+
+    friend FArchive& operator<<(FArchive& Ar, FBatchResult& Result)
+    {
+        return Ar << Result.BatchId << Result.GenerationId << Result.Slots << Result.Fitness;
+    }
+};
+
+/**
+ * Framed message stream over a connected TCP socket. Receives never block.
+ * Send writes the whole frame at once and blocks on a blocking socket. QueueSend only appends the frame to an
+ * outgoing buffer, which FlushSends writes as far as a non-blocking socket accepts.
+ */
+class NN_MAZE_API FEvaluationConnection
+{
+public:
+    explicit FEvaluationConnection(FSocket* InSocket);
+    ~FEvaluationConnection();
+
+    bool Send(EEvaluationMessage Type, const TArray<uint8>& Body);
+
+    void QueueSend(EEvaluationMessage Type, const TArray<uint8>& Body);
+
+    // Writes queued frames until the socket would block. Returns false once the connection is lost.
+    bool FlushSends();
+
+    bool HasPendingSends() const { return SendOffset < SendBuffer.Num(); }
+
+    // Extracts the next complete message if one is available. Returns false otherwise.
+    bool Receive(EEvaluationMessage& OutType, TArray<uint8>& OutBody);
+
+    bool IsConnected() const { return bConnected; }
+
+private:
+    void ReadAvailableData();
+
+    FSocket* Socket;
+    TArray<uint8> ReceiveBuffer;
+    TArray<uint8> SendBuffer;
+    int32 SendOffset;
+    bool bConnected;
+};
+
+/**
+ * Coordinator side: accepts worker connections and schedules genome batches on them.
+ * Socket work happens on a dedicated thread; the game thread only submits generations and polls results.
+ */
+class NN_MAZE_API FEvaluationCoordinator : public FRunnable
+{
+public:
+    FEvaluationCoordinator();
+    virtual ~FEvaluationCoordinator();
+
+    // Opens the listen socket and starts the coordinator thread.
+    bool Start(int32 Port);
+
+    // Tells the workers to exit, then closes every connection and stops the thread.
+    void Shutdown();
+
+    /**
+     * Serializes the genomes into batches and queues them, replacing any unfinished generation.
+     *
+     * @param GenerationId Identifier echoed back by the workers; results of older generations are ignored.
+     * @param Genomes      Networks to evaluate. Result slots follow this order.
+     * @param BatchSize    Number of genomes sent to a worker at once.
+     */
+    void SubmitGeneration(int32 GenerationId, const TArray<UNeuralNetwork*>& Genomes, int32 BatchSize);
+
+    // Returns true once every genome of the generation has a fitness value, indexed like the submitted genomes.
+    bool TryGetResults(int32 GenerationId, TArray<float>& OutFitness);
+
+    int32 GetNumWorkers() const;
+
+    // A worker holding a batch longer than this is considered dead and its batch is queued again.
+    float BatchTimeoutSeconds;
+
+    // Idle workers duplicate batches that have been running longer than this.
+    float StragglerSeconds;
+
+    // Number of times a batch is queued again before its genomes get the worst fitness of the generation.
+    int32 MaxBatchRetries;
+
+    // Maximum number of extra copies of a straggling batch.
+    int32 MaxSpeculativeCopies;
+
+    // FRunnable interface
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    struct FScheduledBatch
+    {
+        int32 BatchId = INDEX_NONE;
+        TArray<int32> Slots;
+        TArray<uint8> Body;
+        int32 Attempts = 0;
+        int32 ActiveAssignments = 0;
+        double FirstDispatchTime = 0.0;
+        bool bQueued = false;
+        bool bDone = false;
+    };
+
+    struct FWorkerState
+    {
+        TUniquePtr<FEvaluationConnection> Connection;
+        int32 AssignedBatchId = INDEX_NONE;
+        double AssignedTime = 0.0;
+        bool bReady = false;
+        int32 CompletedBatches = 0;
+    };
+
+    void AcceptConnections();
+    void ReceiveMessages();
+    void CheckTimeouts(double Now);
+    void DispatchWork(double Now);
+    void HandleResult(FWorkerState& Worker, const FBatchResult& Result);
+    void ReleaseAssignment(FWorkerState& Worker, bool bFailed);
+    void CompleteBatch(FScheduledBatch& Batch, const TArray<int32>& Slots, const TArray<float>& Fitness);
+    FScheduledBatch* FindBatch(int32 BatchId);
+    bool AssignBatch(FWorkerState& Worker, FScheduledBatch& Batch, double Now);
+
+    FSocket* ListenSocket;
+    FRunnableThread* Thread;
+    FThreadSafeBool bStopping;
+
+    // Guards every member below; shared between the game thread and the coordinator thread. Only the coordinator
+    // thread adds or removes workers and touches their connections, so it writes to the sockets outside the lock.
+    mutable FCriticalSection Mutex;
+    TArray<FWorkerState> Workers;
+    TArray<FScheduledBatch> Batches;
+    TArray<int32> BatchQueue;
+    int32 CurrentGenerationId;
+    int32 NextBatchId;
+    TArray<float> GenerationFitness;
+    TArray<bool> GenerationHasFitness;
+    TArray<int32> FailedSlots;
+    int32 RemainingGenomes;
+};
+
+/**
+ * Worker side: connects to a coordinator and exchanges batches and results from the game thread.
+ */
+class NN_MAZE_API FEvaluationWorkerClient
+{
+public:
+    // Connects to "ip:port" and announces the worker.
+    bool Connect(const FString& CoordinatorAddress);
+
+    // Returns true when a new batch was received.
+    bool PollBatch(FGenomeBatch& OutBatch);
+
+    bool SendResult(FBatchResult& Result);
+
+    // True once the coordinator asked the worker to exit or the connection was lost.
+    bool ShouldExit() const { return bShutdownRequested || !Connection.IsValid() || !Connection->IsConnected(); }
+
+private:
+    TUniquePtr<FEvaluationConnection> Connection;
+    bool bShutdownRequested = false;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "EvolutionBenchmarkCommandlet.generated.h"
+
+/**
+ * Measures evolution throughput (generations per second) against the number of islands.
+ * Fitness is a synthetic objective (distance of the weights to a fixed random target), so the
+ * benchmark isolates the selection/crossover/mutation cost from the maze simulation.
+ *
+ * Usage: UnrealEditor-Cmd NN_Maze.uproject -run=EvolutionBenchmark [-Population=2000] [-Generations=50]
+ *        [-Layers=8,16,16,8,2] [-MaxIslands=<cores>] [-MigrationInterval=5] [-Seed=1234]
+ *
+ * With -TimeToExit, compares the genetic algorithm with the evolution strategy on a headless maze instead:
+ * generations and wall time until an agent reaches the exit. -Generations is then the upper bound.
+ *        [-MazeCells=4] [-TimeLimit=20] [-AgentClass=/Game/Blueprints/BP_MazeAgent.BP_MazeAgent_C]
+ *
+ * With -BreedKernel, times the breeding of flat children on all cores instead: the fused FBreedKernel pass of
+ * every crossover operator against the former scalar path (one draw per weight, then a separate mutation pass).
+ *        [-Children=100000] [-Weights=500] [-MutationRate=5] [-Gaussian]
+ *
+ * With -Pareto, times the NSGA-II selection (non-dominated sort and crowding distance) of random objective
+ * vectors, for 2 to -MaxObjectives objectives. Correlated objectives give many fronts, like a trained population.
+ *        [-Points=50000] [-MaxObjectives=4]
+ *
+ * With -Soak, runs the genetic algorithm for many generations with periodic garbage collections and fails
+ * (exit code 1) if the population memory, the UObject count or the physical memory grows after the warmup,
+ * if networks are still created, or if a collection frees objects made by the training.
+ *        [-Generations=10000] [-Population=500] [-GCInterval=100] [-MemoryToleranceMB=32]
+ */
+UCLASS()
+class NN_MAZE_API UEvolutionBenchmarkCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UEvolutionBenchmarkCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+
+private:
+    int32 RunSoak(const FString& Params, const TArray<int32>& Layers, int32 Seed);
+
+    // Evolution manager and both generations of the soak run, kept alive across its garbage collections.
+    UPROPERTY()
+    TArray<UObject*> SoakObjects;
+};
@@ -3,8 +3,91 @@
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
 #include "NeuralNetwork.h"
+#include "FitnessCache.h"
+#include "NoveltyArchive.h"
+#include "Containers/Queue.h"
+#include <atomic>
 #include "EvolutionManager.generated.h"
 
+// How migrants travel between islands.
+UENUM(BlueprintType)
+enum class EMigrationTopology : uint8
+{
+    // Island i sends its best individuals to island i + 1.
+    Ring,
+    // Each migrant goes to a randomly chosen other island.
+    Random
+};
+
+// Per-island statistics of the last processed generation.
+USTRUCT(BlueprintType)
+struct FIslandStats
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Evolution")
+    int32 IslandIndex = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Evolution")
+    int32 Size = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Evolution")
+    float BestFitness = 0.f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Evolution")
+    float MeanFitness = 0.f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Evolution")
+    float WorstFitness = 0.f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Evolution")
+    int32 MigrantsReceived = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Evolution")
+    float BreedTimeMs = 0.f;
+};
+
+// Individual travelling between islands. Plain data so it can cross threads without touching UObjects.
+struct FMigrant
+{
+    TArray<float> Weights;
+    float Fitness = 0.f;
+    float SelectionScore = 0.f;
+    float MutationStepSize = 0.f;
+};
+
+// Sub-population state that persists across generations.
+struct FEvolutionIsland
+{
+    // Each island draws from its own stream so islands can breed concurrently.
+    FRandomStream RandomStream;
+
+    // Lock-free hand-off queue: any island may push, only the owning island pops.
+    TQueue<FMigrant, EQueueMode::Mpsc> Inbox;
+
+    FIslandStats Stats;
+};
+
+// Genome evaluated outside of a generation barrier (steady-state and pipelined modes), kept as plain data so it can be bred off the game thread.
+struct FEvaluatedGenome
+{
+    TArray<float> Weights;
+    float Fitness = 0.f;
+    float MutationStepSize = 0.f;
+};
+
+struct FBreedSettings;
+
+// Children bred on a background task. Shared with the task so it stays valid even if the manager goes away first.
+struct FBreedingPipeline
+{
+    // Single producer (the one breeding task in flight), single consumer (the game thread).
+    // Children are not evaluated yet: only their weights and step size are set.
+    TQueue<FEvaluatedGenome, EQueueMode::Spsc> ReadyChildren;
+    std::atomic<int32> NumReadyChildren{ 0 };
+    std::atomic<bool> bBreeding{ false };
+};
+
 /**
  * Helper class that encapsulates the evolution algorithm.
  * It processes a generation of neural networks and produces a mutated next generation.
@@ -21,16 +104,33 @@ public:
      * Process the evolution generation.
      *
      * @param CurrentGeneration The array of neural networks with updated fitness values.
-     * @param NextGeneration    Output array that will be filled with the new generation.
+     * @param NextGeneration    Output array that will be filled with the new generation. Networks it already holds
+     *                          are bred into, so pass the previous CurrentGeneration (swap the arrays after the
+     *                          call) or an empty array, never a copy of CurrentGeneration.
      * @param OutGenerationFitnessMean  Returns the average fitness computed for the generation.
      * @param PopulationSize    The expected size of the population.
      */
     UFUNCTION(BlueprintCallable, Category = "Evolution")
-    void ProcessGeneration(TArray<UNeuralNetwork*>& CurrentGeneration,
+    virtual void ProcessGeneration(TArray<UNeuralNetwork*>& CurrentGeneration,
         TArray<UNeuralNetwork*>& NextGeneration,
         float& OutGenerationFitnessMean,
         int32 PopulationSize);
 
+    /**
+     * Sets up a network of the initial population.
+     *
+     * @param Network      Freshly created network.
+     * @param LayerConfig  Layer sizes from the maze manager (input count first, output count last).
+     * @param bRecurrent   Elman recurrence in the hidden layers (fixed topologies only).
+     */
+    virtual void InitializeNetwork(UNeuralNetwork* Network, const TArray<int32>& LayerConfig, bool bRecurrent);
+
+    // Steady-state, pipelined and distributed evaluation exchange genomes as flat weight arrays of a fixed layout.
+    virtual bool UsesFixedTopology() const { return true; }
+
+    // Steady-state and pipelined modes breed one child at a time from the evaluated pool.
+    virtual bool SupportsIncrementalBreeding() const { return UsesFixedTopology(); }
+
     // --- New evolutionary parameters ---
 
     // The fraction of the population that is kept unchanged (elitism).
@@ -41,11 +141,235 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution")
     float BaseMutationRate;
 
-    // The probability to choose a gene from parent1 during crossover (uniform crossover).
+    // The probability to choose a gene from parent1 during crossover (uniform and layer-wise crossover).
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution")
     float CrossoverProbability;
 
+    // How the weights of the two parents are combined (see FBreedKernel).
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution")
+    ECrossoverOperator CrossoverOperator;
+
+    // Mutation operator, step size self-adaptation and weight bounds. The rate stays BaseMutationRate.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Mutation")
+    FMutationSettings Mutation;
+
     // A target fitness difference between the best and average fitness used for dynamic mutation.
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution")
     float TargetFitnessDifference;
+
+    // --- Island model ---
+
+    // Number of independent sub-populations bred concurrently on worker threads (1 = single panmictic population).
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Islands", meta = (ClampMin = "1"))
+    int32 NumIslands;
+
+    // Migration happens every MigrationInterval generations (0 disables migration).
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Islands", meta = (ClampMin = "0"))
+    int32 MigrationInterval;
+
+    // Number of top individuals each island sends when migrating.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Islands", meta = (ClampMin = "0"))
+    int32 MigrantsPerIsland;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Islands")
+    EMigrationTopology MigrationTopology;
+
+    // Statistics of every island for the last processed generation.
+    UFUNCTION(BlueprintCallable, Category = "Evolution|Islands")
+    TArray<FIslandStats> GetIslandStats() const;
+
+    // --- Steady-state and pipelined evolution ---
+
+    // Number of genomes competing in each tournament when selecting steady-state parents.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Steady State", meta = (ClampMin = "1"))
+    int32 TournamentSize;
+
+    /**
+     * Adds a genome whose evaluation just finished to the pool of evaluated genomes.
+     * The pool is a min-heap on fitness holding the MaxPoolSize best genomes: insert and worst-eviction are O(log N).
+     */
+    void AddEvaluatedGenome(const UNeuralNetwork* Network, int32 MaxPoolSize);
+
+    int32 GetEvaluatedPoolSize() const { return EvaluatedPool.Num(); }
+
+    // Best and average fitness of the evaluated pool.
+    void GetEvaluatedPoolStats(float& OutBestFitness, float& OutMeanFitness) const;
+
+    /**
+     * Steady-state replacement: breeds one child from two tournament-selected parents of the pool
+     * and writes it into Child, synchronously.
+     *
+     * @return False if the pool has fewer than two genomes.
+     */
+    bool BreedSteadyStateChild(UNeuralNetwork* Child);
+
+    /**
+     * Starts breeding Count children from a snapshot of the evaluated pool on a background task.
+     * Does nothing if a breeding task is already running or the pool has fewer than two genomes.
+     */
+    void RequestChildren(int32 Count);
+
+    // Writes the next ready child into Network. Returns false when no child is ready yet.
+    bool TryPopChild(UNeuralNetwork* Network);
+
+    int32 GetNumReadyChildren() const { return Pipeline->NumReadyChildren.load(); }
+    bool IsBreeding() const { return Pipeline->bBreeding.load(); }
+
+    // --- Fitness cache ---
+
+    // Reuse the fitness of genomes that were already evaluated in the same environment.
+    // Only valid when the maze, start position and simulation are deterministic.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Cache")
+    bool bUseFitnessCache;
+
+    // Maximum number of cached evaluations (least recently used entries are evicted first).
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Cache")
+    int32 FitnessCacheCapacity;
+
+    /**
+     * Sets the hash describing the evaluation environment (maze, start position, reward parameters...).
+     * The cache is invalidated whenever the hash differs from the previous one.
+     */
+    void SetEnvironmentHash(uint64 NewEnvironmentHash);
+
+    // Drops every cached evaluation. Call this when the maze or the agent reward parameters change.
+    UFUNCTION(BlueprintCallable, Category = "Evolution|Cache")
+    void InvalidateFitnessCache();
+
+    /**
+     * Looks up the network in the fitness cache.
+     *
+     * @param Network The network about to be evaluated.
+     * @return True if a cached fitness was found and written to Network->Fitness.
+     */
+    bool ApplyCachedFitness(UNeuralNetwork* Network);
+
+    // Stores the fitness of every evaluated network of a generation.
+    void RecordFitness(const TArray<UNeuralNetwork*>& Generation);
+
+    const FFitnessCache& GetFitnessCache() const { return FitnessCache; }
+
+    // --- Novelty search ---
+
+    // Select on the novelty of the behaviours (blended with fitness) so the population keeps exploring the maze.
+    // Generational mode only; the fitness cache is disabled since the score depends on the archive.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Novelty")
+    bool bUseNoveltySearch;
+
+    // Behaviour descriptor: agent position at this many evenly spaced times of the episode (1 = final position only).
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Novelty", meta = (ClampMin = "1"))
+    int32 BehaviorDescriptorPoints;
+
+    // Number of nearest neighbours whose mean distance is the novelty of a behaviour.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Novelty", meta = (ClampMin = "1"))
+    int32 NoveltyNeighbors;
+
+    // Selection score = (1 - NoveltyWeight) * fitness + NoveltyWeight * novelty (novelty is in world units).
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Novelty", meta = (ClampMin = "0", ClampMax = "1"))
+    float NoveltyWeight;
+
+    // Probability that an evaluated behaviour is added to the archive.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Novelty", meta = (ClampMin = "0", ClampMax = "1"))
+    float NoveltyArchiveProbability;
+
+    /**
+     * Sets the selection score of every network from its fitness and novelty, then archives a random sample of the behaviours.
+     *
+     * @param Population      Evaluated networks.
+     * @param Descriptors     Behaviour descriptor of Population[i] at [i * DescriptorSize, (i + 1) * DescriptorSize).
+     * @param DescriptorSize  Number of floats per descriptor. The archive is reset when it changes.
+     */
+    void ApplyNovelty(TConstArrayView<UNeuralNetwork*> Population, TConstArrayView<float> Descriptors, int32 DescriptorSize);
+
+    const FNoveltyArchive& GetNoveltyArchive() const { return NoveltyArchive; }
+
+    // --- Multi-objective selection ---
+
+    // Select with NSGA-II on an objective vector instead of the scalar fitness (see AMazeManager::SelectionObjectives).
+    // Generational mode only. The selection score is minus the Pareto front, plus up to 0.5 for the crowding
+    // distance; the raw fitness still drives the dynamic mutation and the statistics.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|MultiObjective")
+    bool bUseMultiObjective;
+
+    /**
+     * Sets the selection score of every network to its NSGA-II score: the truncation selection of
+     * ProcessGeneration then keeps the best fronts and, within a front, the least crowded networks.
+     *
+     * @param Population     Evaluated networks.
+     * @param Objectives     Objective vector of Population[i] at [i * NumObjectives, (i + 1) * NumObjectives), all maximized.
+     * @param NumObjectives  Number of objectives.
+     */
+    void ApplyMultiObjective(TConstArrayView<UNeuralNetwork*> Population, TConstArrayView<float> Objectives, int32 NumObjectives);
+
+    // --- Generation memory ---
+
+    // Networks created by the last ProcessGeneration. Slots of NextGeneration are reused, so once the caller swaps
+    // the two generation arrays instead of copying them, this stays at 0 for a constant population size.
+    int32 GetNetworksCreated() const { return NetworksCreated; }
+
+    // Heap bytes held by the networks of a generation, excluding the UObjects themselves.
+    static int64 GetGenerationAllocatedSize(TConstArrayView<UNeuralNetwork*> Generation);
+
+protected:
+    /**
+     * Resizes NextGeneration to Population, keeping the networks it already holds so they are bred into rather
+     * than replaced. Slots holding a network of CurrentGeneration, or the same network as an earlier slot, are
+     * cleared. Must run on the game thread, before ReuseNetworkSlot fills the empty slots.
+     */
+    void PrepareGenerationSlots(const TArray<UNeuralNetwork*>& CurrentGeneration, TArray<UNeuralNetwork*>& NextGeneration, int32 Population);
+
+    /**
+     * Returns Slot, or a new network if it is null. The network is re-initialized only if its topology differs
+     * from InLayerSizes (left as is when InLayerSizes is empty): reused weights are overwritten by the breeding.
+     */
+    UNeuralNetwork* ReuseNetworkSlot(UNeuralNetwork* Slot, const TArray<int32>& InLayerSizes, bool bInRecurrent);
+
+    // Sets the selection score of every network to its fitness, unless ApplyNovelty or ApplyMultiObjective scored
+    // this generation. Called once per ProcessGeneration, before anything sorts on the score.
+    void PrepareSelectionScores(const TArray<UNeuralNetwork*>& Generation);
+
+    int32 NetworksCreated;
+
+private:
+    // Mutation rate scaled up when the best fitness gets close to the average (low diversity).
+    float GetDynamicMutationRate(float BestFitness, float MeanFitness) const;
+
+    // (Re)creates the island states when the island count changes.
+    void EnsureIslands(int32 IslandCount);
+
+    // Sorts an island's slice of the population and sends its best individuals to other islands.
+    void EmitMigrants(int32 IslandIndex, TArrayView<UNeuralNetwork*> IslandPopulation, bool bMigrate);
+
+    // Replaces the worst individuals with received migrants, then breeds the island's slice of the next generation.
+    void BreedIsland(int32 IslandIndex, TArrayView<UNeuralNetwork*> IslandPopulation, TArrayView<UNeuralNetwork*> IslandChildren);
+
+    // Crossover and mutation settings of a breeding pass (LayerOffsets left empty).
+    FBreedSettings MakeBreedSettings(float MutationRate) const;
+
+    TArray<TUniquePtr<FEvolutionIsland>> Islands;
+    int32 GenerationIndex;
+
+    // Steady-state/pipelined modes: heap of evaluated genomes (worst on top) and the background breeding state.
+    TArray<FEvaluatedGenome> EvaluatedPool;
+    TSharedPtr<FBreedingPipeline, ESPMode::ThreadSafe> Pipeline;
+
+    // Layer offsets of the pool's flat layout, for layer-wise crossover.
+    TArray<int32> PoolLayerOffsets;
+
+    // Initial mutation of the networks created by InitializeNetwork.
+    FRandomStream InitializationStream;
+
+    FRandomStream SteadyStateStream;
+    TArray<float> SteadyStateScratch;
+    int32 SteadyStateBirths;
+    float SteadyStateMutationRate;
+
+    FFitnessCache FitnessCache;
+    uint64 EnvironmentHash;
+
+    FNoveltyArchive NoveltyArchive;
+    FRandomStream NoveltyStream;
+
+    // Set by ApplyNovelty / ApplyMultiObjective until the next ProcessGeneration consumes the scores.
+    bool bSelectionScoresApplied = false;
 };
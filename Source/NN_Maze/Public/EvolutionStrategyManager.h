@@ -0,0 +1,71 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EvolutionManager.h"
+#include "EvolutionStrategyManager.generated.h"
+
+/**
+ * OpenAI-style evolution strategy: every network of a generation is the same parameter vector (the center)
+ * plus a Gaussian perturbation, sampled in mirrored pairs (+e, -e). After the evaluation the center moves
+ * along the sum of the perturbations weighted by the centered rank of their fitness.
+ *
+ * Perturbations are never stored: each one is regenerated from a 32-bit seed, block by block, so a generation
+ * is fully described by its seeds and fitness values and the update runs in parallel over parameter blocks.
+ *
+ * Select it with EvolutionManagerClass on the maze manager. Generational mode only.
+ */
+UCLASS(Blueprintable)
+class NN_MAZE_API UEvolutionStrategyManager : public UEvolutionManager
+{
+    GENERATED_BODY()
+
+public:
+    UEvolutionStrategyManager();
+
+    virtual void ProcessGeneration(TArray<UNeuralNetwork*>& CurrentGeneration,
+        TArray<UNeuralNetwork*>& NextGeneration,
+        float& OutGenerationFitnessMean,
+        int32 PopulationSize) override;
+
+    virtual void InitializeNetwork(UNeuralNetwork* Network, const TArray<int32>& LayerConfig, bool bRecurrent) override;
+
+    virtual bool SupportsIncrementalBreeding() const override { return false; }
+
+    // Standard deviation of the perturbations
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Strategy", meta = (ClampMin = "0.0001"))
+    float NoiseStdDev;
+
+    // Step size of the center update
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Strategy", meta = (ClampMin = "0"))
+    float LearningRate;
+
+    // L2 pull of the center towards zero, per update
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|Strategy", meta = (ClampMin = "0"))
+    float WeightDecay;
+
+    // Current parameter vector, in the flat weight layout of UNeuralNetwork.
+    const TArray<float>& GetCenterWeights() const { return Center; }
+
+    // Perturbation of the given seed and parameter block (NoiseBlockSize values, fewer for the last block).
+    static void GenerateNoise(int32 Seed, int32 Block, TArrayView<float> OutNoise);
+
+    static constexpr int32 NoiseBlockSize = 256;
+
+private:
+    // Fills Network with the center plus Sign times the perturbation of Seed.
+    void SampleNetwork(UNeuralNetwork* Network, int32 Seed, float Sign) const;
+
+    // Adopts the weights of Network as the center, e.g. when the population did not come from this manager.
+    void ResetCenter(const UNeuralNetwork* Network);
+
+    TArray<float> Center;
+    TArray<int32> LayerSizes;
+    bool bRecurrentLayers;
+
+    // Seed and sign of the perturbation of each network of the generation being evaluated.
+    TArray<int32> SampleSeeds;
+    TArray<float> SampleSigns;
+
+    FRandomStream RandomStream;
+    int32 StrategyGeneration;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/LruCache.h"
+
+class UNeuralNetwork;
+
+/**
+ * LRU-bounded cache of already evaluated fitness values.
+ * Entries are keyed by a hash of the network weights combined with a hash of the environment
+ * configuration, so a genome is only reused when both the network and the maze setup are unchanged.
+ * Only meaningful when the simulation is deterministic.
+ */
+class NN_MAZE_API FFitnessCache
+{
+public:
+    explicit FFitnessCache(int32 InCapacity = 4096);
+
+    // Builds the cache key of a network evaluated in the given environment.
+    static uint64 MakeKey(const UNeuralNetwork* Network, uint64 EnvironmentHash);
+
+    // Looks up a fitness value and marks the entry as most recently used. Updates the hit/miss counters.
+    bool Find(uint64 Key, float& OutFitness);
+
+    // Stores a fitness value, evicting the least recently used entry when the cache is full.
+    void Add(uint64 Key, float Fitness);
+
+    // Drops every entry (e.g. when the maze or the reward parameters changed). Counters are kept.
+    void Invalidate();
+
+    // Changes the maximum number of entries. Existing entries are dropped.
+    void SetCapacity(int32 NewCapacity);
+
+    void ResetCounters();
+
+    int32 Num() const { return Entries.Num(); }
+    int32 GetCapacity() const { return Capacity; }
+    int64 GetHits() const { return Hits; }
+    int64 GetMisses() const { return Misses; }
+    float GetHitRate() const;
+
+private:
+    TLruCache<uint64, float> Entries;
+    int32 Capacity;
+    int64 Hits;
+    int64 Misses;
+};
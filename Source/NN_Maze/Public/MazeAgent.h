@@ -6,6 +6,48 @@
 #include "Checkpoint.h"
 #include "MazeAgent.generated.h"
 
+class AProceduralMaze;
+class FChampionSnapshot;
+class FMazeFlowField;
+
+// Terms of the fitness kept apart for multi-objective selection. All are maximized, and the reward rates
+// tuned for the scalar fitness do not weight them. The time penalty has no objective: episodes only end on a
+// crash or at the time limit, so maximizing minus the episode time would reward crashing early.
+UENUM(BlueprintType)
+enum class EMazeObjective : uint8
+{
+    // Distance reward plus shortest-path progress towards the exit.
+    Progress,
+    // Sum of the multipliers of the checkpoints reached.
+    Checkpoints,
+    // Minus the number of wall hits.
+    Collisions,
+    Count UMETA(Hidden)
+};
+
+struct FMazeObjectives
+{
+    static constexpr int32 Num = static_cast<int32>(EMazeObjective::Count);
+
+    float Values[Num] = {};
+
+    float& operator[](EMazeObjective Objective) { return Values[static_cast<int32>(Objective)]; }
+    float operator[](EMazeObjective Objective) const { return Values[static_cast<int32>(Objective)]; }
+};
+
+// One agent's step of the manager-driven update (see AMazeAgent::BeginManagedUpdate).
+struct FMazeAgentUpdate
+{
+    // Snapshot taken on the game thread before the parallel phase.
+    FVector Location = FVector::ZeroVector;
+    FRotator Rotation = FRotator::ZeroRotator;
+    const FMazeFlowField* FlowField = nullptr;
+
+    // Pose computed by the parallel phase, applied on the game thread.
+    FVector NewLocation = FVector::ZeroVector;
+    FRotator NewRotation = FRotator::ZeroRotator;
+};
+
 UCLASS()
 class NN_MAZE_API AMazeAgent : public ACharacter
 {
@@ -27,6 +69,30 @@ public:
     // Processes neural network input and updates movement based on network output
     void ProcessNeuralNetwork();
 
+    static constexpr int32 NumNetworkInputs = 8;
+
+    // Normalized sensor values fed to the network (NumNetworkInputs floats).
+    void GetNetworkInputs(TArrayView<float> OutInputs) const;
+
+    // Moves and turns the agent from the two network outputs.
+    void ApplyNetworkOutputs(float SpeedMultiplier, float RotationDelta);
+
+    // Set by MazeManager when it updates all agents itself, in two phases: the actor tick is then disabled.
+    bool bManagedUpdate;
+
+    // Managed update: walls are detected on the maze grid instead of by physics hits (accelerated training,
+    // where several steps run between two physics updates).
+    bool bGridCollision;
+
+    // Managed update, called by MazeManager for every active agent:
+    // - BeginManagedUpdate (game thread) takes the pose snapshot and runs the physics raycasts, if any;
+    // - ComputeManagedUpdate (any thread) reads the maze grid, runs the network and updates the sensors and the
+    //   fitness from the snapshot. It only writes to this agent, so agents can be computed concurrently;
+    // - ApplyManagedUpdate (game thread) moves the actor.
+    void BeginManagedUpdate(FMazeAgentUpdate& Update, float CurrentTime);
+    void ComputeManagedUpdate(FMazeAgentUpdate& Update, float DeltaTime, float CurrentTime, TArrayView<float> RecurrentState);
+    void ApplyManagedUpdate(const FMazeAgentUpdate& Update);
+
     // Movement properties
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
     float RotationSpeed;
@@ -45,6 +111,10 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Learning")
     float FitnessCheckpointIncreaseRate;
 
+    // Fitness per block of shortest-path progress towards the exit (procedural mazes only, 0 = off)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Learning")
+    float ProgressRewardRate;
+
     UPROPERTY(BlueprintReadWrite, Category = "Learning")
     float Fitness;
 
@@ -84,10 +154,40 @@ public:
     UPROPERTY(BlueprintReadWrite, Category = "AI")
     UNeuralNetwork* NeuralNet;
 
+    // Procedural maze the agent is in. When set, sensors raycast its bit grid instead of the physics scene.
+    UPROPERTY(BlueprintReadWrite, Category = "Vision")
+    AProceduralMaze* Maze;
+
+    // Champion hot-swap: the agent copies every new publication into NeuralNet at its next control tick,
+    // which must then be its own network rather than a member of the population.
+    TSharedPtr<const FChampionSnapshot, ESPMode::ThreadSafe> ChampionSource;
+
 public:
     FVector LastPosition;
     float DistanceTraveled;
 
+    // World time at which the current evaluation started.
+    float EpisodeStartTime;
+
+    float GetRaycastUpdateInterval() const { return RaycastUpdateInterval; }
+
+    // Puts the agent back at the start for a new evaluation, keeping the actor alive (pipelined mode).
+    void ResetForEpisode(const FVector& Location, const FRotator& Rotation);
+
+    // Dead agents are parked by MazeManager: no tick, hidden and without collision, so they cost nothing per frame.
+    void SetSimulationEnabled(bool bEnabled);
+
+    // Novelty search: number of positions sampled over BehaviorDescriptorDuration (0 = not recorded). Set by MazeManager.
+    int32 BehaviorDescriptorPoints;
+    float BehaviorDescriptorDuration;
+
+    // Appends the behaviour descriptor of the episode (2 floats per point, on the maze plane) to OutDescriptor.
+    // Points not reached yet, e.g. after a crash, take the current position.
+    void GetBehaviorDescriptor(TArray<float>& OutDescriptor) const;
+
+    // Objective vector of the episode, accumulated alongside Fitness.
+    const FMazeObjectives& GetObjectives() const { return Objectives; }
+
     UFUNCTION()
     void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 
@@ -100,6 +200,39 @@ private:
     float LastRaycastUpdateTime; // Time of last raycast execution
     float RaycastUpdateInterval; // Minimum interval between raycasts (e.g., 0.1 sec)
 
+    // Flow field of the maze towards ExitLocation, when the sensor or the progress reward needs it.
+    const FMazeFlowField* GetFlowField() const;
+
+    // Adopts the latest champion of ChampionSource, if it changed. Touches only this agent (any thread).
+    void PollChampion();
+
+    // Champion publication held by NeuralNet, and the copy it is read into.
+    uint32 ChampionVersion;
+    TArray<float> ChampionWeights;
+
+    // Sensors and fitness from an explicit pose and time, shared by Tick() and the managed update.
+    void UpdateVision(const FVector& AgentLocation, const FRotator& AgentRotation, float CurrentTime);
+    void UpdateExitSensor(const FVector& AgentLocation, const FRotator& AgentRotation, const FMazeFlowField* FlowField);
+    void UpdateFitness(const FVector& CurrentPosition, float DeltaTime, float CurrentTime, const FMazeFlowField* FlowField);
+
+    // Exit sensor from the flow field: geodesic distance and direction of the shortest path.
+    void UpdateFlowFieldSensor(const FMazeFlowField& FlowField, const FVector& AgentLocation, float AgentYaw);
+
+    // Pose after moving and turning from the two network outputs.
+    void MoveFromNetworkOutputs(float SpeedMultiplier, float RotationDelta, float DeltaTime, FVector& InOutLocation, FRotator& InOutRotation) const;
+
+    // Geodesic distance to the exit at the previous tick, in blocks (-1 = unknown).
+    float LastExitDistance;
+
+    // Positions sampled for the behaviour descriptor.
+    TArray<FVector2D> BehaviorSamples;
+
+    FMazeObjectives Objectives;
+
+    // Position on the maze plane (maze-local when Maze is set).
+    FVector2D GetPlanePosition() const { return GetPlanePosition(GetActorLocation()); }
+    FVector2D GetPlanePosition(const FVector& Location) const;
+
     // Previous sensor values for hysteresis/smoothing
     float PrevDistForward;
     float PrevDistLeft;
@@ -120,4 +253,7 @@ private:
 
     // Applies a reward for reaching a checkpoint.
     void ApplyCheckpointReward(float RewardMultiplier);
+
+    // Applies a reward for getting closer to the exit along the shortest path.
+    void ApplyProgressReward(float ExitDistance);
 };
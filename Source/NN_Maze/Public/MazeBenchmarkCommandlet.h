@@ -0,0 +1,38 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MazeBenchmarkCommandlet.generated.h"
+
+/**
+ * Reproducible end-to-end performance benchmark: spawns a seeded AProceduralMaze in a fresh world,
+ * runs the maze manager for a fixed number of generations at a fixed time step, once per population
+ * size, and writes a JSON report (generations/sec, agent steps/sec, p50/p99 frame time, peak memory).
+ *
+ * With -Baseline=<report.json>, the run fails (exit code 1) when the throughput of a population size
+ * drops by more than -Threshold (fraction) compared to the baseline report.
+ *
+ * Usage: UnrealEditor-Cmd NN_Maze.uproject -run=MazeBenchmark -nullrhi [-Populations=100,1000,10000]
+ *        [-Generations=3] [-TimeLimit=10] [-DeltaTime=0.0333] [-Seed=1234] [-MazeCells=8] [-BlockSize=100]
+ *        [-MazeAlgorithm=RecursiveBacktracker|Prim|Rooms]
+ *        [-Mode=Generational|SteadyState|Pipelined] [-AgentClass=/Game/Blueprints/BP_MazeAgent.BP_MazeAgent_C]
+ *        [-Report=<path>] [-Baseline=<path>] [-Threshold=0.1] [-Telemetry]
+ *        [-MazeInstances=1] [-Headless] [-UpdateThreads=1,2,4,8] [-SerialAgentUpdate]
+ *
+ * -MazeInstances evaluates every genome in K mazes; -Headless runs the generations with the actor-free
+ * simulator (one generation per frame) instead of spawning agents.
+ *
+ * -UpdateThreads runs every population once per thread count of the parallel agent update and reports the
+ * p50 agent update time and its speedup over the first count (scaling measurement); -SerialAgentUpdate
+ * measures the per-actor Tick() path instead.
+ */
+UCLASS()
+class NN_MAZE_API UMazeBenchmarkCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UMazeBenchmarkCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/PrimitiveComponent.h"
+#include "MazeCollisionComponent.generated.h"
+
+class UBodySetup;
+
+/**
+ * Invisible collision made of many boxes in a single physics body.
+ * One body with N box shapes is far cheaper to create and to query than N wall actors or components.
+ */
+UCLASS(ClassGroup = (Collision))
+class NN_MAZE_API UMazeCollisionComponent : public UPrimitiveComponent
+{
+    GENERATED_BODY()
+
+public:
+    UMazeCollisionComponent();
+
+    // Replaces the collision shapes. Boxes are in component space.
+    void SetBoxes(const TArray<FBox>& Boxes);
+
+    // UPrimitiveComponent interface
+    virtual UBodySetup* GetBodySetup() override { return BodySetup; }
+    virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+
+private:
+    UPROPERTY(Transient)
+    UBodySetup* BodySetup;
+
+    FBox LocalBounds;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FMazeGrid;
+
+/**
+ * Geodesic distance to the exit for every block of a maze grid, with the first step of the shortest path.
+ * Built once per maze and exit (Dijkstra over the 8-connected walkable blocks, diagonals only between two
+ * free blocks), then every lookup is a single array read.
+ *
+ * Positions are in grid coordinates (blocks, see FMazeGrid); yaws are in degrees on the maze plane.
+ */
+class NN_MAZE_API FMazeFlowField
+{
+public:
+    void Build(const FMazeGrid& Grid, const FIntPoint& InExitBlock);
+    void Reset();
+
+    bool IsBuilt() const { return Distances.Num() > 0; }
+    const FIntPoint& GetExitBlock() const { return ExitBlock; }
+
+    // Distance in blocks along the shortest path, or -1 for walls, blocks cut off from the exit and positions off the grid.
+    float GetDistance(const FVector2D& GridPosition) const;
+
+    // Longest finite distance of the field, to normalize GetDistance() to [0, 1].
+    float GetMaxDistance() const { return MaxDistance; }
+
+    // Yaw of the first step towards the exit. False in the exit block and wherever GetDistance() is -1.
+    bool GetDirectionYaw(const FVector2D& GridPosition, float& OutYaw) const;
+
+    // Signed angle from Yaw to DirectionYaw, normalized to [-1, 1] like the Euclidean exit sensor.
+    static float GetRelativeAngle(float DirectionYaw, float Yaw) { return FRotator::NormalizeAxis(DirectionYaw - Yaw) / 180.f; }
+
+private:
+    int32 GetIndex(const FVector2D& GridPosition) const;
+
+    int32 Width = 0;
+    int32 Height = 0;
+    FIntPoint ExitBlock = FIntPoint(INDEX_NONE, INDEX_NONE);
+    float MaxDistance = 0.f;
+
+    // Per block, row-major like the grid.
+    TArray<float> Distances;
+
+    // Index of the neighbour to step to (see the direction table in the .cpp), NoDirection when there is none.
+    TArray<uint8> Directions;
+
+    static constexpr uint8 NoDirection = 0xFF;
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MazeGrid.generated.h"
+
+UENUM(BlueprintType)
+enum class EMazeAlgorithm : uint8
+{
+    // Long winding corridors, few dead ends (randomized depth-first search).
+    RecursiveBacktracker,
+    // Short branches and many dead ends (randomized Prim's algorithm).
+    Prim,
+    // Backtracker maze with rectangular rooms carved into it (creates loops and open areas).
+    Rooms
+};
+
+USTRUCT(BlueprintType)
+struct FMazeGenerationSettings
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Maze")
+    EMazeAlgorithm Algorithm = EMazeAlgorithm::RecursiveBacktracker;
+
+    // Number of maze cells along X and Y (a cell is a walkable block surrounded by wall slots)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Maze", meta = (ClampMin = "1"))
+    int32 CellsX = 16;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Maze", meta = (ClampMin = "1"))
+    int32 CellsY = 16;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Maze")
+    int32 Seed = 1234;
+
+    // Rooms algorithm: number of rooms and maximum room size in cells
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Maze", meta = (ClampMin = "0"))
+    int32 RoomCount = 4;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Maze", meta = (ClampMin = "2"))
+    int32 RoomMaxSize = 4;
+};
+
+/**
+ * Maze stored as a bit grid of square blocks, one bit per block (1 = wall).
+ *
+ * A maze of CellsX x CellsY cells uses (2 * CellsX + 1) x (2 * CellsY + 1) blocks: cell (X, Y) is block
+ * (2X + 1, 2Y + 1) and the blocks between two cells are either wall or passage. Grid coordinates are in
+ * blocks; block (X, Y) covers [X, X + 1) x [Y, Y + 1). Everything outside the grid counts as wall.
+ */
+class NN_MAZE_API FMazeGrid
+{
+public:
+    FMazeGrid();
+
+    // Builds a new maze. A 512x512 cell maze takes a few milliseconds.
+    static FMazeGrid Generate(const FMazeGenerationSettings& Settings);
+
+    int32 GetWidth() const { return Width; }
+    int32 GetHeight() const { return Height; }
+
+    bool IsWall(int32 X, int32 Y) const
+    {
+        if (X < 0 || Y < 0 || X >= Width || Y >= Height)
+        {
+            return true;
+        }
+        const int32 Index = Y * Width + X;
+        return (Bits[Index >> 6] >> (Index & 63)) & 1;
+    }
+
+    void SetWall(int32 X, int32 Y, bool bWall);
+
+    // Block coordinates of a maze cell.
+    static FIntPoint CellToBlock(int32 CellX, int32 CellY) { return FIntPoint(2 * CellX + 1, 2 * CellY + 1); }
+
+    /**
+     * Distance (in blocks) from Start to the first wall along Direction, walking the grid cell by cell (DDA).
+     *
+     * @param Start       Ray origin in grid coordinates.
+     * @param Direction   Normalized ray direction.
+     * @param MaxDistance Returned when no wall is hit closer than this.
+     */
+    float Raycast(const FVector2D& Start, const FVector2D& Direction, float MaxDistance) const;
+
+    // True when a circle overlaps any wall block.
+    bool OverlapsWall(const FVector2D& Center, float Radius) const;
+
+    // Wall blocks merged into as few axis-aligned rectangles as possible (greedy row runs extended downwards).
+    TArray<FIntRect> BuildWallRectangles() const;
+
+    uint64 GetHash() const;
+
+private:
+    void Resize(int32 InWidth, int32 InHeight, bool bWall);
+    void CarveBacktracker(int32 CellsX, int32 CellsY, FRandomStream& RandomStream);
+    void CarvePrim(int32 CellsX, int32 CellsY, FRandomStream& RandomStream);
+    void CarveRooms(int32 CellsX, int32 CellsY, int32 RoomCount, int32 RoomMaxSize, FRandomStream& RandomStream);
+
+    int32 Width;
+    int32 Height;
+    TArray<uint64> Bits;
+};
@@ -2,11 +2,51 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "HAL/PlatformProcess.h"
 #include "MazeAgent.h"
+#include "DistributedEvaluation.h"
+#include "MazeTelemetry.h"
+#include "MazeTrajectory.h"
 #include "MazeManager.generated.h"
 
 class UNeuralNetwork;
 class UEvolutionManager;
+class AProceduralMaze;
+class FChampionSnapshot;
+
+// Where the genomes of a generation are evaluated.
+UENUM()
+enum class EEvaluationRole : uint8
+{
+    // Agents are simulated in this world.
+    Local,
+    // Genomes are shipped to worker processes (-MazeCoordinator[=Port]).
+    Coordinator,
+    // Batches are received from a coordinator and simulated here (-MazeWorker=ip:port).
+    Worker
+};
+
+// How evaluation and breeding are scheduled.
+UENUM()
+enum class EEvolutionMode : uint8
+{
+    // Every agent runs for TimeLimit, then the whole population is bred at once.
+    Generational,
+    // A finished agent is recorded in the fitness heap and immediately replaced by a child bred on the spot.
+    SteadyState,
+    // Children are bred on a background task while agents are evaluated; a finished agent is replaced immediately.
+    Pipelined
+};
+
+// How the fitness of a genome evaluated in several mazes is combined.
+UENUM()
+enum class EFitnessAggregation : uint8
+{
+    // Average over the mazes: rewards good overall performance.
+    Mean,
+    // Worst maze: rewards robust behaviours that never fail badly.
+    Min
+};
 
 UCLASS()
 class NN_MAZE_API AMazeManager : public AActor
@@ -16,6 +56,7 @@ class NN_MAZE_API AMazeManager : public AActor
 public:
     AMazeManager();
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
     virtual void Tick(float DeltaTime) override;
 
 public:
@@ -35,12 +76,177 @@ public:
     UPROPERTY(EditAnywhere, Category = "Agent")
     float TimeLimit;
 
+    // Update the agents from the manager: sensing, inference and fitness of all agents in parallel, then the
+    // transforms in one batch on the game thread. Otherwise every agent ticks on its own (recurrent networks
+    // always use the managed update). Only applies in a procedural maze, whose grid the sensing reads from worker
+    // threads: with hand-placed walls, the raycasts would stay serial and the agents keep their own Tick.
+    UPROPERTY(EditAnywhere, Category = "Agent")
+    bool bParallelAgentUpdate;
+
+    // Threads of the parallel agent update (0 = all workers)
+    UPROPERTY(EditAnywhere, Category = "Agent", meta = (EditCondition = "bParallelAgentUpdate", ClampMin = "0"))
+    int32 AgentUpdateThreads;
+
+    // Accelerated training (local in-world evaluation): the simulation advances in fixed substeps, several per
+    // rendered frame, and TimeLimit counts simulated seconds. Walls are then tested on the maze grid, so this
+    // requires a procedural maze; levels without one train in real time.
+    UPROPERTY(EditAnywhere, Category = "Training")
+    bool bAcceleratedTraining;
+
+    // Simulated seconds per real second. SubstepBudgetMs caps the substeps of a frame when the simulation is slower.
+    UPROPERTY(EditAnywhere, Category = "Training", meta = (EditCondition = "bAcceleratedTraining", ClampMin = "0.01"))
+    float SimulationSpeed;
+
+    // Simulated time of a substep. The fitness depends on it, not on SimulationSpeed or the frame rate.
+    UPROPERTY(EditAnywhere, Category = "Training", meta = (EditCondition = "bAcceleratedTraining", ClampMin = "0.001"))
+    float FixedTimeStep;
+
+    // Game thread time the substeps may take per frame, so that rendering keeps up with the display
+    UPROPERTY(EditAnywhere, Category = "Training", meta = (EditCondition = "bAcceleratedTraining", ClampMin = "1"))
+    float SubstepBudgetMs;
+
+    UPROPERTY(EditAnywhere, Category = "Evolution")
+    EEvolutionMode EvolutionMode;
+
+    // Pipelined mode: number of children bred per background task (0 = a quarter of the population)
+    UPROPERTY(EditAnywhere, Category = "Evolution", meta = (ClampMin = "0"))
+    int32 PipelineBatchSize;
+
+    // Multi-objective selection (UEvolutionManager::bUseMultiObjective): objectives the agents are ranked on,
+    // each combined over the maze instances like the fitness. Two objectives take the fastest sort.
+    UPROPERTY(EditAnywhere, Category = "Evolution")
+    TArray<EMazeObjective> SelectionObjectives;
+
+    // Evolution settings class (create a Blueprint subclass of EvolutionManager to tune islands, rates...)
+    UPROPERTY(EditAnywhere, Category = "Evolution")
+    TSubclassOf<UEvolutionManager> EvolutionManagerClass;
+
     UPROPERTY()
     UEvolutionManager* EvolutionManager;
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
     TArray<int32> NetworkLayerConfiguration;
 
+    // Elman recurrent hidden layers, giving the agents a memory across ticks (fixed topologies only).
+    // The agents are then always updated by the manager, which holds their hidden states.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+    bool bRecurrentNetwork;
+
+    // Procedural maze used for grid-based agent sensing (defaults to the first one found in the level)
+    UPROPERTY(EditAnywhere, Category = "Maze")
+    AProceduralMaze* Maze;
+
+    // Number of mazes every genome is evaluated in (generational mode). Instances besides Maze are spawned as
+    // offset copies at BeginPlay.
+    UPROPERTY(EditAnywhere, Category = "Maze", meta = (ClampMin = "1"))
+    int32 NumMazeInstances;
+
+    // Give every maze instance its own seed (otherwise the copies are identical)
+    UPROPERTY(EditAnywhere, Category = "Maze")
+    bool bVaryMazeInstanceSeeds;
+
+    // Gap between two maze instances, in world units
+    UPROPERTY(EditAnywhere, Category = "Maze", meta = (ClampMin = "0"))
+    float MazeInstanceSpacing;
+
+    UPROPERTY(EditAnywhere, Category = "Maze")
+    EFitnessAggregation FitnessAggregation;
+
+    // Evaluate generations with the actor-free simulator on all cores instead of spawning agents
+    // (requires a procedural maze, see MazeSimulation.h)
+    UPROPERTY(EditAnywhere, Category = "Maze")
+    bool bHeadlessEvaluation;
+
+    // Fixed time step of the headless simulation
+    UPROPERTY(EditAnywhere, Category = "Maze", meta = (EditCondition = "bHeadlessEvaluation", ClampMin = "0.001"))
+    float HeadlessTimeStep;
+
+    // Skip the simulation of genomes already evaluated in the same environment. Fixed-step evaluation only
+    // (headless or accelerated): in real time, a cached fitness would freeze one frame-rate dependent sample.
+    UPROPERTY(EditAnywhere, Category = "Evolution")
+    bool bUseFitnessCache;
+
+    // Maximum number of cached evaluations
+    UPROPERTY(EditAnywhere, Category = "Evolution", meta = (EditCondition = "bUseFitnessCache", ClampMin = "1"))
+    int32 FitnessCacheCapacity;
+
+    // --- Distributed evaluation (see DistributedEvaluation.h) ---
+
+    // Port the coordinator listens on (overridden by -MazeCoordinator=Port)
+    UPROPERTY(EditAnywhere, Category = "Distributed")
+    int32 CoordinatorPort;
+
+    // Number of genomes shipped to a worker at once (overridden by -MazeBatchSize=N)
+    UPROPERTY(EditAnywhere, Category = "Distributed", meta = (ClampMin = "1"))
+    int32 DistributedBatchSize;
+
+    // A worker holding a batch longer than this is dropped and the batch is retried elsewhere
+    UPROPERTY(EditAnywhere, Category = "Distributed")
+    float BatchTimeoutSeconds;
+
+    // Idle workers duplicate batches running longer than this
+    UPROPERTY(EditAnywhere, Category = "Distributed")
+    float StragglerSeconds;
+
+    UPROPERTY(EditAnywhere, Category = "Distributed")
+    int32 MaxBatchRetries;
+
+    // Headless worker processes the coordinator starts on this machine (overridden by -MazeLocalWorkers=N)
+    UPROPERTY(EditAnywhere, Category = "Distributed")
+    int32 LocalWorkerCount;
+
+    // Stream per-generation statistics and phase timings to Saved/Telemetry (see MazeTelemetry.h)
+    UPROPERTY(EditAnywhere, Category = "Telemetry")
+    bool bEnableTelemetry;
+
+    // Simulated time between two samples of the active-agent curve
+    UPROPERTY(EditAnywhere, Category = "Telemetry", meta = (EditCondition = "bEnableTelemetry", ClampMin = "0.01"))
+    float TelemetrySampleInterval;
+
+    // --- Replays (see MazeTrajectory.h and AMazeReplayActor) ---
+
+    // Record the pose of every agent and keep its best runs in Saved/Replays/<ReplayFileName>.nnreplay
+    // (local in-world evaluation only)
+    UPROPERTY(EditAnywhere, Category = "Replay")
+    bool bRecordTrajectories;
+
+    // Simulated time between two pose samples
+    UPROPERTY(EditAnywhere, Category = "Replay", meta = (EditCondition = "bRecordTrajectories", ClampMin = "0.01"))
+    float TrajectorySampleInterval;
+
+    // Position resolution of the samples, in world units. A sample moves at most 127 steps per axis.
+    UPROPERTY(EditAnywhere, Category = "Replay", meta = (EditCondition = "bRecordTrajectories", ClampMin = "0.01"))
+    float TrajectoryQuantum;
+
+    // Number of best runs kept in the replay file
+    UPROPERTY(EditAnywhere, Category = "Replay", meta = (EditCondition = "bRecordTrajectories", ClampMin = "1"))
+    int32 NumReplays;
+
+    UPROPERTY(EditAnywhere, Category = "Replay", meta = (EditCondition = "bRecordTrajectories"))
+    FString ReplayFileName;
+
+    // --- Champion agents ---
+
+    // Agents outside the population that drive the best network of the latest generation, swapped into them
+    // while they run (demos, playing against the current best). They start over at StartPosition when they
+    // crash or run out of time. Fixed, non-recurrent topologies only.
+    UPROPERTY(EditAnywhere, Category = "Champion", meta = (ClampMin = "0"))
+    int32 NumChampionAgents;
+
+    // Latest champion weights (null for NEAT), for any other live consumer.
+    TSharedPtr<const FChampionSnapshot, ESPMode::ThreadSafe> GetChampionSnapshot() const { return ChampionSnapshot; }
+
+    // Invalidation hook: call when the maze layout or the agent reward parameters change at runtime
+    UFUNCTION(BlueprintCallable, Category = "Evolution")
+    void InvalidateFitnessCache();
+
+    // Progress counters (benchmarks and tooling)
+    int32 GetGenerationCount() const { return GenerationCount; }
+    int32 GetTotalSimulations() const { return TotalSimulations; }
+
+    // Wall time of the last managed agent update (0 when the agents tick on their own).
+    double GetLastAgentUpdateSeconds() const { return LastAgentUpdateSeconds; }
+
 private:
     // Evolution cycle functions
     void CloseTimer();
@@ -49,6 +255,82 @@ private:
     void UpdateAgents(float DeltaTime);
     void ProcessGeneration();
 
+    bool UsesManagedAgentUpdate() const { return (bParallelAgentUpdate && Maze) || bRecurrentNetwork || IsAcceleratedTraining(); }
+
+    // One simulation step: evolution bookkeeping of the evaluation role, then the agents.
+    void StepSimulation(float DeltaTime);
+
+    // Accelerated training: runs the fixed substeps of a rendered frame.
+    void TickAccelerated(float DeltaTime);
+    bool IsAcceleratedTraining() const;
+
+    // Starts the TimeLimit countdown of a generation, in simulated seconds when accelerated.
+    void StartGenerationTimer();
+
+    // Clock of the agent episodes: the world time, or the simulated time when accelerated.
+    float GetSimulationTime() const;
+
+    // Recurrent networks: clears the hidden state of the agent at AgentIndex (all agents with INDEX_NONE).
+    void ResetRecurrentState(int32 AgentIndex);
+
+    // Active set: dense list of the indices of the running agents. Dead agents are swap-removed and parked.
+    void ResetActiveAgents();
+    void AddActiveAgent(int32 AgentIndex);
+    void RemoveActiveAgent(int32 Slot);
+    void CompactActiveAgents();
+
+    // Copies the fitness of every simulated agent to its network (and its behaviour, with novelty search).
+    void CollectAgentFitness();
+
+    // Novelty search (see UEvolutionManager::ApplyNovelty).
+    bool UsesNoveltySearch() const;
+    int32 GetBehaviorDescriptorSize() const;
+
+    // Multi-objective selection (see UEvolutionManager::ApplyMultiObjective): appends the selected objectives of
+    // one genome, each aggregated over its maze instances, to GenerationObjectives.
+    bool UsesMultiObjective() const;
+    void AppendSelectionObjectives(TConstArrayView<FMazeObjectives> InstanceObjectives);
+
+    // Runs the evolution step and replaces CurrentGeneration with its offspring.
+    void EvolveCurrentGeneration();
+
+    // Multi-maze evaluation: spawns the maze copies and evaluates a whole generation without actors.
+    void SpawnMazeInstances();
+    void EvaluateGenerationHeadless();
+    FVector GetMazeInstanceOffset(int32 Instance) const;
+
+    // Steady-state and pipelined modes: records finished agents and replaces them with freshly bred children.
+    void TickSteadyState();
+    void RequestPipelinedChildren();
+
+    // Distributed evaluation
+    void ConfigureEvaluationRole();
+    void LaunchLocalWorkers(int32 Count);
+    void SubmitGenerationToWorkers();
+    void TickCoordinator();
+    void TickWorker();
+
+    // Hash of everything that influences an evaluation besides the genome itself
+    uint64 ComputeEnvironmentHash() const;
+
+    // Telemetry: active-agent curve sampling and per-generation records.
+    void SampleActiveAgents(float DeltaTime);
+    void RecordGenerationTelemetry(TArray<float> Fitness);
+
+    // Replays: starts the episodes of the spawned agents, samples the running ones, offers finished episodes
+    // to the best runs and rewrites the replay file when they changed.
+    void BeginTrajectories();
+    void SampleTrajectories(float DeltaTime);
+    void SubmitGenerationTrajectories();
+    void SubmitTrajectory(int32 AgentIndex);
+    void SaveReplays();
+
+    // Champion hot-swap: publication of the best network and the champion agents that pick it up.
+    void SpawnChampionAgents();
+    void TickChampionAgents();
+    void PublishGenerationChampion();
+    void PublishChampion(const UNeuralNetwork* Network);
+
 private:
 
     UPROPERTY()
@@ -57,15 +339,95 @@ private:
     UPROPERTY()
     TArray<UNeuralNetwork*> NextGeneration;
 
+    // Agent of genome G in maze instance M is at M * PopulationSize + G.
     UPROPERTY()
     TArray<AMazeAgent*> Agents;
 
+    // Maze instances, Maze first.
+    UPROPERTY()
+    TArray<AProceduralMaze*> MazeInstances;
+
+    // Novelty search and multi-objective selection: networks evaluated this generation, their behaviour
+    // descriptors (one per maze instance, concatenated) and their selection objectives.
+    TArray<UNeuralNetwork*> DescribedNetworks;
+    TArray<float> BehaviorDescriptors;
+    TArray<float> GenerationObjectives;
+
+    // Indices into Agents of the running agents, in no particular order, and the slot of each agent in that list (INDEX_NONE when dead).
+    TArray<int32> ActiveAgentIndices;
+    TArray<int32> ActiveAgentSlots;
+
+    // Recurrent networks: hidden state of every agent, RecurrentStateSize floats per agent, index-aligned with Agents.
+    // Each slice is updated by its agent's own network in the parallel agent update: the genomes differ, so the
+    // population has no shared weight matrix to be run through as one batch.
+    TArray<float> RecurrentStates;
+    int32 RecurrentStateSize;
+
+    // Managed agent update: one record per active agent, in ActiveAgentIndices order.
+    TArray<FMazeAgentUpdate> AgentUpdates;
+
+    // Phase times of the agent update tasks, flushed to the telemetry once per update.
+    TArray<FMazeTelemetryPhaseBuffer> AgentPhaseBuffers;
+    double LastAgentUpdateSeconds;
+
     int32 GenerationCount;
     bool bIsTraining;
     float GenerationFitnessMean;
     float TotalSimulationTime;
     int32 TotalSimulations;
 
+    // Genomes of the current generation that are actually simulated (not served from the fitness cache).
+    int32 GenerationSimulations;
+
     // Timer handle for generation end
     FTimerHandle TimerHandle_CloseTimer;
+
+    // Accelerated training: simulated clock, end of the current generation on it (-1 = none), simulated time
+    // owed to the next substeps and speed actually reached over the last frame.
+    double SimulationTime;
+    double GenerationEndTime;
+    float SubstepBacklog;
+    float EffectiveSimulationSpeed;
+
+    // Steady-state and pipelined modes: agents whose evaluation is recorded and that wait for a child.
+    TArray<bool> AgentAwaitingChild;
+    int32 EvaluationsSinceReport;
+
+    // Steady-state and pipelined modes: fitness of the evaluations since the last report.
+    TArray<float> RecentFitness;
+
+    TUniquePtr<FMazeTelemetry> Telemetry;
+    double LastTelemetryRecordTime;
+    float SimulatedTimeSinceRecord;
+    float TelemetrySampleElapsed;
+    TArray<int32> ActiveAgentSamples;
+
+    // Game thread time spent on telemetry since the last record.
+    uint64 TelemetryOverheadCycles;
+
+    // Replays: pose rings of the agents (index-aligned with Agents) and best runs, time since the last sample.
+    TUniquePtr<FMazeTrajectoryRecorder> TrajectoryRecorder;
+    float TrajectorySampleElapsed;
+    bool bReplaysChanged;
+
+    TSharedPtr<FChampionSnapshot, ESPMode::ThreadSafe> ChampionSnapshot;
+
+    // Champion agents, each with its own network.
+    UPROPERTY()
+    TArray<AMazeAgent*> ChampionAgents;
+
+    // Steady-state mode: best evaluation since the last report, published as it happens.
+    float BestRecentFitness;
+
+    EEvaluationRole EvaluationRole;
+    TUniquePtr<FEvaluationCoordinator> Coordinator;
+    TUniquePtr<FEvaluationWorkerClient> WorkerClient;
+    TArray<FProcHandle> LocalWorkerProcesses;
+
+    // Coordinator: CurrentGeneration indices sent to the workers, in submission order.
+    TArray<int32> SubmittedGenomeIndices;
+
+    // Worker: batch currently being simulated.
+    FGenomeBatch CurrentBatch;
+    bool bHasBatch;
 };
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "MazeTrajectory.h"
+#include "MazeReplayActor.generated.h"
+
+/**
+ * Plays back a run recorded by AMazeManager (see bRecordTrajectories) from its replay file. The recorded poses
+ * are interpolated: nothing is simulated and no network is evaluated, so a replay never slows the training.
+ *
+ * The run drives one actor of PlaybackActorClass, spawned frozen (no tick, no collision), or this actor itself
+ * when no class is set. Runs are stored relative to their maze instance, i.e. they play in the first maze.
+ */
+UCLASS(Blueprintable)
+class NN_MAZE_API AMazeReplayActor : public AActor
+{
+    GENERATED_BODY()
+
+public:
+    AMazeReplayActor();
+
+    virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+    virtual void Tick(float DeltaTime) override;
+
+    // Replay file of Saved/Replays, without extension (AMazeManager::ReplayFileName)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replay")
+    FString ReplayFileName;
+
+    // Run to play, best first
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replay", meta = (ClampMin = "0"))
+    int32 RunIndex;
+
+    // Replayed seconds per second
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replay", meta = (ClampMin = "0"))
+    float PlaybackRate;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replay")
+    bool bLoop;
+
+    // Draw the whole trajectory of the run
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replay")
+    bool bDrawPath;
+
+    // Actor shown moving along the run, typically the agent Blueprint
+    UPROPERTY(EditAnywhere, Category = "Replay")
+    TSubclassOf<AActor> PlaybackActorClass;
+
+    // Reads the replay file again (the manager rewrites it whenever its best runs change) and restarts RunIndex.
+    UFUNCTION(BlueprintCallable, Category = "Replay")
+    bool LoadReplays();
+
+    // Plays a run from its start.
+    UFUNCTION(BlueprintCallable, Category = "Replay")
+    void PlayRun(int32 Index);
+
+    UFUNCTION(BlueprintCallable, Category = "Replay")
+    int32 GetNumRuns() const { return Runs.Num(); }
+
+private:
+    UPROPERTY(VisibleAnywhere, Category = "Replay")
+    USceneComponent* SceneRoot;
+
+    UPROPERTY()
+    AActor* PlaybackActor;
+
+    TArray<FMazeTrajectoryRun> Runs;
+
+    // Decoded poses of the run being played.
+    TArray<FVector> Locations;
+    TArray<float> Yaws;
+    float PlaybackTime;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AMazeAgent;
+class FMazeFlowField;
+class FMazeGrid;
+class UNeuralNetwork;
+struct FMazeObjectives;
+
+// Movement, sensor and reward parameters of an agent, as used by AMazeAgent.
+struct NN_MAZE_API FMazeAgentParams
+{
+    float Speed = 1.f;
+    float RotationSpeed = 300.f;
+    float MaxViewDistance = 30.f;
+    float FitnessTimeDecreaseRate = 10.f;
+    float FitnessCheckpointIncreaseRate = 100.f;
+    float ProgressRewardRate = 0.f;
+    float SensorSmoothingFactor = 0.3f;
+    float RaycastUpdateInterval = 0.1f;
+    float Radius = 34.f;
+    bool bUseExitSensor = false;
+
+    // Reads the parameters of an agent (typically the class default object of the agent Blueprint).
+    static FMazeAgentParams FromAgent(const AMazeAgent* Agent);
+};
+
+struct NN_MAZE_API FMazeSimulationSettings
+{
+    FMazeAgentParams Agent;
+
+    // Start and exit on the maze plane, in world units from the maze corner (see AProceduralMaze::WorldToMaze).
+    FVector2D Start = FVector2D::ZeroVector;
+    FVector2D Exit = FVector2D::ZeroVector;
+    float StartYaw = 0.f;
+
+    // World size of one grid block.
+    float BlockSize = 100.f;
+
+    float TimeLimit = 10.f;
+    float DeltaTime = 1.f / 30.f;
+
+    // Behaviour descriptor: position at this many evenly spaced times of the episode (0 = not recorded).
+    int32 BehaviorDescriptorPoints = 0;
+
+    // Geodesic field towards Exit (see AProceduralMaze::GetFlowField). When set, it drives the exit sensor
+    // and the progress reward like in AMazeAgent; otherwise the exit sensor is Euclidean and there is no progress reward.
+    const FMazeFlowField* FlowField = nullptr;
+};
+
+// One environment of a multi-maze evaluation.
+struct NN_MAZE_API FMazeEvaluationInstance
+{
+    const FMazeGrid* Grid = nullptr;
+    FMazeSimulationSettings Settings;
+};
+
+/**
+ * Actor-free evaluation of networks in a grid maze. Reproduces the agent loop (sensors, network, movement,
+ * distance reward, time penalty, wall penalty) with grid raycasts and grid collision, at a fixed time step.
+ * Checkpoints are not simulated. Agents are independent and evaluated in parallel.
+ */
+class NN_MAZE_API FMazeHeadlessSimulator
+{
+public:
+    // Simulates every network for TimeLimit and writes the result to its Fitness.
+    static void Evaluate(const FMazeGrid& Grid, const FMazeSimulationSettings& Settings, TConstArrayView<UNeuralNetwork*> Networks);
+
+    /**
+     * Simulates every network in every maze. The Networks.Num() x Mazes.Num() episodes are independent and are
+     * spread over all cores together, so adding mazes costs about as much as adding networks.
+     *
+     * @param Mazes       Environments to evaluate in.
+     * @param Networks    Networks to evaluate (null entries are skipped and get a fitness of 0).
+     * @param OutFitness  Receives the fitness of network N in maze M at N * Mazes.Num() + M.
+     * @param OutDescriptors  Optional: receives the behaviour descriptor of each episode, in the same order
+     *                        (2 * BehaviorDescriptorPoints floats each, see FMazeSimulationSettings).
+     * @param OutObjectives   Optional: receives the objective vector of each episode, in the same order.
+     */
+    static void EvaluateAcrossMazes(TConstArrayView<FMazeEvaluationInstance> Mazes, TConstArrayView<UNeuralNetwork*> Networks, TArray<float>& OutFitness,
+        TArray<float>* OutDescriptors = nullptr, TArray<FMazeObjectives>* OutObjectives = nullptr);
+
+    /**
+     * Simulates a single network and returns its fitness.
+     *
+     * @param OutDescriptor  Optional: receives the maze positions sampled for the behaviour descriptor (2 floats per point).
+     * @param OutObjectives  Optional: receives the objective vector of the episode (checkpoints stay at 0).
+     */
+    static float EvaluateOne(const FMazeGrid& Grid, const FMazeSimulationSettings& Settings, const UNeuralNetwork& Network,
+        TArrayView<float> OutDescriptor = TArrayView<float>(), FMazeObjectives* OutObjectives = nullptr);
+};
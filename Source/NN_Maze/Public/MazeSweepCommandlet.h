@@ -0,0 +1,39 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MazeSweepCommandlet.generated.h"
+
+/**
+ * Hyperparameter sweep: trains every combination of the listed values (or -Samples random ones) on headless
+ * mazes, and writes a JSON report comparing them.
+ *
+ * Trials run concurrently: each generation, the populations of all running trials are simulated as one batch
+ * of episodes over the worker threads, then each trial breeds its next generation. Successive halving stops
+ * weak trials early: after MinGenerations, only the best 1/Eta of the trials keep training, for Eta times
+ * more generations, and so on up to MaxGenerations.
+ *
+ * Usage: UnrealEditor-Cmd NN_Maze.uproject -run=MazeSweep [-ElitismRate=0.05,0.1] [-BaseMutationRate=2,5,10]
+ *        [-CrossoverProbability=0.5] [-TargetFitnessDifference=10] [-Population=100,300]
+ *        [-Layers=8,16,2/8,16,16,8,2] [-Samples=0] [-Eta=3] [-MinGenerations=4] [-MaxGenerations=64]
+ *        [-MazeCells=6] [-MazeInstances=2] [-TimeLimit=15] [-DeltaTime=0.0333] [-Seed=1234]
+ *        [-AgentClass=/Game/Blueprints/BP_MazeAgent.BP_MazeAgent_C] [-Report=<path>]
+ *
+ * Layer configurations are separated by '/'. A trial is scored on the best fitness of its latest generation,
+ * averaged over the maze instances.
+ */
+UCLASS()
+class NN_MAZE_API UMazeSweepCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UMazeSweepCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+
+private:
+    // Evolution managers and both generations of the running trials, kept alive across garbage collections.
+    UPROPERTY()
+    TArray<UObject*> TrialObjects;
+};
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Containers/Queue.h"
+#include <atomic>
+
+class FRunnableThread;
+class FEvent;
+class UNeuralNetwork;
+
+// Parts of the training loop whose wall time is reported per generation.
+enum class EMazeTelemetryPhase : uint8
+{
+    Sensing,
+    Inference,
+    Movement,
+    Breeding,
+    Spawning,
+    Count
+};
+
+// Everything recorded for one generation (or one population's worth of evaluations in steady-state modes).
+struct FGenerationTelemetry
+{
+    int32 Generation = 0;
+
+    // Real and simulated time elapsed since the previous record.
+    double WallSeconds = 0.0;
+    float SimulatedSeconds = 0.f;
+
+    // Fitness of every evaluation of the generation; summarized (min/mean/max/percentiles) on the writer thread.
+    TArray<float> Fitness;
+
+    // Root mean square distance of the weights to the population centroid.
+    float Diversity = 0.f;
+
+    float CacheHitRate = 0.f;
+
+    // Number of active agents, sampled at a fixed simulated-time interval during the generation.
+    TArray<int32> ActiveAgents;
+
+    // Time spent in each phase since the previous record, in milliseconds.
+    double PhaseMs[static_cast<int32>(EMazeTelemetryPhase::Count)] = {};
+
+    // Game thread time spent sampling and gathering this record, in milliseconds.
+    double OverheadMs = 0.0;
+
+    // Number of phase scopes closed since the previous record. Their own cost is added to OverheadMs at their
+    // calibrated cost when the record is written.
+    uint64 PhaseScopes = 0;
+};
+
+// Phase times of one parallel task, added to the shared accumulators once the parallel loop is over.
+struct FMazeTelemetryPhaseBuffer
+{
+    uint64 Cycles[static_cast<int32>(EMazeTelemetryPhase::Count)] = {};
+    uint64 Scopes = 0;
+};
+
+/**
+ * Streams per-generation training statistics to Saved/Telemetry/<Run>.csv and <Run>.jsonl.
+ *
+ * The game thread only fills a record and pushes it into a lock-free queue; percentiles, formatting
+ * and file IO happen on a dedicated writer thread. Phase timings are accumulated by
+ * NNMAZE_PHASE_SCOPE (see NNMazeStats.h) from any thread. Inside parallel loops, tasks install a
+ * FMazeTelemetryPhaseBufferScope so that their scopes add to a buffer of their own instead of the shared
+ * atomics, which every worker would otherwise write to.
+ *
+ * overhead_pct is the instrumentation cost relative to wall time: the measured game thread sampling and
+ * gathering time, plus the number of phase scopes times the cost of one scope. That cost is calibrated in
+ * Start with every worker thread closing buffered scopes at once, and with shared-atomic scopes on the game
+ * thread; the higher of the two is used. Scopes closed on worker threads count as CPU time, so parallel phases
+ * are overstated rather than missed.
+ */
+class NN_MAZE_API FMazeTelemetry : public FRunnable
+{
+public:
+    FMazeTelemetry();
+    virtual ~FMazeTelemetry();
+
+    // Creates the output files and starts the writer thread.
+    bool Start(const FString& RunName);
+
+    // Writes the pending records, then closes the files and stops the thread.
+    void Shutdown();
+
+    // Queues a record for the writer thread. Game thread only (single producer).
+    void Submit(FGenerationTelemetry&& Record);
+
+    // Adds time to a phase: to the buffer of the calling thread if one is installed, else to the shared
+    // accumulators. Thread safe.
+    static void AddPhaseCycles(EMazeTelemetryPhase Phase, uint64 Cycles);
+
+    // Installs the phase buffer of the calling thread (null for none) and returns the previous one.
+    static FMazeTelemetryPhaseBuffer* SetThreadPhaseBuffer(FMazeTelemetryPhaseBuffer* Buffer);
+
+    // Adds a task's buffered phase times to the shared accumulators and clears the buffer.
+    static void FlushPhaseBuffer(FMazeTelemetryPhaseBuffer& Buffer);
+
+    // Moves the accumulated phase times into the record and resets the accumulators.
+    static void ConsumePhaseTimes(FGenerationTelemetry& Record);
+
+    // Root mean square distance of the network weights to their centroid.
+    static float ComputeDiversity(const TArray<UNeuralNetwork*>& Population);
+
+    // FRunnable interface
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    void WriteRecord(const FGenerationTelemetry& Record);
+    static void WriteLine(FArchive& File, const FString& Line);
+
+    static std::atomic<uint64> PhaseCycles[static_cast<int32>(EMazeTelemetryPhase::Count)];
+    static std::atomic<uint64> PhaseScopeCount;
+
+    // Measures the cost of one phase scope (two cycle counter reads and the accumulator update).
+    static double CalibrateScopeCost();
+
+    // Cost of one phase scope, see CalibrateScopeCost.
+    double ScopeCostCycles;
+
+    TQueue<FGenerationTelemetry, EQueueMode::Spsc> PendingRecords;
+    TUniquePtr<FArchive> CsvFile;
+    TUniquePtr<FArchive> JsonFile;
+    FRunnableThread* Thread;
+    FEvent* WakeEvent;
+    FThreadSafeBool bStopping;
+};
+
+// Adds the lifetime of the scope to a telemetry phase.
+class FMazeTelemetryPhaseScope
+{
+public:
+    explicit FMazeTelemetryPhaseScope(EMazeTelemetryPhase InPhase)
+        : Phase(InPhase)
+        , StartCycles(FPlatformTime::Cycles64())
+    {
+    }
+
+    ~FMazeTelemetryPhaseScope()
+    {
+        FMazeTelemetry::AddPhaseCycles(Phase, FPlatformTime::Cycles64() - StartCycles);
+    }
+
+private:
+    EMazeTelemetryPhase Phase;
+    uint64 StartCycles;
+};
+
+// Sends the phase scopes of the calling thread to a task buffer for the lifetime of the scope.
+class FMazeTelemetryPhaseBufferScope
+{
+public:
+    explicit FMazeTelemetryPhaseBufferScope(FMazeTelemetryPhaseBuffer& Buffer)
+        : Previous(FMazeTelemetry::SetThreadPhaseBuffer(&Buffer))
+    {
+    }
+
+    ~FMazeTelemetryPhaseBufferScope()
+    {
+        FMazeTelemetry::SetThreadPhaseBuffer(Previous);
+    }
+
+private:
+    FMazeTelemetryPhaseBuffer* Previous;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Compact agent trajectories, recorded during training and replayed by AMazeReplayActor.
+ *
+ * A pose sample is 3 bytes: the displacement since the previous sample on the maze plane, in steps of Quantum
+ * world units (-127 to 127 per axis), and the absolute yaw in 1/256 of a turn. Displacements are taken from the
+ * position the decoder will reconstruct, so a clamped step is caught up by the next ones and rounding errors
+ * never accumulate. At 10 samples per second, 10,000 agents record a 20 s episode in about 6 MB.
+ */
+struct FMazeTrajectorySample
+{
+    int8 DeltaX = 0;
+    int8 DeltaY = 0;
+    uint8 Yaw = 0;
+
+    friend FArchive& operator<<(FArchive& Ar, FMazeTrajectorySample& Sample)
+    {
+        return Ar << Sample.DeltaX << Sample.DeltaY << Sample.Yaw;
+    }
+};
+
+// One recorded episode, as persisted to disk.
+struct NN_MAZE_API FMazeTrajectoryRun
+{
+    int32 Generation = 0;
+    float Fitness = 0.f;
+
+    // Maze instance the agent ran in; Origin is relative to that instance, i.e. in the first maze.
+    int32 MazeInstance = 0;
+
+    float SampleInterval = 0.1f;
+    float Quantum = 2.f;
+
+    // The location of a sample is Origin plus the displacements of the samples up to and including it.
+    FVector Origin = FVector::ZeroVector;
+    TArray<FMazeTrajectorySample> Samples;
+
+    float GetDuration() const { return FMath::Max(0, Samples.Num() - 1) * SampleInterval; }
+
+    // Reconstructs the location and yaw (degrees) of every sample.
+    void Decode(TArray<FVector>& OutLocations, TArray<float>& OutYaws) const;
+
+    friend FArchive& operator<<(FArchive& Ar, FMazeTrajectoryRun& Run)
+    {
+        Ar << Run.Generation << Run.Fitness << Run.MazeInstance << Run.SampleInterval << Run.Quantum << Run.Origin;
+        Run.Samples.BulkSerialize(Ar);
+        return Ar;
+    }
+
+    // Replay files: a header followed by the runs, best first. Name is a file of Saved/Replays, without extension.
+    static FString GetReplayPath(const FString& Name);
+    static bool SaveRuns(const FString& Path, const TArray<FMazeTrajectoryRun>& Runs);
+    static bool LoadRuns(const FString& Path, TArray<FMazeTrajectoryRun>& OutRuns);
+};
+
+/**
+ * Trajectory of every agent of the population, in one preallocated block: each agent owns a ring of Capacity
+ * samples. When an episode outlasts the ring, its oldest samples are dropped and folded into its origin.
+ * Recording an agent only touches that agent's ring, so agents can be recorded concurrently.
+ */
+class NN_MAZE_API FMazeTrajectoryRecorder
+{
+public:
+    // Sizes the rings for NumAgents agents. The memory is kept when the size does not change.
+    void Reset(int32 NumAgents, int32 InCapacity, float InSampleInterval, float InQuantum);
+
+    // Starts a new episode for the agent, with its first sample at Location.
+    void BeginEpisode(int32 AgentIndex, const FVector& Location, float Yaw);
+
+    // Appends a sample. Call every SampleInterval of simulated time while the agent runs.
+    void Record(int32 AgentIndex, const FVector& Location, float Yaw);
+
+    /**
+     * Keeps the episode of the agent among the MaxRuns best ones if its fitness is high enough.
+     *
+     * @param OriginOffset  Subtracted from the recorded locations (offset of the agent's maze instance).
+     * @return True if the run was kept.
+     */
+    bool SubmitRun(int32 AgentIndex, float Fitness, int32 Generation, int32 MazeInstance, const FVector& OriginOffset, int32 MaxRuns);
+
+    // Whether a run of this fitness would be kept by SubmitRun.
+    bool WouldKeepRun(float Fitness, int32 MaxRuns) const;
+
+    // Best runs so far, best first.
+    const TArray<FMazeTrajectoryRun>& GetTopRuns() const { return TopRuns; }
+
+    int32 GetNumAgents() const { return Heads.Num(); }
+    SIZE_T GetAllocatedSize() const { return Samples.GetAllocatedSize() + Heads.GetAllocatedSize(); }
+
+private:
+    struct FHead
+    {
+        // Location at the start of the episode. Positions are sums of quanta from there.
+        FVector Anchor = FVector::ZeroVector;
+
+        // Sum of the dropped displacements, and of every displacement recorded so far.
+        FIntPoint Base = FIntPoint::ZeroValue;
+        FIntPoint Cursor = FIntPoint::ZeroValue;
+
+        int32 First = 0;
+        int32 Num = 0;
+    };
+
+    TArray<FMazeTrajectorySample> Samples;
+    TArray<FHead> Heads;
+    TArray<FMazeTrajectoryRun> TopRuns;
+    int32 Capacity = 0;
+    float SampleInterval = 0.1f;
+    float Quantum = 2.f;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
+#include "MazeTelemetry.h"
+#include <atomic>
+
+/**
+ * Profiling hooks of the simulation and of the evolution.
+ *
+ * - "stat NNMaze" in the console shows the scopes and per-frame counters below.
+ * - Unreal Insights: the scopes are CPU events on the NNMaze trace channel and the counters are trace counters.
+ *   Profiling a 5k-agent run:
+ *     UnrealEditor NN_Maze.uproject /Game/Level/LVL_Maze -game -trace=cpu,counters,NNMaze -tracefile=NNMaze.utrace
+ *   (with PopulationSize = 5000 on the MazeManager).
+ */
+UE_TRACE_CHANNEL_EXTERN(NNMazeChannel, NN_MAZE_API);
+
+DECLARE_STATS_GROUP(TEXT("NN_Maze"), STATGROUP_NNMaze, STATCAT_Advanced);
+
+// Telemetry phases (see NNMAZE_PHASE_SCOPE).
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Sensing"), STAT_NNMaze_Sensing, STATGROUP_NNMaze, NN_MAZE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Inference"), STAT_NNMaze_Inference, STATGROUP_NNMaze, NN_MAZE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Movement"), STAT_NNMaze_Movement, STATGROUP_NNMaze, NN_MAZE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Breeding"), STAT_NNMaze_Breeding, STATGROUP_NNMaze, NN_MAZE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawning"), STAT_NNMaze_Spawning, STATGROUP_NNMaze, NN_MAZE_API);
+
+// Enclosing scopes.
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Agent tick"), STAT_NNMaze_AgentTick, STATGROUP_NNMaze, NN_MAZE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Manager tick"), STAT_NNMaze_ManagerTick, STATGROUP_NNMaze, NN_MAZE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Process generation"), STAT_NNMaze_ProcessGeneration, STATGROUP_NNMaze, NN_MAZE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Emit migrants"), STAT_NNMaze_EmitMigrants, STATGROUP_NNMaze, NN_MAZE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Breed island"), STAT_NNMaze_BreedIsland, STATGROUP_NNMaze, NN_MAZE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Headless evaluation"), STAT_NNMaze_HeadlessEvaluation, STATGROUP_NNMaze, NN_MAZE_API);
+
+// Per-frame counters.
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Active agents"), STAT_NNMaze_ActiveAgents, STATGROUP_NNMaze, NN_MAZE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Rays/frame"), STAT_NNMaze_RaysPerFrame, STATGROUP_NNMaze, NN_MAZE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Inferences/frame"), STAT_NNMaze_InferencesPerFrame, STATGROUP_NNMaze, NN_MAZE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Allocations/frame"), STAT_NNMaze_AllocationsPerFrame, STATGROUP_NNMaze, NN_MAZE_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Generation transition (ms)"), STAT_NNMaze_GenerationTransitionMs, STATGROUP_NNMaze, NN_MAZE_API);
+
+// Generation memory: heap held by the current and next generations, and networks created by the last generation.
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Population memory"), STAT_NNMaze_PopulationMemory, STATGROUP_NNMaze, NN_MAZE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Networks created"), STAT_NNMaze_NetworksCreated, STATGROUP_NNMaze, NN_MAZE_API);
+
+// Named CPU scope on the NNMaze trace channel, also counted in "stat NNMaze".
+#define NNMAZE_SCOPE(Name) \
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(NNMaze_##Name, NNMazeChannel); \
+    SCOPE_CYCLE_COUNTER(STAT_NNMaze_##Name)
+
+/**
+ * Instruments a scope as one of the telemetry phases: NNMAZE_SCOPE plus the per-generation timing
+ * written by FMazeTelemetry.
+ */
+#define NNMAZE_PHASE_SCOPE(Phase) \
+    NNMAZE_SCOPE(Phase); \
+    FMazeTelemetryPhaseScope PREPROCESSOR_JOIN(NNMazePhaseScope_, __LINE__)(EMazeTelemetryPhase::Phase)
+
+/**
+ * Work counters accumulated during a frame (from any thread) and published once per frame
+ * to the stats system and to the trace.
+ */
+class NN_MAZE_API FNNMazeFrameCounters
+{
+public:
+    static void AddRays(int32 Count) { Rays.fetch_add(Count, std::memory_order_relaxed); }
+    static void AddInferences(int32 Count) { Inferences.fetch_add(Count, std::memory_order_relaxed); }
+
+    // Publishes the counts since the previous call, then resets them. Called once per frame by the maze manager.
+    static void PublishFrame();
+
+    static void PublishGenerationTransition(double Milliseconds);
+
+    // Publishes the population memory accounting. Called after each generation by the maze manager.
+    static void PublishPopulationMemory(int64 Bytes, int32 NetworksCreated);
+
+    // Inferences published since startup (agent steps).
+    static int64 GetTotalInferences() { return TotalInferences; }
+
+private:
+    static std::atomic<int32> Rays;
+    static std::atomic<int32> Inferences;
+    static int64 TotalInferences;
+    static uint64 LastMallocCalls;
+};
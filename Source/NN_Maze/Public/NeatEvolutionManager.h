@@ -0,0 +1,108 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EvolutionManager.h"
+#include "NeatGenome.h"
+#include "NeatEvolutionManager.generated.h"
+
+// Group of structurally similar genomes that compete mostly among themselves.
+struct FNeatSpecies
+{
+    int32 Id = 0;
+
+    // Genome new members are compared against (a random member of the previous generation).
+    FNeatGenome Representative;
+
+    // Indices into the generation being bred.
+    TArray<int32> Members;
+
+    float BestFitness = TNumericLimits<float>::Lowest();
+    int32 LastImprovementGeneration = 0;
+};
+
+/**
+ * NEAT (NeuroEvolution of Augmenting Topologies): genomes start as minimal input-output networks and grow
+ * nodes and connections through mutation. Genomes are speciated by compatibility distance and fitness is
+ * shared within species so new structures get time to optimize their weights.
+ *
+ * Select it with EvolutionManagerClass on the maze manager. Generational mode only.
+ */
+UCLASS(Blueprintable)
+class NN_MAZE_API UNeatEvolutionManager : public UEvolutionManager
+{
+    GENERATED_BODY()
+
+public:
+    UNeatEvolutionManager();
+
+    virtual void ProcessGeneration(TArray<UNeuralNetwork*>& CurrentGeneration,
+        TArray<UNeuralNetwork*>& NextGeneration,
+        float& OutGenerationFitnessMean,
+        int32 PopulationSize) override;
+
+    virtual void InitializeNetwork(UNeuralNetwork* Network, const TArray<int32>& LayerConfig, bool bRecurrent) override;
+
+    virtual bool UsesFixedTopology() const override { return false; }
+
+    // Genomes closer than this (see FNeatGenome::CompatibilityDistance) belong to the same species
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|NEAT", meta = (ClampMin = "0.1"))
+    float CompatibilityThreshold;
+
+    // The threshold is nudged every generation to keep about this many species (0 keeps it fixed)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|NEAT", meta = (ClampMin = "0"))
+    int32 TargetSpeciesCount;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|NEAT")
+    float ExcessCoefficient;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|NEAT")
+    float DisjointCoefficient;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|NEAT")
+    float WeightCoefficient;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|NEAT", meta = (ClampMin = "0", ClampMax = "1"))
+    float AddConnectionProbability;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|NEAT", meta = (ClampMin = "0", ClampMax = "1"))
+    float AddNodeProbability;
+
+    // Probability that a child's weights are mutated at all
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|NEAT", meta = (ClampMin = "0", ClampMax = "1"))
+    float WeightMutationProbability;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|NEAT", meta = (ClampMin = "0"))
+    float WeightPerturbPower;
+
+    // Per-weight probability of a fresh random value instead of a perturbation
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|NEAT", meta = (ClampMin = "0", ClampMax = "1"))
+    float WeightReplaceProbability;
+
+    // Probability that a child has two parents rather than being a mutated copy
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|NEAT", meta = (ClampMin = "0", ClampMax = "1"))
+    float CrossoverRate;
+
+    // Fraction of each species (the best ones) allowed to reproduce
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|NEAT", meta = (ClampMin = "0.01", ClampMax = "1"))
+    float SurvivalThreshold;
+
+    // Species without improvement for this many generations get no offspring (the best species is always kept)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Evolution|NEAT", meta = (ClampMin = "1"))
+    int32 StagnationGenerations;
+
+    int32 GetNumSpecies() const { return Species.Num(); }
+
+private:
+    // Assigns every genome of the generation to a species, creating species as needed.
+    void Speciate(const TArray<UNeuralNetwork*>& Generation);
+
+    // Breeds one child of a species into Child.
+    void BreedChild(const FNeatSpecies& Parents, int32 NumParents, const TArray<UNeuralNetwork*>& Generation, UNeuralNetwork* Child);
+
+    TArray<FNeatSpecies> Species;
+    FNeatInnovationTracker Innovations;
+    FRandomStream RandomStream;
+    int32 NextSpeciesId;
+    int32 NeatGeneration;
+    bool bInnovationsInitialized;
+};
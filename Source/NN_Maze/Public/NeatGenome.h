@@ -0,0 +1,133 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class ENeatNodeType : uint8
+{
+    Input,
+    Bias,
+    Output,
+    Hidden
+};
+
+struct FNeatNodeGene
+{
+    int32 Id = 0;
+    ENeatNodeType Type = ENeatNodeType::Hidden;
+};
+
+struct FNeatConnectionGene
+{
+    // Historical marking: connections with the same innovation number are the same structure in two genomes.
+    int32 Innovation = 0;
+    int32 From = 0;
+    int32 To = 0;
+    float Weight = 0.f;
+    bool bEnabled = true;
+};
+
+/**
+ * Hands out innovation numbers and hidden node ids. The same structural mutation gets the same number
+ * whichever genome makes it, so crossover and speciation can line genomes up gene by gene.
+ */
+class NN_MAZE_API FNeatInnovationTracker
+{
+public:
+    // Forgets every innovation; hidden node ids start at FirstHiddenNodeId.
+    void Reset(int32 FirstHiddenNodeId);
+
+    int32 GetConnectionInnovation(int32 From, int32 To);
+
+    // Id of the hidden node inserted when splitting the given connection.
+    int32 GetSplitNodeId(int32 ConnectionInnovation);
+
+private:
+    TMap<TPair<int32, int32>, int32> ConnectionInnovations;
+    TMap<int32, int32> SplitNodeIds;
+    int32 NextInnovation = 0;
+    int32 NextNodeId = 0;
+};
+
+/**
+ * NEAT genome: node genes and connection genes with innovation numbers. Connections always form a DAG
+ * (cycles are rejected when adding a connection), so the network can be evaluated in a single pass.
+ *
+ * Node ids: inputs are [0, NumInputs), the bias is NumInputs, outputs follow, hidden nodes come from the tracker.
+ */
+struct NN_MAZE_API FNeatGenome
+{
+    int32 NumInputs = 0;
+    int32 NumOutputs = 0;
+
+    // Sorted by id.
+    TArray<FNeatNodeGene> Nodes;
+
+    // Sorted by innovation number.
+    TArray<FNeatConnectionGene> Connections;
+
+    // Id of the first hidden node for a given input and output count.
+    static int32 GetFirstHiddenNodeId(int32 InNumInputs, int32 InNumOutputs) { return InNumInputs + 1 + InNumOutputs; }
+
+    // Inputs and bias fully connected to the outputs, with random weights.
+    static FNeatGenome CreateMinimal(int32 InNumInputs, int32 InNumOutputs, FNeatInnovationTracker& Innovations, FRandomStream& RandomStream);
+
+    // Each weight is replaced with ReplaceProbability, otherwise perturbed by up to PerturbPower.
+    void MutateWeights(float PerturbPower, float ReplaceProbability, FRandomStream& RandomStream);
+
+    // Adds a connection between two unconnected nodes. Returns false if no valid pair was found.
+    bool MutateAddConnection(FNeatInnovationTracker& Innovations, FRandomStream& RandomStream);
+
+    // Splits an enabled connection with a new hidden node. Returns false if there is nothing to split.
+    bool MutateAddNode(FNeatInnovationTracker& Innovations, FRandomStream& RandomStream);
+
+    /**
+     * Matching genes are inherited from either parent at random, disjoint and excess genes from the fitter one.
+     * A gene disabled in either parent stays disabled with a 75% chance.
+     */
+    static FNeatGenome Crossover(const FNeatGenome& Fitter, const FNeatGenome& Other, FRandomStream& RandomStream);
+
+    // Speciation distance: ExcessCoefficient * E / N + DisjointCoefficient * D / N + WeightCoefficient * mean matching weight difference.
+    static float CompatibilityDistance(const FNeatGenome& A, const FNeatGenome& B, float ExcessCoefficient, float DisjointCoefficient, float WeightCoefficient);
+
+    uint64 ComputeHash(uint64 Seed) const;
+
+    int32 GetNumHiddenNodes() const { return Nodes.Num() - GetFirstHiddenNodeId(NumInputs, NumOutputs); }
+
+private:
+    bool HasNode(int32 Id) const;
+    bool HasConnection(int32 From, int32 To) const;
+    void AddConnection(const FNeatConnectionGene& Gene);
+
+    // True if To can be reached from From through any connection, enabled or not.
+    bool IsReachable(int32 From, int32 To) const;
+};
+
+/**
+ * Genome compiled for evaluation: nodes are renumbered in topological order and the enabled connections are
+ * stored as a CSR matrix (incoming connections of each node, contiguous). An evaluation is a single pass over
+ * flat arrays, with the same tanh activation as the dense network.
+ */
+class NN_MAZE_API FNeatCompiledNetwork
+{
+public:
+    explicit FNeatCompiledNetwork(const FNeatGenome& Genome);
+
+    int32 GetNumInputs() const { return NumInputs; }
+    int32 GetNumOutputs() const { return OutputSlots.Num(); }
+
+    // Inputs.Num() must be GetNumInputs() and Outputs.Num() GetNumOutputs().
+    void Evaluate(TConstArrayView<float> Inputs, TArrayView<float> Outputs) const;
+
+private:
+    int32 NumInputs = 0;
+
+    // Node values by slot: the inputs, the bias, then the computed nodes in topological order.
+    int32 NumSlots = 0;
+
+    // Incoming connections of computed slot NumInputs + 1 + Row are [RowOffsets[Row], RowOffsets[Row + 1]).
+    TArray<int32> RowOffsets;
+    TArray<int32> SourceSlots;
+    TArray<float> RowWeights;
+
+    TArray<int32> OutputSlots;
+};
@@ -1,8 +1,93 @@
 #pragma once
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
+#include "NeatGenome.h"
 #include "NeuralNetwork.generated.h"
 
+UENUM(BlueprintType)
+enum class EMutationOperator : uint8
+{
+    // Replaces the weight with a fresh uniform value in [-1, 1].
+    Reset,
+    // Adds Gaussian noise scaled by the genome's self-adapted step size.
+    Gaussian
+};
+
+UENUM(BlueprintType)
+enum class ECrossoverOperator : uint8
+{
+    // Every weight from either parent (CrossoverProbability for the first one).
+    Uniform,
+    // Weights before a random cut from the first parent, the rest from the second.
+    SinglePoint,
+    // Every weight blended between the parents, with one random factor per child.
+    Arithmetic,
+    // Every layer from either parent (CrossoverProbability for the first one).
+    LayerWise
+};
+
+UENUM(BlueprintType)
+enum class EWeightClampPolicy : uint8
+{
+    None,
+    // Saturates at +-WeightLimit.
+    Clamp,
+    // Mirrors values beyond +-WeightLimit back into range, so weights do not pile up on the limit.
+    Reflect
+};
+
+USTRUCT(BlueprintType)
+struct FMutationSettings
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mutation")
+    EMutationOperator Operator = EMutationOperator::Reset;
+
+    // Gaussian: step size of genomes that have not inherited one
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mutation", meta = (ClampMin = "0"))
+    float InitialStepSize = 0.1f;
+
+    // Gaussian: learning rate of the log-normal step size self-adaptation (0 keeps the step size fixed)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mutation", meta = (ClampMin = "0"))
+    float SelfAdaptationRate = 0.2f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mutation", meta = (ClampMin = "0"))
+    float MinStepSize = 0.001f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mutation", meta = (ClampMin = "0"))
+    float MaxStepSize = 1.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mutation")
+    EWeightClampPolicy ClampPolicy = EWeightClampPolicy::None;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mutation", meta = (ClampMin = "0.01"))
+    float WeightLimit = 4.f;
+};
+
+/**
+ * Sparse mutation of a weight sequence passed in consecutive chunks (rows, or the chunks of a breeding pass):
+ * each weight mutates with probability Condition percent, and only the mutated weights cost random draws
+ * (geometric skipping, carried from one chunk to the next).
+ */
+class NN_MAZE_API FSparseMutator
+{
+public:
+    FSparseMutator(float Condition, const FMutationSettings& InSettings, float InStepSize, FRandomStream& InRandomStream);
+
+    // Mutates the next chunk of the sequence.
+    void Apply(TArrayView<float> Chunk);
+
+private:
+    const FMutationSettings& Settings;
+    float StepSize;
+    FRandomStream& RandomStream;
+    double LogKeep;
+
+    // Weights to leave untouched before the next mutation, from the start of the next chunk.
+    int64 Skip;
+};
+
 UCLASS(Blueprintable)
 class NN_MAZE_API UNeuralNetwork : public UObject
 {
@@ -10,20 +95,104 @@ class NN_MAZE_API UNeuralNetwork : public UObject
 
 public:
 
-    void Initialize(const TArray<int32>& Layers);
+    /**
+     * @param Layers      Neuron count of every layer, inputs first.
+     * @param bInRecurrent  Elman recurrence: every hidden layer also receives its own outputs from the previous step.
+     *                    The recurrent weights are appended to each neuron's weight row, so crossover, mutation
+     *                    and flattening treat them like any other weight.
+     */
+    void Initialize(const TArray<int32>& Layers, bool bInRecurrent = false);
     void CopyWeights(const UNeuralNetwork* SourceNetwork);
+
+    // Stateless evaluation (a recurrent network starts from a zero state).
     TArray<float> FeedForward(const TArray<float>& Inputs) const;
+
+    /**
+     * Evaluation of one step without allocations, for any network (feed-forward networks have no state).
+     *
+     * @param State    Hidden layer outputs of the previous step (GetStateSize() floats), updated in place.
+     * @param Outputs  Receives the output layer.
+     */
+    void FeedForward(TConstArrayView<float> Inputs, TArrayView<float> State, TArrayView<float> Outputs) const;
+
+    bool IsRecurrentLayer(int32 LayerIndex) const { return bRecurrent && LayerIndex > 0 && LayerIndex < LayerSizes.Num() - 1; }
+
+    // Number of floats of per-agent state: the outputs of the recurrent layers.
+    int32 GetStateSize() const;
+
     void Mutate(float Condition);
 
+    // Same as Mutate() but draws from the given stream, so it can run on worker threads.
+    void Mutate(float Condition, FRandomStream& RandomStream);
+
+    /**
+     * Mutates each weight with probability Condition percent. Only the mutated weights cost random draws
+     * (geometric skipping), so a low rate on a large network is cheap. The Gaussian operator first
+     * self-adapts MutationStepSize, then perturbs the weights with it.
+     */
+    void Mutate(float Condition, FRandomStream& RandomStream, const FMutationSettings& Settings);
+
+    // Mutation applied to raw weights (e.g. flattened genomes bred outside of a network).
+    static void MutateWeights(TArrayView<float> InWeights, float Condition, FRandomStream& RandomStream);
+
+    // Same, with the given operator; StepSize is the Gaussian standard deviation.
+    static void MutateWeights(TArrayView<float> InWeights, float Condition, FRandomStream& RandomStream, const FMutationSettings& Settings, float StepSize);
+
+    // Log-normal self-adaptation: StepSize * exp(SelfAdaptationRate * N(0, 1)), within the settings' bounds.
+    static float AdaptStepSize(float StepSize, const FMutationSettings& Settings, FRandomStream& RandomStream);
+
+    // Total number of weights across all layers.
+    int32 GetNumWeights() const;
+
+    // True for a fixed-topology network with these layers, i.e. one that Initialize would only re-randomize.
+    bool HasTopology(const TArray<int32>& InLayerSizes, bool bInRecurrent) const;
+
+    // Heap bytes held by the layer sizes, neurons, weights and NEAT genome (a genome shared by elites is counted by each of them).
+    int64 GetAllocatedSize() const;
+
+    // Copies every weight, layer by layer, into a single contiguous array.
+    void FlattenWeights(TArray<float>& OutWeights) const;
+
+    // Start of every layer in the flattened weights, followed by the total number of weights.
+    void GetLayerOffsets(TArray<int32>& OutOffsets) const;
+
+    // Overwrites the weights from a flattened array. Returns false if the size does not match.
+    bool SetFlatWeights(TConstArrayView<float> FlatWeights);
+
+    // Hash of the layer configuration and every weight (or of the NEAT genome), chained from Seed.
+    uint64 ComputeWeightsHash(uint64 Seed = 0) const;
+
+    /**
+     * Turns the network into a variable-topology NEAT network. The genome is compiled once here; FeedForward
+     * then evaluates the compiled form until the next SetGenome (a mutated genome is a new genome).
+     */
+    void SetGenome(FNeatGenome&& InGenome);
+
+    // NEAT genome, or null for a fixed-topology network.
+    const FNeatGenome* GetGenome() const { return Genome.Get(); }
+
     UFUNCTION(BlueprintCallable)
         int32 GetInputSize() const;
 
     UPROPERTY(BlueprintReadWrite)
         float Fitness;
 
+    // Key the selection ranks on: Fitness, or the novelty / NSGA-II score when one of those selects (see
+    // UEvolutionManager::ApplyNovelty). Fitness itself always stays the raw objective.
+    float SelectionScore = 0.f;
+
+    // Gaussian mutation step size, inherited by the children and self-adapted (0 = InitialStepSize).
+    float MutationStepSize = 0.f;
+
 public :
 
     TArray<int32> LayerSizes;
+    bool bRecurrent = false;
     TArray<TArray<float>> Neurons;
     TArray<TArray<TArray<float>>> Weights;
+
+private:
+    // Immutable once set, so copies of a network (elites) share them without recompiling.
+    TSharedPtr<const FNeatGenome> Genome;
+    TSharedPtr<const FNeatCompiledNetwork> CompiledGenome;
 };
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Squared distances of the nearest neighbours found so far, as a max-heap (farthest on top).
+using FNearestNeighbors = TArray<float, TInlineAllocator<32>>;
+
+/**
+ * Static k-d tree over fixed-size float descriptors. The points are copied in tree order so a query walks
+ * contiguous memory, and ranges of up to LeafSize points are scanned linearly.
+ */
+class NN_MAZE_API FDescriptorKdTree
+{
+public:
+    /**
+     * Builds the tree.
+     *
+     * @param InPoints     Descriptors stored back to back, InDimension floats each.
+     * @param InDimension  Number of floats per descriptor.
+     */
+    void Build(TConstArrayView<float> InPoints, int32 InDimension);
+
+    void Reset();
+
+    int32 Num() const { return Indices.Num(); }
+
+    /**
+     * Merges the K points nearest to Query into Nearest.
+     *
+     * @param SkipIndex  Index (in the array given to Build) of a point to ignore, typically the query itself.
+     */
+    void GatherNearest(const float* Query, int32 K, FNearestNeighbors& Nearest, int32 SkipIndex = INDEX_NONE) const;
+
+    // Adds a candidate squared distance to a bounded max-heap of nearest neighbours.
+    static void AddCandidate(float CandidateDistanceSquared, int32 K, FNearestNeighbors& Nearest);
+
+    static float DistanceSquared(const float* A, const float* B, int32 NumDimensions);
+
+private:
+    void BuildRange(int32 Begin, int32 End, TArray<int32>& Order, TConstArrayView<float> InPoints);
+    void SearchRange(int32 Begin, int32 End, const float* Query, int32 K, FNearestNeighbors& Nearest, int32 SkipIndex) const;
+
+    static constexpr int32 LeafSize = 8;
+
+    int32 Dimension = 0;
+
+    // Descriptors in tree order: the median of a range [Begin, End) is at (Begin + End) / 2.
+    TArray<float> Points;
+
+    // Build index of every point, in tree order.
+    TArray<int32> Indices;
+
+    // Split axis of the range whose median is at this position.
+    TArray<uint16> SplitAxis;
+};
+
+/**
+ * Archive of behaviour descriptors for novelty search. The novelty of a behaviour is the mean distance to
+ * its K nearest neighbours among the archive and the rest of its generation.
+ *
+ * The archive is indexed by a k-d tree rebuilt once enough descriptors were added since the last build
+ * (O(N log N) per rebuild); the few descriptors added since are scanned linearly. Batches are queried in parallel.
+ */
+class NN_MAZE_API FNoveltyArchive
+{
+public:
+    // Empties the archive and sets the descriptor size.
+    void Reset(int32 InDimension);
+
+    int32 GetDimension() const { return Dimension; }
+    int32 Num() const { return Dimension > 0 ? Descriptors.Num() / Dimension : 0; }
+
+    void Add(TConstArrayView<float> Descriptor);
+
+    /**
+     * Computes the novelty of every descriptor of a batch.
+     *
+     * @param Batch       Descriptors stored back to back, GetDimension() floats each.
+     * @param K           Number of nearest neighbours averaged.
+     * @param OutNovelty  Receives one novelty per descriptor.
+     */
+    void ComputeNovelty(TConstArrayView<float> Batch, int32 K, TArray<float>& OutNovelty);
+
+private:
+    // Rebuilds the k-d tree when too many descriptors are only reachable by the linear scan.
+    void UpdateIndex();
+
+    // Descriptors added since the last rebuild are scanned linearly until there are this many.
+    static constexpr int32 MaxUnindexed = 256;
+
+    int32 Dimension = 0;
+    TArray<float> Descriptors;
+    FDescriptorKdTree Index;
+};
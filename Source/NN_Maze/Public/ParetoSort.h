@@ -0,0 +1,33 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Non-dominated sorting and crowding distance of NSGA-II. All objectives are maximized; a point dominates another
+ * when it is at least as good on every objective and better on one.
+ *
+ * Objective vectors are stored back to back, NumObjectives floats per point.
+ */
+class NN_MAZE_API FParetoSort
+{
+public:
+    /**
+     * Ranks every point by Pareto front (0 = non-dominated).
+     *
+     * Two objectives take O(N log N): points sorted on the first objective are placed by a binary search on the
+     * best second objective of each front. More objectives use the efficient non-dominated sort with a binary
+     * search over the fronts (O(M N log N) in practice, O(M N^2) at worst).
+     *
+     * @param OutNumFronts  Receives the number of fronts.
+     */
+    static void ComputeFronts(TConstArrayView<float> Objectives, int32 NumObjectives, TArray<int32>& OutRanks, int32& OutNumFronts);
+
+    /**
+     * Crowding distance of every point within its front: sum over the objectives of the gap between its
+     * neighbours, normalized by the front's range. The extremes of a front get MAX_flt.
+     */
+    static void ComputeCrowding(TConstArrayView<float> Objectives, int32 NumObjectives, TConstArrayView<int32> Ranks, TArray<float>& OutCrowding);
+
+    // True when A dominates B.
+    static bool Dominates(const float* A, const float* B, int32 NumObjectives);
+};
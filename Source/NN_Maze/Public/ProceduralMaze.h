@@ -0,0 +1,84 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "MazeGrid.h"
+#include "MazeFlowField.h"
+#include "ProceduralMaze.generated.h"
+
+class UHierarchicalInstancedStaticMeshComponent;
+class UMazeCollisionComponent;
+class UStaticMesh;
+
+/**
+ * Seeded procedural maze. Wall blocks are merged into rectangles, rendered by a single instanced mesh
+ * component and collided through a single multi-box body. The bit grid also backs the grid raycasts used
+ * by the agent sensors and the headless simulation (see MazeSimulation.h).
+ *
+ * The maze lies on the actor's XY plane: block (X, Y) covers [X, X + 1) * BlockSize from the actor origin.
+ */
+UCLASS(Blueprintable)
+class NN_MAZE_API AProceduralMaze : public AActor
+{
+    GENERATED_BODY()
+
+public:
+    AProceduralMaze();
+
+    virtual void OnConstruction(const FTransform& Transform) override;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Maze")
+    FMazeGenerationSettings Settings;
+
+    // World size of one grid block (cells and wall slots have the same size)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Maze", meta = (ClampMin = "1"))
+    float BlockSize;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Maze", meta = (ClampMin = "1"))
+    float WallHeight;
+
+    // Mesh instanced for the walls and scaled to each merged wall rectangle (engine cube by default)
+    UPROPERTY(EditAnywhere, Category = "Maze")
+    UStaticMesh* WallMesh;
+
+    // Rebuilds the grid, the wall instances and the collision from Settings.
+    UFUNCTION(BlueprintCallable, Category = "Maze")
+    void Generate();
+
+    const FMazeGrid& GetGrid() const { return Grid; }
+
+    // World location of the center of a maze cell, at floor level.
+    UFUNCTION(BlueprintCallable, Category = "Maze")
+    FVector GetCellLocation(int32 CellX, int32 CellY) const;
+
+    // Distance from Start to the first wall along Direction (projected on the maze plane), capped to MaxDistance.
+    float Raycast(const FVector& Start, const FVector& Direction, float MaxDistance) const;
+
+    // Projects a world location on the maze plane, in world units from the maze corner.
+    FVector2D WorldToMaze(const FVector& WorldLocation) const;
+
+    // Same, in grid coordinates (blocks).
+    FVector2D WorldToGrid(const FVector& WorldLocation) const { return WorldToMaze(WorldLocation) / BlockSize; }
+
+    // Yaw of a world rotation on the maze plane.
+    float WorldToMazeYaw(float WorldYaw) const { return WorldYaw - GetActorRotation().Yaw; }
+
+    /**
+     * Geodesic distance field towards the block containing ExitWorldLocation. Built on the first call
+     * (game thread only), then reused until the exit block or the grid changes.
+     */
+    const FMazeFlowField& GetFlowField(const FVector& ExitWorldLocation);
+
+private:
+    UPROPERTY(VisibleAnywhere, Category = "Maze")
+    USceneComponent* SceneRoot;
+
+    UPROPERTY(VisibleAnywhere, Category = "Maze")
+    UHierarchicalInstancedStaticMeshComponent* WallInstances;
+
+    UPROPERTY(VisibleAnywhere, Category = "Maze")
+    UMazeCollisionComponent* WallCollision;
+
+    FMazeGrid Grid;
+    FMazeFlowField FlowField;
+};